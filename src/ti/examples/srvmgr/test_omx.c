@@ -109,8 +109,9 @@ static RcmServer_FxnDesc OMXServerFxnAry[] = {
 //    {"RPC_SKEL_GetHandle"   , RPC_SKEL_GetHandle},  // Set at runtime.
     {"RPC_SKEL_GetHandle"   , NULL},
     {"RPC_SKEL_SetParameter", RPC_SKEL_SetParameter},
-    {"RPC_SKEL_GetParameter", RPC_SKEL_GetParameter},
-    {"fxnDouble", fxnDouble },
+    {"RPC_SKEL_GetParameter", RPC_SKEL_GetParameter,
+        RcmServer_FxnFlag_NONBLOCKING},
+    {"fxnDouble", fxnDouble, RcmServer_FxnFlag_NONBLOCKING},
 };
 
 #define OMXServerFxnAryLen (sizeof OMXServerFxnAry / sizeof OMXServerFxnAry[0])
@@ -243,6 +244,31 @@ Int main(Int argc, char* argv[])
      */
     ServiceMgr_init();
 
+#if CORE0
+    /* Let OMX calls pass host buffers by physical address. The host has
+     * filled in the physical address of each carveout by now. Of the
+     * device mappings only TILER holds buffers; the peripheral register
+     * spaces must never be reachable through a message pointer:
+     */
+    {
+        Int i;
+        Bool tiler;
+
+        for (i = 0; i < sizeof(resources) / sizeof(struct resource); i++) {
+            tiler = (resources[i].type == TYPE_DEVMEM) &&
+                ((resources[i].da_low == IPU_TILER_MODE_0_1) ||
+                (resources[i].da_low == IPU_TILER_MODE_2) ||
+                (resources[i].da_low == IPU_TILER_MODE_3));
+
+            if (((resources[i].type == TYPE_CARVEOUT) || tiler) &&
+                (resources[i].pa_low != 0)) {
+                RcmServer_addMemRegion(resources[i].pa_low,
+                    resources[i].da_low, resources[i].len);
+            }
+        }
+    }
+#endif
+
     /* initialize RcmServer create params */
     RcmServer_Params_init(&rcmServerParams);
 
@@ -45,6 +45,7 @@
 #include <xdc/runtime/Assert.h>
 #include <xdc/runtime/Diags.h>
 #include <xdc/runtime/Error.h>
+#include <xdc/runtime/Gate.h>
 #include <xdc/runtime/IHeap.h>
 #include <xdc/runtime/Log.h>
 #include <xdc/runtime/Memory.h>
@@ -57,10 +58,9 @@
 #include <xdc/runtime/knl/ISemaphore.h>
 
 /* package header files */
-#include <ti/ipc/MessageQ.h>
-
 #if defined(RCM_ti_ipc)
 #include <ti/sdo/utils/List.h>
+#include <ti/ipc/MultiProc.h>
 
 #elif defined(RCM_ti_syslink)
 #include <ti/syslink/utils/List.h>
@@ -70,31 +70,66 @@
 #endif
 
 /* local header files */
-#include <ti/rcm/RcmServer.h>
 #include "RcmTypes.h"
 #include "RcmClient.h"
+#include "RcmServer.h"
+
+#if USE_MESSAGEQCOPY
+#include <ti/srvmgr/rpmsg_omx.h>
+
+/* well-known ServiceMgr endpoint, must match ServiceMgr.c */
+#define RcmClient_SERVICEMGR_PORT 60
+
+/* every packet buffer holds the largest message the transport carries */
+#define RcmClient_PKTSIZE MSGBUFFERSIZE
+#define RcmClient_MAXDATASIZE (PACKET_MAXSIZE - PACKET_HDR_SIZE)
+#endif
+
+/* size of the wait and mail tables, must be a power of two */
+#define RcmClient_HASHLEN 32
+#define RcmClient_hash(msgId) ((msgId) & (RcmClient_HASHLEN - 1))
 
-/* recipient list element structure */
-typedef struct {
-    List_Elem elem;
+/* waiting recipient, lives on the waiting thread's stack */
+typedef struct Recipient_tag {
+    struct Recipient_tag *next;         // next in wait table bucket
     UInt16 msgId;
-    RcmClient_Message *msg;
+    Bool signaled;                      // woken to take the mailman role
+    RcmClient_Message *msg;             // delivered message
     SemThread_Struct event;
 } Recipient;
 
 typedef struct RcmClient_Object_tag {
     GateThread_Struct   gate;           // instance gate
+#if USE_MESSAGEQCOPY
+    MessageQCopy_Handle msgQue;         // return message endpoint
+    MessageQCopy_Handle errorMsgQue;    // error message endpoint
+#else
     MessageQ_Handle     msgQue;         // message queue
     MessageQ_Handle     errorMsgQue;    // error message queue
+#endif
     UInt16              heapId;         // heap used for message allocation
     Ptr                 sync;           // synchronizer for message queue
     UInt32              serverMsgQ;     // server message queue
     Bool                cbNotify;       // callback notification
     UInt16              msgId;          // last used message id
-    ISemaphore_Handle   mbxLock;        // mailbox lock
-    ISemaphore_Handle   queueLock;      // message queue lock
-    List_Handle         recipients;     // list of waiting recipients
-    List_Handle         newMail;        // list of undelivered messages
+    Bool                mailman;        // a thread is receiving replies
+    UInt                numWaiters;     // recipients in the wait table
+    Recipient **        waitTab;        // waiting recipients by msgId
+    List_Elem **        mailTab;        // undelivered messages by msgId
+    ISemaphore_Handle   window;         // free pipeline slots
+    ISemaphore_Handle   doneEvent;      // wakes waiting harvesters
+    List_Elem *         doneHead;       // completed pipelined messages
+    List_Elem *         doneTail;
+    UInt                numHarvesters;  // harvesters waiting on doneEvent
+#if USE_MESSAGEQCOPY
+    UInt16              dstProc;        // server processor
+    UInt32              msgQueAddr;     // return message endpoint address
+    UInt32              errorQueAddr;   // error message endpoint address
+    Bool                connected;      // server bound through ServiceMgr
+    Ptr                 pktBlock;       // packet cache buffers
+    UInt                pktCount;       // number of packet cache buffers
+    List_Elem *         pktFree;        // free packet cache buffers
+#endif
 } RcmClient_Object;
 
 typedef struct RcmClient_Module_tag {
@@ -115,10 +150,12 @@ RcmClient_Packet *RcmClient_getPacketAddr_P(
         RcmClient_Message *     msg
     );
 
+#if USE_MESSAGEQCOPY == 0
 static inline
 RcmClient_Packet *getPacketAddrMsgqMsg(
         MessageQ_Msg            msg
     );
+#endif
 
 static inline
 RcmClient_Packet *getPacketAddrElem(
@@ -131,6 +168,68 @@ static Int RcmClient_getReturnMsg_P(
         RcmClient_Message **    returnMsg
     );
 
+static
+RcmClient_Packet *RcmClient_takeMail_I(
+        RcmClient_Object *      obj,
+        UInt16                  msgId
+    );
+
+static
+Void RcmClient_deliver_I(
+        RcmClient_Object *      obj,
+        RcmClient_Packet *      packet
+    );
+
+static
+Void RcmClient_passMailman_I(
+        RcmClient_Object *      obj
+    );
+
+static
+Int RcmClient_pollMail_P(
+        RcmClient_Object *      obj,
+        Bool                    wait
+    );
+
+static
+Int RcmClient_sendPacket_P(
+        RcmClient_Object *      obj,
+        RcmClient_Packet *      packet,
+        Bool                    errorQue
+    );
+
+static
+Int RcmClient_recvPacket_P(
+        RcmClient_Object *      obj,
+        Bool                    errorQue,
+        Bool                    wait,
+        RcmClient_Packet **     packetPtr
+    );
+
+#if USE_MESSAGEQCOPY
+static inline
+RcmClient_Packet *RcmClient_getPacket_I(
+        RcmClient_Object *      obj
+    );
+
+static inline
+Void RcmClient_putPacket_I(
+        RcmClient_Object *      obj,
+        RcmClient_Packet *      packet
+    );
+
+static
+Int RcmClient_connect_P(
+        RcmClient_Object *      obj,
+        String                  server
+    );
+
+static
+Void RcmClient_disconnect_P(
+        RcmClient_Object *      obj
+    );
+#endif
+
 static
 Int RcmClient_Instance_init(
         RcmClient_Object *              obj,
@@ -210,6 +309,12 @@ Void RcmClient_Params_init(RcmClient_Params *params)
 {
     params->heapId = RcmClient_INVALIDHEAPID;
     params->callbackNotification = FALSE;
+    params->window = 0;
+#if USE_MESSAGEQCOPY
+    params->remoteProc = MultiProc_getId("HOST");
+    params->serverAddr = RcmClient_INVALIDADDR;
+    params->pktCacheSize = 4;
+#endif
 }
 
 
@@ -311,11 +416,15 @@ Int RcmClient_Instance_init(RcmClient_Object *obj, String server,
         const RcmClient_Params *params)
 {
     Error_Block eb;
+#if USE_MESSAGEQCOPY == 0
     MessageQ_Params mqParams;
+#endif
     SyncSemThread_Params syncParams;
     SemThread_Params semParams;
     SemThread_Handle semHndl;
-    List_Params listP;
+#if USE_MESSAGEQCOPY
+    UInt i;
+#endif
     Int rval;
     Int status = RcmClient_S_SUCCESS;
 
@@ -328,13 +437,26 @@ Int RcmClient_Instance_init(RcmClient_Object *obj, String server,
     /* initialize instance data */
     obj->msgId = 0xFFFF;
     obj->sync = NULL;
+#if USE_MESSAGEQCOPY
+    obj->serverMsgQ = RcmClient_INVALIDADDR;
+    obj->connected = FALSE;
+    obj->pktBlock = NULL;
+    obj->pktCount = 0;
+    obj->pktFree = NULL;
+#else
     obj->serverMsgQ = MessageQ_INVALIDMESSAGEQ;
+#endif
     obj->msgQue = NULL;
     obj->errorMsgQue = NULL;
-    obj->mbxLock = NULL;
-    obj->queueLock = NULL;
-    obj->recipients = NULL;
-    obj->newMail = NULL;
+    obj->mailman = FALSE;
+    obj->numWaiters = 0;
+    obj->waitTab = NULL;
+    obj->mailTab = NULL;
+    obj->window = NULL;
+    obj->doneEvent = NULL;
+    obj->doneHead = NULL;
+    obj->doneTail = NULL;
+    obj->numHarvesters = 0;
 
     /* create the instance gate */
     GateThread_construct(&obj->gate, NULL, &eb);
@@ -354,6 +476,58 @@ Int RcmClient_Instance_init(RcmClient_Object *obj, String server,
         goto leave;
     }
 
+#if USE_MESSAGEQCOPY
+    /* allocate the packet cache, all packets are the same size */
+    if (params->pktCacheSize > 0) {
+        obj->pktBlock = xdc_runtime_Memory_alloc(RcmClient_Module_heap(),
+            params->pktCacheSize * RcmClient_PKTSIZE, sizeof(Ptr), &eb);
+
+        if (Error_check(&eb)) {
+            Log_error0(FXNN": could not allocate packet cache");
+            status = RcmClient_E_NOMEMORY;
+            goto leave;
+        }
+        obj->pktCount = params->pktCacheSize;
+
+        for (i = 0; i < obj->pktCount; i++) {
+            RcmClient_putPacket_I(obj, (RcmClient_Packet *)
+                ((Char *)obj->pktBlock + (i * RcmClient_PKTSIZE)));
+        }
+    }
+
+    /* create the endpoint for return messages */
+    obj->msgQue = MessageQCopy_create(MessageQCopy_ASSIGN_ANY,
+        &obj->msgQueAddr);
+
+    if (obj->msgQue == NULL) {
+        Log_error0(FXNN": could not create return message endpoint");
+        status = RcmClient_E_MSGQCREATEFAILED;
+        goto leave;
+    }
+
+    /* create the endpoint for error messages */
+    obj->errorMsgQue = MessageQCopy_create(MessageQCopy_ASSIGN_ANY,
+        &obj->errorQueAddr);
+
+    if (NULL == obj->errorMsgQue) {
+        Log_error0(FXNN": could not create error message endpoint");
+        status = RcmClient_E_MSGQCREATEFAILED;
+        goto leave;
+    }
+
+    /* use the given server endpoint, or connect to the server by name */
+    obj->dstProc = params->remoteProc;
+
+    if (params->serverAddr != RcmClient_INVALIDADDR) {
+        obj->serverMsgQ = params->serverAddr;
+        rval = RcmClient_S_SUCCESS;
+    }
+    else {
+        rval = RcmClient_connect_P(obj, server);
+    }
+
+    if (RcmClient_E_SERVERNOTFOUND == rval) {
+#else
     /* create the message queue for return messages */
     MessageQ_Params_init(&mqParams);
     obj->msgQue = MessageQ_create(NULL, &mqParams);
@@ -378,11 +552,12 @@ Int RcmClient_Instance_init(RcmClient_Object *obj, String server,
     rval = MessageQ_open(server, (MessageQ_QueueId *)(&obj->serverMsgQ));
 
     if (MessageQ_E_NOTFOUND == rval) {
+#endif
         Log_error1(FXNN": given server not found, server=0x%x", (IArg)server);
         status = RcmClient_E_SERVERNOTFOUND;
         goto leave;
     }
-    else if (status < 0) {
+    else if (rval < 0) {
         Log_error1(FXNN": could not open server message queue, server=0x%x",
             (IArg)server);
         status = RcmClient_E_MSGQOPENFAILED;
@@ -398,71 +573,58 @@ Int RcmClient_Instance_init(RcmClient_Object *obj, String server,
     }
 
     /* register the heapId used for message allocation */
+#if USE_MESSAGEQCOPY
+    /* packets come from the module heap, the transport copies them */
+    obj->heapId = params->heapId;
+#else
     if ((obj->heapId = params->heapId) == RcmClient_INVALIDHEAPID) {
         Log_error0(FXNN": must specify a heap id in create params");
         status = RcmClient_E_INVALIDHEAPID;
         goto leave;
     }
+#endif
 
-    /* create the mailbox lock */
-    SemThread_Params_init(&semParams);
-    semHndl = SemThread_create(1, &semParams, &eb);
-    if (Error_check(&eb)) {
-        status = RcmClient_E_FAIL;
-        goto leave;
-    }
-    obj->mbxLock = SemThread_Handle_upCast(semHndl);
+    /* create the wait table and the mail table */
+    obj->waitTab = (Recipient **)xdc_runtime_Memory_calloc(
+        RcmClient_Module_heap(), RcmClient_HASHLEN * sizeof(Recipient *),
+        sizeof(Ptr), &eb);
 
-    /* create the message queue lock */
-    SemThread_Params_init(&semParams);
-    semHndl = SemThread_create(1, &semParams, &eb);
     if (Error_check(&eb)) {
-        status = RcmClient_E_FAIL;
+        Log_error0(FXNN": could not create wait table");
+        status = RcmClient_E_NOMEMORY;
         goto leave;
     }
-    obj->queueLock = SemThread_Handle_upCast(semHndl);
 
-    /* create the return message recipient list */
-#if defined(RCM_ti_ipc)
-    List_Params_init(&listP);
-    obj->recipients = List_create(&listP, &eb);
+    obj->mailTab = (List_Elem **)xdc_runtime_Memory_calloc(
+        RcmClient_Module_heap(), RcmClient_HASHLEN * sizeof(List_Elem *),
+        sizeof(Ptr), &eb);
 
     if (Error_check(&eb)) {
-        Log_error0(FXNN": could not create list object");
-        status = RcmClient_E_LISTCREATEFAILED;
-        goto leave;
-    }
-#elif defined(RCM_ti_syslink)
-    List_Params_init(&listP);
-    obj->recipients = List_create(&listP, NULL);
-
-    if (NULL == obj->recipients) {
-        Log_error0(FXNN": could not create list object");
-        status = RcmClient_E_LISTCREATEFAILED;
+        Log_error0(FXNN": could not create mail table");
+        status = RcmClient_E_NOMEMORY;
         goto leave;
     }
-#endif
-
-    /* create list of undelivered messages (new mail) */
-#if defined(RCM_ti_ipc)
-    List_Params_init(&listP);
-    obj->newMail = List_create(&listP, &eb);
 
-    if (Error_check(&eb)) {
-        Log_error0(FXNN": could not create list object");
-        status = RcmClient_E_LISTCREATEFAILED;
-        goto leave;
-    }
-#elif defined(RCM_ti_syslink)
-    List_Params_init(&listP);
-    obj->newMail = List_create(&listP, NULL);
+    /* create the pipeline window, one count per message in flight */
+    if (params->window > 0) {
+        SemThread_Params_init(&semParams);
+        semParams.mode = SemThread_Mode_COUNTING;
+        semHndl = SemThread_create(params->window, &semParams, &eb);
+        if (Error_check(&eb)) {
+            status = RcmClient_E_FAIL;
+            goto leave;
+        }
+        obj->window = SemThread_Handle_upCast(semHndl);
 
-    if (NULL == obj->newMail) {
-        Log_error0(FXNN": could not create list object");
-        status = RcmClient_E_LISTCREATEFAILED;
-        goto leave;
+        SemThread_Params_init(&semParams);
+        semParams.mode = SemThread_Mode_COUNTING;
+        semHndl = SemThread_create(0, &semParams, &eb);
+        if (Error_check(&eb)) {
+            status = RcmClient_E_FAIL;
+            goto leave;
+        }
+        obj->doneEvent = SemThread_Handle_upCast(semHndl);
     }
-#endif
 
 leave:
     Log_print2(Diags_EXIT, "<-- %s: %d", (IArg)FXNN, (IArg)status);
@@ -528,31 +690,71 @@ Int RcmClient_destruct(RcmClient_Struct *structPtr)
 Int RcmClient_Instance_finalize(RcmClient_Object *obj)
 {
     SemThread_Handle semH;
+    List_Elem *elem;
+    UInt i;
     Int status = RcmClient_S_SUCCESS;
 
 
     Log_print1(Diags_ENTRY, "--> "FXNN": (obj=0x%x)", (IArg)obj);
 
-    if (NULL != obj->newMail) {
-        List_delete(&obj->newMail);
+    /* free completed messages nobody harvested */
+    while ((elem = obj->doneHead) != NULL) {
+        obj->doneHead = elem->next;
+        RcmClient_free(obj, &getPacketAddrElem(elem)->message);
     }
 
-    if (NULL != obj->recipients) {
-        List_delete(&obj->recipients);
+    if (NULL != obj->doneEvent) {
+        semH = SemThread_Handle_downCast(obj->doneEvent);
+        SemThread_delete(&semH);
+        obj->doneEvent = NULL;
     }
 
-    if (NULL != obj->queueLock) {
-        semH = SemThread_Handle_downCast(obj->queueLock);
+    if (NULL != obj->window) {
+        semH = SemThread_Handle_downCast(obj->window);
         SemThread_delete(&semH);
-        obj->queueLock = NULL;
+        obj->window = NULL;
     }
 
-    if (NULL != obj->mbxLock) {
-        semH = SemThread_Handle_downCast(obj->mbxLock);
-        SemThread_delete(&semH);
-        obj->mbxLock = NULL;
+    if (NULL != obj->mailTab) {
+        /* free messages nobody picked up */
+        for (i = 0; i < RcmClient_HASHLEN; i++) {
+            while ((elem = obj->mailTab[i]) != NULL) {
+                obj->mailTab[i] = elem->next;
+                RcmClient_free(obj, &getPacketAddrElem(elem)->message);
+            }
+        }
+
+        xdc_runtime_Memory_free(RcmClient_Module_heap(), (Ptr)obj->mailTab,
+            RcmClient_HASHLEN * sizeof(List_Elem *));
+        obj->mailTab = NULL;
+    }
+
+    if (NULL != obj->waitTab) {
+        xdc_runtime_Memory_free(RcmClient_Module_heap(), (Ptr)obj->waitTab,
+            RcmClient_HASHLEN * sizeof(Recipient *));
+        obj->waitTab = NULL;
+    }
+
+#if USE_MESSAGEQCOPY
+    if (obj->connected) {
+        RcmClient_disconnect_P(obj);
+    }
+
+    if (NULL != obj->errorMsgQue) {
+        MessageQCopy_delete(&obj->errorMsgQue);
+    }
+
+    if (NULL != obj->msgQue) {
+        MessageQCopy_delete(&obj->msgQue);
     }
 
+    if (NULL != obj->pktBlock) {
+        xdc_runtime_Memory_free(RcmClient_Module_heap(), obj->pktBlock,
+            obj->pktCount * RcmClient_PKTSIZE);
+        obj->pktBlock = NULL;
+        obj->pktFree = NULL;
+    }
+#else
     if (MessageQ_INVALIDMESSAGEQ != obj->serverMsgQ) {
         MessageQ_close((MessageQ_QueueId *)(&obj->serverMsgQ));
     }
@@ -564,6 +766,7 @@ Int RcmClient_Instance_finalize(RcmClient_Object *obj)
     if (NULL != obj->msgQue) {
         MessageQ_delete(&obj->msgQue);
     }
+#endif
 
     if (NULL != obj->sync) {
         SyncSemThread_delete((SyncSemThread_Handle *)(&obj->sync));
@@ -586,7 +789,6 @@ Int RcmClient_acquireJobId(RcmClient_Object *obj, UInt16 *jobIdPtr)
 {
     RcmClient_Message *msg;
     RcmClient_Packet *packet;
-    MessageQ_Msg msgqMsg;
     UInt16 msgId;
     Int rval;
     UInt16 serverStatus;
@@ -608,12 +810,8 @@ Int RcmClient_acquireJobId(RcmClient_Object *obj, UInt16 *jobIdPtr)
     packet->desc |= RcmClient_Desc_JOB_ACQ << RcmClient_Desc_TYPE_SHIFT;
     msgId = packet->msgId;
 
-    /* set the return address to this instance's message queue */
-    msgqMsg = (MessageQ_Msg)packet;
-    MessageQ_setReplyQueue(obj->msgQue, msgqMsg);
-
     /* send the message to the server */
-    rval = MessageQ_put((MessageQ_QueueId)obj->serverMsgQ, msgqMsg);
+    rval = RcmClient_sendPacket_P(obj, packet, FALSE);
 
     if (rval < 0) {
         Log_error0(FXNN": unable to the send message to the server");
@@ -697,11 +895,25 @@ Int RcmClient_alloc(RcmClient_Object *obj, UInt32 dataSize,
     /* ensure minimum size of UInt32[1] */
     dataSize  = (dataSize < sizeof(UInt32) ? sizeof(UInt32) : dataSize);
 
+#if USE_MESSAGEQCOPY
+    /* the message must fit in one transport buffer */
+    if (dataSize > RcmClient_MAXDATASIZE) {
+        Log_error1(FXNN": data size too large for transport, size=%u",
+            (IArg)dataSize);
+        status = RcmClient_E_MSGALLOCFAILED;
+        goto leave;
+    }
+
+    /* every packet is the same size, replies are received into it */
+    totalSize = RcmClient_PKTSIZE;
+    packet = RcmClient_getPacket_I(obj);
+#else
     /* total memory size (in chars) needed for headers and payload */
     totalSize = sizeof(RcmClient_Packet) - sizeof(UInt32) + dataSize;
 
     /* allocate the message */
     packet = (RcmClient_Packet*)MessageQ_alloc(obj->heapId, totalSize);
+#endif
 
     if (NULL == packet) {
         Log_error1(FXNN": could not allocate message, size = %u",
@@ -751,7 +963,6 @@ Int RcmClient_checkForError(RcmClient_Object *obj, RcmClient_Message **rtnMsg)
 {
     RcmClient_Message *rcmMsg;
     RcmClient_Packet *packet;
-    MessageQ_Msg msgqMsg;
     UInt16 serverStatus;
     Int rval;
     Int status = RcmClient_S_SUCCESS;
@@ -763,19 +974,18 @@ Int RcmClient_checkForError(RcmClient_Object *obj, RcmClient_Message **rtnMsg)
     *rtnMsg = NULL;
 
     /* get error message if available (non-blocking) */
-    rval = MessageQ_get(obj->errorMsgQue, &msgqMsg, 0);
+    rval = RcmClient_recvPacket_P(obj, TRUE, FALSE, &packet);
 
-    if ((MessageQ_E_TIMEOUT != rval) && (rval < 0)) {
-        Log_error1(FXNN": MessageQ_get() returned error %d", (IArg)rval);
+    if (rval < 0) {
+        Log_error1(FXNN": receive returned error %d", (IArg)rval);
         status = RcmClient_E_IPCERROR;
         goto leave;
     }
-    else if (msgqMsg == NULL) {
+    else if (packet == NULL) {
         goto leave;
     }
 
     /* received an error message */
-    packet = getPacketAddrMsgqMsg(msgqMsg);
     rcmMsg = &packet->message;
     *rtnMsg = rcmMsg;
 
@@ -803,6 +1013,12 @@ Int RcmClient_checkForError(RcmClient_Object *obj, RcmClient_Message **rtnMsg)
             status = RcmClient_E_MSGFXNERROR;
             break;
 
+        case RcmServer_Status_Expired:
+            Log_error1(FXNN": message expired, fxnIdx=0x%x",
+                (IArg)rcmMsg->fxnIdx);
+            status = RcmClient_E_EXPIRED;
+            break;
+
         default:
             Log_error1(FXNN": server returned error %d", (IArg)serverStatus);
             status = RcmClient_E_SERVERERROR;
@@ -826,7 +1042,6 @@ Int RcmClient_exec(RcmClient_Object *obj,
 {
     RcmClient_Packet *packet;
     RcmClient_Message *rtnMsg;
-    MessageQ_Msg msgqMsg;
     UInt16 msgId;
     UInt16 serverStatus;
     Int rval;
@@ -841,12 +1056,8 @@ Int RcmClient_exec(RcmClient_Object *obj,
     packet->desc |= RcmClient_Desc_RCM_MSG << RcmClient_Desc_TYPE_SHIFT;
     msgId = packet->msgId;
 
-    /* set the return address to this instance's message queue */
-    msgqMsg = (MessageQ_Msg)packet;
-    MessageQ_setReplyQueue(obj->msgQue, msgqMsg);
-
     /* send the message to the server */
-    status = MessageQ_put((MessageQ_QueueId)obj->serverMsgQ, msgqMsg);
+    status = RcmClient_sendPacket_P(obj, packet, FALSE);
 
     if (status < 0) {
         Log_error0(FXNN": unable to the send message to the server");
@@ -884,6 +1095,12 @@ Int RcmClient_exec(RcmClient_Object *obj,
             status = RcmClient_E_MSGFXNERROR;
             goto leave;
 
+        case RcmServer_Status_Expired:
+            Log_error1(FXNN": message expired, fxnIdx=0x%x",
+                (IArg)rtnMsg->fxnIdx);
+            status = RcmClient_E_EXPIRED;
+            goto leave;
+
         default:
             Log_error1(FXNN": server returned error %d", (IArg)serverStatus);
             status = RcmClient_E_SERVERERROR;
@@ -905,7 +1122,6 @@ Int RcmClient_execAsync(RcmClient_Object *obj, RcmClient_Message *cmdMsg,
     RcmClient_CallbackFxn callback, Ptr appData)
 {
     RcmClient_Packet *packet;
-    MessageQ_Msg msgqMsg;
     Int rval;
     Int status = RcmClient_S_SUCCESS;
 
@@ -924,12 +1140,8 @@ Int RcmClient_execAsync(RcmClient_Object *obj, RcmClient_Message *cmdMsg,
     packet = RcmClient_getPacketAddr_P(cmdMsg);
     packet->desc |= RcmClient_Desc_RCM_MSG << RcmClient_Desc_TYPE_SHIFT;
 
-    /* set the return address to this instance's message queue */
-    msgqMsg = (MessageQ_Msg)packet;
-    MessageQ_setReplyQueue(obj->msgQue, msgqMsg);
-
     /* send the message to the server */
-    rval = MessageQ_put((MessageQ_QueueId)obj->serverMsgQ, msgqMsg);
+    rval = RcmClient_sendPacket_P(obj, packet, FALSE);
 
     if (rval < 0) {
         Log_error0(FXNN": unable to the send message to the server");
@@ -953,7 +1165,6 @@ leave:
 Int RcmClient_execCmd(RcmClient_Object *obj, RcmClient_Message *msg)
 {
     RcmClient_Packet *packet;
-    MessageQ_Msg msgqMsg;
     Int rval;
     Int status = RcmClient_S_SUCCESS;
 
@@ -965,12 +1176,8 @@ Int RcmClient_execCmd(RcmClient_Object *obj, RcmClient_Message *msg)
     packet = RcmClient_getPacketAddr_P(msg);
     packet->desc |= RcmClient_Desc_CMD << RcmClient_Desc_TYPE_SHIFT;
 
-    /* set the return address to the error message queue */
-    msgqMsg = (MessageQ_Msg)packet;
-    MessageQ_setReplyQueue(obj->errorMsgQue, msgqMsg);
-
-    /* send the message to the server */
-    rval = MessageQ_put((MessageQ_QueueId)obj->serverMsgQ, msgqMsg);
+    /* send the message to the server, errors return to the error queue */
+    rval = RcmClient_sendPacket_P(obj, packet, TRUE);
 
     if (rval < 0) {
         Log_error0(FXNN": unable to send message to server");
@@ -992,7 +1199,6 @@ Int RcmClient_execDpc(RcmClient_Object *obj,
 {
     RcmClient_Packet *packet;
     RcmClient_Message *rtnMsg;
-    MessageQ_Msg msgqMsg;
     UInt16 msgId;
     Int rval;
     Int status = RcmClient_S_SUCCESS;
@@ -1006,12 +1212,8 @@ Int RcmClient_execDpc(RcmClient_Object *obj,
     packet->desc |= RcmClient_Desc_DPC << RcmClient_Desc_TYPE_SHIFT;
     msgId = packet->msgId;
 
-    /* set the return address to this instance's message queue */
-    msgqMsg = (MessageQ_Msg)packet;
-    MessageQ_setReplyQueue(obj->msgQue, msgqMsg);
-
     /* send the message to the server */
-    rval = MessageQ_put((MessageQ_QueueId)obj->serverMsgQ, msgqMsg);
+    rval = RcmClient_sendPacket_P(obj, packet, FALSE);
 
     if (rval < 0) {
         /* Log_error() */
@@ -1046,7 +1248,6 @@ Int RcmClient_execNoWait(RcmClient_Object *obj, RcmClient_Message *cmdMsg,
     UInt16 *msgId)
 {
     RcmClient_Packet *packet;
-    MessageQ_Msg msgqMsg;
     Int rval;
     Int status = RcmClient_S_SUCCESS;
 
@@ -1060,14 +1261,10 @@ Int RcmClient_execNoWait(RcmClient_Object *obj, RcmClient_Message *cmdMsg,
     packet->desc |= RcmClient_Desc_RCM_MSG << RcmClient_Desc_TYPE_SHIFT;
     *msgId = packet->msgId;
 
-    /* set the return address to this instance's message queue */
-    msgqMsg = (MessageQ_Msg)packet;
-    MessageQ_setReplyQueue(obj->msgQue, msgqMsg);
-
     /* send the message to the server */
-    Log_print1(Diags_ANALYSIS, "%s: >>> MessageQ_put", (IArg)FXNN);
-    rval = MessageQ_put((MessageQ_QueueId)obj->serverMsgQ, msgqMsg);
-    Log_print1(Diags_ANALYSIS, "%s: <<< MessageQ_put", (IArg)FXNN);
+    Log_print1(Diags_ANALYSIS, "%s: >>> send", (IArg)FXNN);
+    rval = RcmClient_sendPacket_P(obj, packet, FALSE);
+    Log_print1(Diags_ANALYSIS, "%s: <<< send", (IArg)FXNN);
 
     if (rval < 0) {
         *msgId = RcmClient_INVALIDMSGID;
@@ -1090,15 +1287,18 @@ leave:
 Int RcmClient_free(RcmClient_Object *obj, RcmClient_Message *msg)
 {
     Int rval;
-    MessageQ_Msg msgqMsg;
     Int status = RcmClient_S_SUCCESS;
 
 
     Log_print2(Diags_ENTRY,
         "--> "FXNN": (obj=0x%x, msg=0x%x)", (IArg)obj, (IArg)msg);
 
-    msgqMsg = (MessageQ_Msg)RcmClient_getPacketAddr_P(msg);
-    rval = MessageQ_free(msgqMsg);
+#if USE_MESSAGEQCOPY
+    RcmClient_putPacket_I(obj, RcmClient_getPacketAddr_P(msg));
+    rval = RcmClient_S_SUCCESS;
+#else
+    rval = MessageQ_free((MessageQ_Msg)RcmClient_getPacketAddr_P(msg));
+#endif
 
     if (rval < 0) {
         Log_error1(FXNN": ipc returned error %d", (IArg)rval);
@@ -1123,7 +1323,6 @@ Int RcmClient_getSymbolIndex(RcmClient_Object *obj, String name, UInt32 *index)
     SizeT len;
     RcmClient_Packet *packet;
     UInt16 msgId;
-    MessageQ_Msg msgqMsg;
     Int rval;
     UInt16 serverStatus;
     RcmClient_Message *rcmMsg = NULL;
@@ -1152,12 +1351,8 @@ Int RcmClient_getSymbolIndex(RcmClient_Object *obj, String name, UInt32 *index)
     packet->desc |= RcmClient_Desc_SYM_IDX << RcmClient_Desc_TYPE_SHIFT;
     msgId = packet->msgId;
 
-    /* set the return address to this instance's message queue */
-    msgqMsg = (MessageQ_Msg)packet;
-    MessageQ_setReplyQueue(obj->msgQue, msgqMsg);
-
     /* send the message to the server */
-    rval = MessageQ_put((MessageQ_QueueId)obj->serverMsgQ, msgqMsg);
+    rval = RcmClient_sendPacket_P(obj, packet, FALSE);
 
     if (rval < 0) {
         Log_error0(FXNN": unable to the send message to the server");
@@ -1207,6 +1402,86 @@ leave:
 #undef FXNN
 
 
+/*
+ *  ======== RcmClient_harvest ========
+ */
+#define FXNN "RcmClient_harvest"
+Int RcmClient_harvest(RcmClient_Object *obj, RcmClient_Message **msgs,
+    UInt maxCount, UInt *count)
+{
+    GateThread_Handle gateH;
+    List_Elem *elem;
+    IArg key;
+    Error_Block eb;
+    UInt n = 0;
+    Int status = RcmClient_S_SUCCESS;
+
+
+    Log_print3(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, msgs=0x%x, maxCount=%d)",
+        (IArg)obj, (IArg)msgs, (IArg)maxCount);
+
+    Error_init(&eb);
+    *count = 0;
+
+    if (NULL == obj->window) {
+        Log_error0(FXNN": pipelining not enabled");
+        status = RcmClient_E_EXECASYNCNOTENABLED;
+        goto leave;
+    }
+
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
+
+    /* wait for at least one completion */
+    while ((NULL == obj->doneHead) && (status >= 0)) {
+        if (!obj->mailman) {
+            /* take the mailman role, collect everything that has arrived */
+            obj->mailman = TRUE;
+            GateThread_leave(gateH, key);
+
+            status = RcmClient_pollMail_P(obj, TRUE);
+
+            key = GateThread_enter(gateH);
+            obj->mailman = FALSE;
+            RcmClient_passMailman_I(obj);
+        }
+        else {
+            /* the mailman posts doneEvent on delivery or when it quits */
+            obj->numHarvesters++;
+            GateThread_leave(gateH, key);
+            Semaphore_pend(obj->doneEvent, Semaphore_FOREVER, &eb);
+            key = GateThread_enter(gateH);
+        }
+    }
+
+    /* take the whole batch, up to maxCount */
+    while ((n < maxCount) && ((elem = obj->doneHead) != NULL)) {
+        obj->doneHead = elem->next;
+        msgs[n++] = &getPacketAddrElem(elem)->message;
+    }
+
+    GateThread_leave(gateH, key);
+
+    /* a receive error is reported once nothing is left to harvest */
+    if (n > 0) {
+        status = RcmClient_S_SUCCESS;
+    }
+
+    /* open the window for new submissions */
+    *count = n;
+
+    while (n-- > 0) {
+        Semaphore_post(obj->window, &eb);
+    }
+
+leave:
+    Log_print2(Diags_EXIT, "<-- %s: %d", (IArg)FXNN, (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
 /*
  *  ======== RcmClient_releaseJobId ========
  */
@@ -1215,7 +1490,6 @@ Int RcmClient_releaseJobId(RcmClient_Object *obj, UInt16 jobId)
 {
     RcmClient_Message *msg;
     RcmClient_Packet *packet;
-    MessageQ_Msg msgqMsg;
     UInt16 msgId;
     Int rval;
     UInt16 serverStatus;
@@ -1237,15 +1511,11 @@ Int RcmClient_releaseJobId(RcmClient_Object *obj, UInt16 jobId)
     packet->desc |= RcmClient_Desc_JOB_REL << RcmClient_Desc_TYPE_SHIFT;
     msgId = packet->msgId;
 
-    /* set the return address to this instance's message queue */
-    msgqMsg = (MessageQ_Msg)packet;
-    MessageQ_setReplyQueue(obj->msgQue, msgqMsg);
-
     /* marshal the job id into the message payload */
     *(UInt16 *)(&msg->data[0]) = jobId;
 
     /* send the message to the server */
-    rval = MessageQ_put((MessageQ_QueueId)obj->serverMsgQ, msgqMsg);
+    rval = RcmClient_sendPacket_P(obj, packet, FALSE);
 
     if (rval < 0) {
         Log_error0(FXNN": unable to the send message to the server");
@@ -1311,6 +1581,95 @@ Int RcmClient_removeSymbol(RcmClient_Object *obj, String name)
 #undef FXNN
 
 
+/*
+ *  ======== RcmClient_setTimeToLive ========
+ */
+#define FXNN "RcmClient_setTimeToLive"
+Int RcmClient_setTimeToLive(RcmClient_Object *obj, RcmClient_Message *msg,
+        UInt32 timeToLive)
+{
+    RcmClient_Packet *packet;
+    Int status = RcmClient_S_SUCCESS;
+
+
+    Log_print3(Diags_ENTRY, "--> %s: (obj=0x%x, msg=0x%x)",
+        (IArg)FXNN, (IArg)obj, (IArg)msg);
+
+    if (msg->dataSize < sizeof(UInt32)) {
+        Log_error1(FXNN": no room for a time-to-live, dataSize=%d",
+            (IArg)msg->dataSize);
+        status = RcmClient_E_INVALIDARG;
+        goto leave;
+    }
+
+    /* the last data word, it need not be aligned */
+    _memcpy((Void *)((Char *)msg->data + msg->dataSize - sizeof(UInt32)),
+        (Void *)&timeToLive, sizeof(UInt32));
+
+    /* mark the message as using the time-to-live protocol */
+    packet = RcmClient_getPacketAddr_P(msg);
+    packet->desc &= ~RcmClient_Desc_VER_MASK;
+    packet->desc |= RcmClient_PROTO_TTL;
+
+leave:
+    Log_print2(Diags_EXIT, "<-- %s: %d", (IArg)FXNN, (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmClient_submit ========
+ */
+#define FXNN "RcmClient_submit"
+Int RcmClient_submit(RcmClient_Object *obj, RcmClient_Message *cmdMsg,
+    UInt16 *msgId)
+{
+    RcmClient_Packet *packet;
+    Error_Block eb;
+    Int rval;
+    Int status = RcmClient_S_SUCCESS;
+
+
+    Log_print3(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, cmdMsg=0x%x, msgId=0x%x)",
+        (IArg)obj, (IArg)cmdMsg, (IArg)msgId);
+
+    Error_init(&eb);
+
+    if (NULL == obj->window) {
+        Log_error0(FXNN": pipelining not enabled");
+        status = RcmClient_E_EXECASYNCNOTENABLED;
+        goto leave;
+    }
+
+    /* wait for a free slot in the window */
+    Semaphore_pend(obj->window, Semaphore_FOREVER, &eb);
+
+    /* classify this message, the reply goes to the completion queue */
+    packet = RcmClient_getPacketAddr_P(cmdMsg);
+    packet->desc |= (RcmClient_Desc_RCM_MSG << RcmClient_Desc_TYPE_SHIFT) |
+        RcmClient_Desc_PIPE;
+    *msgId = packet->msgId;
+
+    /* send the message to the server */
+    rval = RcmClient_sendPacket_P(obj, packet, FALSE);
+
+    if (rval < 0) {
+        Semaphore_post(obj->window, &eb);
+        *msgId = RcmClient_INVALIDMSGID;
+        Log_error0(FXNN": unable to the send message to the server");
+        status = RcmClient_E_EXECFAILED;
+        goto leave;
+    }
+
+leave:
+    Log_print2(Diags_EXIT, "<-- %s: %d", (IArg)FXNN, (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
 /*
  *  ======== RcmClient_waitUntilDone ========
  */
@@ -1369,28 +1728,28 @@ UInt16 RcmClient_genMsgId_P(RcmClient_Object *obj)
  *  A thread safe algorithm for message delivery
  *
  *  This function is called to pickup a specified return message from
- *  the server. Messages are taken from the queue and either delivered
- *  to the mailbox if not the specified message or returned to the caller.
- *  The calling thread might take the role of mailman or simply wait
- *  on a list of recipients.
+ *  the server. One calling thread at a time takes the role of mailman
+ *  and receives from the queue; every other caller waits on its own
+ *  event in the wait table, hashed by message id. The mailman hands each
+ *  message it receives directly to its recipient, or keeps it in the
+ *  mail table (same hash) until the recipient arrives. When the mailman
+ *  gets its own message, it passes the role to a waiting recipient.
  *
- *  This algorithm guarantees that a waiting recipient is released as soon
- *  as his message arrives. All new unclaimed mail is placed in the mailbox
- *  until the recipient arrives to collect it. The messages can arrive in
- *  any order and will be processed as they arrive. Message delivery is never
- *  stalled waiting on an absent recipient.
+ *  The tables and the mailman flag are protected by the instance gate,
+ *  which is never held while blocking. A waiting recipient is released
+ *  as soon as its message arrives, and delivery is never stalled waiting
+ *  on an absent recipient.
  */
 #define FXNN "RcmClient_getReturnMsg_P"
 Int RcmClient_getReturnMsg_P(RcmClient_Object *obj, const UInt16 msgId,
     RcmClient_Message **returnMsg)
 {
-    List_Elem *elem;
-    Recipient *recipient;
+    GateThread_Handle gateH;
+    IArg key;
+    Recipient self;
+    Recipient **rp;
     RcmClient_Packet *packet;
-    Bool messageDelivered;
-    MessageQ_Msg msgqMsg = NULL;
-    Bool messageFound = FALSE;
-    Int queueLockAcquired = 0;
+    Bool eventReady = FALSE;
     Error_Block eb;
     Int rval;
     Int status = RcmClient_S_SUCCESS;
@@ -1402,231 +1761,248 @@ Int RcmClient_getReturnMsg_P(RcmClient_Object *obj, const UInt16 msgId,
 
     Error_init(&eb);
     *returnMsg = NULL;
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
 
     /* keep trying until message found */
-    while (!messageFound) {
+    while (NULL == *returnMsg) {
 
-        /* acquire the mailbox lock */
-        Semaphore_pend(obj->mbxLock, Semaphore_FOREVER, &eb);
-        if (Error_check(&eb)) {
-            /* TODO */
-            goto leave;
+        /* pickup the message if it is already in the mail table */
+        packet = RcmClient_takeMail_I(obj, msgId);
+
+        if (NULL != packet) {
+            *returnMsg = &packet->message;
         }
+        else if (!obj->mailman) {
+            /*
+             * mailman role
+             */
+            obj->mailman = TRUE;
+            GateThread_leave(gateH, key);
+
+            /* deliver new mail until message found */
+            while (TRUE) {
+                rval = RcmClient_recvPacket_P(obj, FALSE, TRUE, &packet);
+
+                if ((rval < 0) || (NULL == packet)) {
+                    Log_error0(FXNN": lost return message");
+                    status = RcmClient_E_LOSTMSG;
+                    break;
+                }
+                Log_print0(Diags_INFO, FXNN": return message received");
 
-        /* search new mail list for message */
-        elem = NULL;
-        while ((elem = List_next(obj->newMail, elem)) != NULL) {
-            packet = getPacketAddrElem(elem);
-            if (msgId == packet->msgId) {
-                List_remove(obj->newMail, elem);
-                *returnMsg = &packet->message;
-                messageFound = TRUE;
-                break;
+                if (msgId == packet->msgId) {
+                    break;
+                }
+
+                key = GateThread_enter(gateH);
+                RcmClient_deliver_I(obj, packet);
+                GateThread_leave(gateH, key);
             }
-        }
 
-        if (messageFound) {
-            /* release the mailbox lock */
-            Semaphore_post(obj->mbxLock, &eb);
-            if (Error_check(&eb)) {
-                /* TODO */
+            /* let a waiting recipient take over the queue */
+            key = GateThread_enter(gateH);
+            obj->mailman = FALSE;
+            RcmClient_passMailman_I(obj);
+
+            if (status < 0) {
+                break;
             }
+            *returnMsg = &packet->message;
         }
         else {
-            /* attempt the message queue lock */
-            queueLockAcquired = Semaphore_pend(obj->queueLock, 0, &eb);
-            if (Error_check(&eb)) {
-                /* TODO */
-                goto leave;
-            }
+            /* wait for the mailman to deliver, or to pass its role */
+            if (!eventReady) {
+                SemThread_construct(&self.event, 0, NULL, &eb);
 
-            if (1 == queueLockAcquired) {
-                /*
-                 * mailman role
-                 */
-
-                /* deliver new mail until message found */
-                while (!messageFound) {
-
-                    /* get message from queue if available (non-blocking) */
-                    if (NULL == msgqMsg) {
-                        rval = MessageQ_get(obj->msgQue, &msgqMsg, 0);
-
-                        if ((MessageQ_E_TIMEOUT != rval) && (rval < 0)) {
-                            Log_error0(FXNN": lost return message");
-                            status = RcmClient_E_LOSTMSG;
-                            goto leave;
-                        }
-                        Log_print0(Diags_INFO, FXNN": return message received");
-                    }
-
-                    while (NULL != msgqMsg) {
-
-                        /* check if message found */
-                        packet = getPacketAddrMsgqMsg(msgqMsg);
-                        messageFound = (msgId == packet->msgId);
-
-                        if (messageFound) {
-                            *returnMsg = &packet->message;
-
-                            /* search wait list for new mailman */
-                            elem = NULL;
-                            while ((elem =
-                                List_next(obj->recipients, elem)) != NULL) {
-                                recipient = (Recipient *)elem;
-                                if (NULL == recipient->msg) {
-                                    /* signal recipient's event */
-                                    SemThread_post(SemThread_handle(
-                                        &recipient->event), &eb);
-                                    break;
-                                }
-                            }
-
-                            /* release the message queue lock */
-                            Semaphore_post(obj->queueLock, &eb);
-                            if (Error_check(&eb)) {
-                                /* TODO */
-                            }
-
-                            /* release the mailbox lock */
-                            Semaphore_post(obj->mbxLock, &eb);
-                            if (Error_check(&eb)) {
-                                /* TODO */
-                            }
-
-                            break;
-                        }
-                        else {
-                            /*
-                             * deliver message to mailbox
-                             */
-
-                            /* search recipient list for message owner */
-                            elem = NULL;
-                            messageDelivered = FALSE;
-                            while ((elem =
-                                List_next(obj->recipients, elem)) != NULL) {
-                                recipient = (Recipient *)elem;
-                                if (recipient->msgId == packet->msgId) {
-                                    recipient->msg = &packet->message;
-                                    /* signal the recipient's event */
-                                    SemThread_post(SemThread_handle(
-                                        &recipient->event), &eb);
-                                    messageDelivered = TRUE;
-                                    break;
-                                }
-                            }
-
-                            /* add undelivered message to new mail list */
-                            if (!messageDelivered) {
-                                /* use the elem in the MessageQ header */
-                                elem = (List_Elem *)&packet->msgqHeader;
-                                List_put(obj->newMail, elem);
-                            }
-                        }
-
-                        /* get next message from queue if available */
-                        rval = MessageQ_get(obj->msgQue, &msgqMsg, 0);
-
-                        if ((MessageQ_E_TIMEOUT != rval) && (rval < 0)) {
-                            Log_error0(FXNN": lost return message");
-                            status = RcmClient_E_LOSTMSG;
-                            goto leave;
-                        }
-                        Log_print0(Diags_INFO, FXNN": return message received");
-                    }
-
-                    if (!messageFound) {
-                        /*
-                         * message queue empty
-                         */
-
-                        /* release the mailbox lock */
-                        Semaphore_post(obj->mbxLock, &eb);
-                        if (Error_check(&eb)) {
-                            /* TODO */
-                        }
-
-                        /* get next message, this blocks the thread */
-                        rval = MessageQ_get(obj->msgQue, &msgqMsg,
-                            MessageQ_FOREVER);
-
-                        if (rval < 0) {
-                            Log_error0(FXNN": lost return message");
-                            status = RcmClient_E_LOSTMSG;
-                            goto leave;
-                        }
-                        Log_print0(Diags_INFO, FXNN": return message received");
-
-                        if (msgqMsg == NULL) {
-                            Log_error0(FXNN": reply message has been lost");
-                            status = RcmClient_E_LOSTMSG;
-                            goto leave;
-                        }
-
-                        /* acquire the mailbox lock */
-                        Semaphore_pend(obj->mbxLock, Semaphore_FOREVER, &eb);
-                        if (Error_check(&eb)) {
-                            goto leave;  /* TODO */
-                        }
-                    }
+                if (Error_check(&eb)) {
+                    status = RcmClient_E_FAIL;
+                    break;
                 }
+                eventReady = TRUE;
+            }
+
+            self.msgId = msgId;
+            self.msg = NULL;
+            self.signaled = FALSE;
+            rp = &obj->waitTab[RcmClient_hash(msgId)];
+            self.next = *rp;
+            *rp = &self;
+            obj->numWaiters++;
+
+            GateThread_leave(gateH, key);
+            SemThread_pend(SemThread_handle(&self.event), Semaphore_FOREVER,
+                &eb);
+            key = GateThread_enter(gateH);
+
+            if (NULL != self.msg) {
+                /* the mailman removed us from the table */
+                *returnMsg = self.msg;
             }
             else {
-                /* construct recipient on local stack */
-                Recipient self;
-                self.msgId = msgId;
-                self.msg = NULL;
-                SemThread_construct(&self.event, 0, NULL, &eb);
-                if (Error_check(&eb)) {
-                    /* TODO */
+                /* take ourselves out of the table and try again */
+                for (rp = &obj->waitTab[RcmClient_hash(msgId)];
+                    *rp != &self; rp = &(*rp)->next) {
                 }
+                *rp = self.next;
+                obj->numWaiters--;
+            }
+        }
+    } /* while (NULL == *returnMsg) */
 
-                /* add recipient to wait list */
-                elem = &self.elem;
-                List_put(obj->recipients, elem);
+    GateThread_leave(gateH, key);
 
-                /* release the mailbox lock */
-                Semaphore_post(obj->mbxLock, &eb);
-                if (Error_check(&eb)) {
-                    /* TODO */
-                }
+    if (eventReady) {
+        SemThread_destruct(&self.event);
+    }
 
-                /* wait on event */
-                SemThread_pend(SemThread_handle(&self.event),
-                    Semaphore_FOREVER, &eb);
-                if (Error_check(&eb)) {
-                    /* TODO */
-                }
+    Log_print2(Diags_EXIT, "<-- %s: %d", (IArg)FXNN, (IArg)status);
+    return(status);
+}
+#undef FXNN
 
-                /* acquire the mailbox lock */
-                Semaphore_pend(obj->mbxLock, Semaphore_FOREVER, &eb);
-                if (Error_check(&eb)) {
-                    goto leave;  /* TODO */
-                }
 
-                if (NULL != self.msg) {
-                    /* pickup message */
-                    *returnMsg = self.msg;
-                    messageFound = TRUE;
-                }
+/*
+ *  ======== RcmClient_takeMail_I ========
+ *
+ *  Remove the given message from the mail table. Must be called from
+ *  within the instance gate.
+ */
+RcmClient_Packet *RcmClient_takeMail_I(RcmClient_Object *obj, UInt16 msgId)
+{
+    List_Elem **ep;
+    List_Elem *elem;
 
-                /* remove recipient from wait list */
-                List_remove(obj->recipients, elem);
-                SemThread_destruct(&self.event);
+    for (ep = &obj->mailTab[RcmClient_hash(msgId)]; *ep != NULL;
+        ep = &(*ep)->next) {
 
-                /* release the mailbox lock */
-                Semaphore_post(obj->mbxLock, &eb);
-                if (Error_check(&eb)) {
-                    /* TODO */
-                }
+        if (getPacketAddrElem(*ep)->msgId == msgId) {
+            elem = *ep;
+            *ep = elem->next;
+            return(getPacketAddrElem(elem));
+        }
+    }
+
+    return(NULL);
+}
+
+
+/*
+ *  ======== RcmClient_deliver_I ========
+ *
+ *  Hand a message to its waiting recipient, or keep it in the mail table
+ *  if the recipient has not arrived yet. Must be called from within the
+ *  instance gate.
+ */
+Void RcmClient_deliver_I(RcmClient_Object *obj, RcmClient_Packet *packet)
+{
+    Recipient **rp;
+    Recipient *recipient;
+    List_Elem *elem;
+    UInt b = RcmClient_hash(packet->msgId);
+
+    /* pipelined messages go to the completion queue, in arrival order */
+    if (packet->desc & RcmClient_Desc_PIPE) {
+        elem = (List_Elem *)packet;
+        elem->next = NULL;
+
+        if (obj->doneHead == NULL) {
+            obj->doneHead = elem;
+        }
+        else {
+            obj->doneTail->next = elem;
+        }
+        obj->doneTail = elem;
+
+        if (obj->numHarvesters > 0) {
+            obj->numHarvesters--;
+            Semaphore_post(obj->doneEvent, NULL);
+        }
+        return;
+    }
+
+    for (rp = &obj->waitTab[b]; *rp != NULL; rp = &(*rp)->next) {
+        recipient = *rp;
+
+        if (recipient->msgId == packet->msgId) {
+            *rp = recipient->next;
+            obj->numWaiters--;
+            recipient->msg = &packet->message;
+            SemThread_post(SemThread_handle(&recipient->event), NULL);
+            return;
+        }
+    }
+
+    /* use the list elem at the start of the packet as the chain link */
+    elem = (List_Elem *)packet;
+    elem->next = obj->mailTab[b];
+    obj->mailTab[b] = elem;
+}
+
+
+/*
+ *  ======== RcmClient_passMailman_I ========
+ *
+ *  Wake one waiting recipient, or else a waiting harvester, so it can
+ *  take the mailman role. Must be called from within the instance gate.
+ */
+Void RcmClient_passMailman_I(RcmClient_Object *obj)
+{
+    Recipient *recipient;
+    UInt i;
+
+    for (i = 0; (obj->numWaiters > 0) && (i < RcmClient_HASHLEN); i++) {
+        for (recipient = obj->waitTab[i]; recipient != NULL;
+            recipient = recipient->next) {
+
+            if (!recipient->signaled) {
+                recipient->signaled = TRUE;
+                SemThread_post(SemThread_handle(&recipient->event), NULL);
+                return;
             }
         }
-    } /* while (!messageFound) */
+    }
 
-leave:
-    Log_print2(Diags_EXIT, "<-- %s: %d", (IArg)FXNN, (IArg)status);
-    return(status);
+    if (obj->numHarvesters > 0) {
+        obj->numHarvesters--;
+        Semaphore_post(obj->doneEvent, NULL);
+    }
+}
+
+
+/*
+ *  ======== RcmClient_pollMail_P ========
+ *
+ *  Mailman for harvesters: receive one message (blocking if wait is
+ *  true), then everything else already queued, delivering each. The
+ *  caller must own the mailman role and must not hold the gate.
+ */
+#define FXNN "RcmClient_pollMail_P"
+Int RcmClient_pollMail_P(RcmClient_Object *obj, Bool wait)
+{
+    GateThread_Handle gateH = GateThread_handle(&obj->gate);
+    RcmClient_Packet *packet;
+    IArg key;
+    Int rval;
+
+    do {
+        rval = RcmClient_recvPacket_P(obj, FALSE, wait, &packet);
+
+        if (rval < 0) {
+            Log_error0(FXNN": lost return message");
+            return(RcmClient_E_LOSTMSG);
+        }
+
+        if (packet != NULL) {
+            key = GateThread_enter(gateH);
+            RcmClient_deliver_I(obj, packet);
+            GateThread_leave(gateH, key);
+        }
+
+        wait = FALSE;
+    } while (packet != NULL);
+
+    return(RcmClient_S_SUCCESS);
 }
 #undef FXNN
 
@@ -1641,6 +2017,7 @@ RcmClient_Packet *RcmClient_getPacketAddr_P(RcmClient_Message *msg)
 }
 
 
+#if USE_MESSAGEQCOPY == 0
 /*
  *  ======== getPacketAddrMsgqMsg ========
  */
@@ -1650,14 +2027,266 @@ RcmClient_Packet *getPacketAddrMsgqMsg(MessageQ_Msg msg)
     Int offset = (Int)&(((RcmClient_Packet *)0)->msgqHeader);
     return ((RcmClient_Packet *)((Char *)msg - offset));
 }
+#endif
 
 
 /*
  *  ======== getPacketAddrElem ========
+ *
+ *  The list element overlays the start of the packet (the MessageQ
+ *  header, or the reserved words of a MessageQCopy packet).
  */
 static inline
 RcmClient_Packet *getPacketAddrElem(List_Elem *elem)
 {
-    Int offset = (Int)&(((RcmClient_Packet *)0)->msgqHeader);
-    return ((RcmClient_Packet *)((Char *)elem - offset));
+    return ((RcmClient_Packet *)elem);
+}
+
+
+/*
+ *  ======== RcmClient_sendPacket_P ========
+ *
+ *  Send a packet to the server. The packet belongs to the server once
+ *  sent; with MessageQCopy the data is copied and the buffer is freed
+ *  here. The reply goes to the error queue if errorQue is true.
+ */
+#define FXNN "RcmClient_sendPacket_P"
+Int RcmClient_sendPacket_P(RcmClient_Object *obj, RcmClient_Packet *packet,
+        Bool errorQue)
+{
+    Int rval;
+
+#if USE_MESSAGEQCOPY
+    packet->hdr.type = OMX_RAW_MSG;
+    packet->hdr.flags = 0;
+    packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
+
+    rval = MessageQCopy_send(obj->dstProc, obj->serverMsgQ,
+        (errorQue ? obj->errorQueAddr : obj->msgQueAddr), (Ptr)&packet->hdr,
+        PACKET_HDR_SIZE + packet->message.dataSize);
+
+    if (rval >= 0) {
+        RcmClient_putPacket_I(obj, packet);
+    }
+#else
+    MessageQ_setReplyQueue((errorQue ? obj->errorMsgQue : obj->msgQue),
+        (MessageQ_Msg)packet);
+    rval = MessageQ_put((MessageQ_QueueId)obj->serverMsgQ,
+        (MessageQ_Msg)packet);
+#endif
+
+    if (rval < 0) {
+        Log_error1(FXNN": ipc returned error %d", (IArg)rval);
+    }
+
+    return(rval);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmClient_recvPacket_P ========
+ *
+ *  Receive the next packet from the return (or error) queue. Returns
+ *  success with a NULL packet if not waiting and none is available.
+ */
+#define FXNN "RcmClient_recvPacket_P"
+Int RcmClient_recvPacket_P(RcmClient_Object *obj, Bool errorQue, Bool wait,
+        RcmClient_Packet **packetPtr)
+{
+#if USE_MESSAGEQCOPY
+    RcmClient_Packet *packet;
+    UInt32 remote;
+    UInt16 len;
+#else
+    MessageQ_Msg msgqMsg = NULL;
+#endif
+    Int rval;
+
+
+    *packetPtr = NULL;
+
+#if USE_MESSAGEQCOPY
+    packet = RcmClient_getPacket_I(obj);
+
+    if (packet == NULL) {
+        Log_error0(FXNN": out of memory");
+        return(RcmClient_E_NOMEMORY);
+    }
+
+    rval = MessageQCopy_recv((errorQue ? obj->errorMsgQue : obj->msgQue),
+        (Ptr)&packet->hdr, &len, &remote,
+        (wait ? MessageQCopy_FOREVER : 0));
+
+    if (rval == MessageQCopy_S_SUCCESS) {
+        *packetPtr = packet;
+    }
+    else {
+        RcmClient_putPacket_I(obj, packet);
+        rval = (rval == MessageQCopy_E_TIMEOUT ? RcmClient_S_SUCCESS : rval);
+    }
+#else
+    rval = MessageQ_get((errorQue ? obj->errorMsgQue : obj->msgQue),
+        &msgqMsg, (wait ? MessageQ_FOREVER : 0));
+
+    if (msgqMsg != NULL) {
+        *packetPtr = getPacketAddrMsgqMsg(msgqMsg);
+    }
+    rval = (rval == MessageQ_E_TIMEOUT ? RcmClient_S_SUCCESS : rval);
+#endif
+
+    return(rval);
 }
+#undef FXNN
+
+
+#if USE_MESSAGEQCOPY
+/*
+ *  ======== RcmClient_getPacket_I ========
+ *
+ *  Take a packet from the instance cache, or from the heap when the
+ *  cache is empty.
+ */
+RcmClient_Packet *RcmClient_getPacket_I(RcmClient_Object *obj)
+{
+    Error_Block eb;
+    List_Elem *elem;
+    Ptr buf;
+    IArg key;
+
+    key = Gate_enterSystem();
+    elem = obj->pktFree;
+
+    if (elem != NULL) {
+        obj->pktFree = elem->next;
+    }
+    Gate_leaveSystem(key);
+
+    if (elem != NULL) {
+        return((RcmClient_Packet *)elem);
+    }
+
+    /* cache exhausted, fall back to the heap; failure is not fatal */
+    Error_init(&eb);
+    buf = xdc_runtime_Memory_alloc(RcmClient_Module_heap(),
+        RcmClient_PKTSIZE, sizeof(Ptr), &eb);
+
+    if (Error_check(&eb)) {
+        return(NULL);
+    }
+
+    return((RcmClient_Packet *)buf);
+}
+
+
+/*
+ *  ======== RcmClient_putPacket_I ========
+ *
+ *  Return a packet to the instance cache, or to the heap if it did not
+ *  come from the cache.
+ */
+Void RcmClient_putPacket_I(RcmClient_Object *obj, RcmClient_Packet *packet)
+{
+    List_Elem *elem = (List_Elem *)packet;
+    IArg key;
+
+    if (((Char *)packet >= (Char *)obj->pktBlock) && ((Char *)packet <
+        (Char *)obj->pktBlock + (obj->pktCount * RcmClient_PKTSIZE))) {
+
+        key = Gate_enterSystem();
+        elem->next = obj->pktFree;
+        obj->pktFree = elem;
+        Gate_leaveSystem(key);
+    }
+    else {
+        xdc_runtime_Memory_free(RcmClient_Module_heap(), (Ptr)packet,
+            RcmClient_PKTSIZE);
+    }
+}
+
+
+/*
+ *  ======== RcmClient_connect_P ========
+ *
+ *  Ask the ServiceMgr on the server processor for a new instance of the
+ *  named service and bind this client to its endpoint.
+ */
+#define FXNN "RcmClient_connect_P"
+Int RcmClient_connect_P(RcmClient_Object *obj, String server)
+{
+    Char msg[HDRSIZE + sizeof(struct omx_connect_req)];
+    struct omx_msg_hdr *hdr = (struct omx_msg_hdr *)msg;
+    struct omx_connect_req *req = (struct omx_connect_req *)hdr->data;
+    struct omx_connect_rsp *rsp = (struct omx_connect_rsp *)hdr->data;
+    UInt32 remote;
+    UInt16 len;
+    Int rval;
+    Int status = RcmClient_S_SUCCESS;
+
+
+    Log_print1(Diags_ENTRY, "--> "FXNN": (obj=0x%x)", (IArg)obj);
+
+    if (_strlen(server) >= sizeof(req->name)) {
+        Log_error1(FXNN": server name too long, server=0x%x", (IArg)server);
+        status = RcmClient_E_SERVERNOTFOUND;
+        goto leave;
+    }
+
+    hdr->type = OMX_CONN_REQ;
+    hdr->flags = 0;
+    hdr->len = sizeof(struct omx_connect_req);
+    _strcpy(req->name, server);
+
+    rval = MessageQCopy_send(obj->dstProc, RcmClient_SERVICEMGR_PORT,
+        obj->msgQueAddr, (Ptr)msg, HDRSIZE + hdr->len);
+
+    if (rval < 0) {
+        status = RcmClient_E_MSGQOPENFAILED;
+        goto leave;
+    }
+
+    /* the connect response is the first message on the new endpoint */
+    rval = MessageQCopy_recv(obj->msgQue, (Ptr)msg, &len, &remote,
+        MessageQCopy_FOREVER);
+
+    if ((rval < 0) || (hdr->type != OMX_CONN_RSP)) {
+        status = RcmClient_E_MSGQOPENFAILED;
+        goto leave;
+    }
+
+    if (rsp->status != OMX_SUCCESS) {
+        status = RcmClient_E_SERVERNOTFOUND;
+        goto leave;
+    }
+
+    obj->serverMsgQ = rsp->addr;
+    obj->connected = TRUE;
+
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmClient_disconnect_P ========
+ */
+Void RcmClient_disconnect_P(RcmClient_Object *obj)
+{
+    Char msg[HDRSIZE + sizeof(struct omx_disc_req)];
+    struct omx_msg_hdr *hdr = (struct omx_msg_hdr *)msg;
+    struct omx_disc_req *req = (struct omx_disc_req *)hdr->data;
+
+    hdr->type = OMX_DISC_REQ;
+    hdr->flags = 0;
+    hdr->len = sizeof(struct omx_disc_req);
+    req->addr = obj->serverMsgQ;
+
+    /* no response expected */
+    MessageQCopy_send(obj->dstProc, RcmClient_SERVICEMGR_PORT,
+        obj->msgQueAddr, (Ptr)msg, HDRSIZE + hdr->len);
+
+    obj->connected = FALSE;
+}
+#endif
@@ -392,6 +392,20 @@ extern "C" {
  */
 #define RcmClient_E_JOBIDNOTFOUND (-17)
 
+/*!
+ *  @brief The message expired on the server
+ *
+ *  The server did not start executing the message within the time-to-live
+ *  set with RcmClient_setTimeToLive(), so it returned the message
+ *  unexecuted.
+ */
+#define RcmClient_E_EXPIRED (-18)
+
+/*!
+ *  @brief An argument is not valid
+ */
+#define RcmClient_E_INVALIDARG (-19)
+
 
 // -------- constants and types --------
 
@@ -405,6 +419,11 @@ extern "C" {
  */
 #define RcmClient_INVALIDHEAPID ((UInt16)(0xFFFF))
 
+/*!
+ *  @brief Invalid server endpoint address
+ */
+#define RcmClient_INVALIDADDR ((UInt32)(0xFFFFFFFF))
+
 /*!
  *  @brief Invalid message id
  */
@@ -523,6 +542,48 @@ typedef struct {
      */
     Bool callbackNotification;
 
+    /*!
+     *  @brief Pipelined submission window
+     *
+     *  The maximum number of messages submitted with RcmClient_submit()
+     *  that may be in flight at once. RcmClient_submit() blocks while the
+     *  window is full; each message collected with RcmClient_harvest()
+     *  frees one slot.
+     *
+     *  When set to 0 (the default), pipelined submission is disabled.
+     */
+    UInt16 window;
+
+#if USE_MESSAGEQCOPY
+    /*!
+     *  @brief Processor the server runs on
+     *
+     *  Messages are sent to this processor over the MessageQCopy
+     *  transport. The default is the host processor.
+     */
+    UInt16 remoteProc;
+
+    /*!
+     *  @brief Endpoint address of the server
+     *
+     *  When set to RcmClient_INVALIDADDR (the default), the client asks
+     *  the ServiceMgr on the remote processor to create an instance of
+     *  the named server and sends its messages to the new instance. The
+     *  instance is released when the client is deleted.
+     */
+    UInt32 serverAddr;
+
+    /*!
+     *  @brief Number of packets in the instance packet cache
+     *
+     *  Messages and reply buffers are taken from a per-instance cache
+     *  of fixed-size packets, allocated once at create time. When the
+     *  cache is empty, packets come from the module heap. Set to 0 to
+     *  always use the heap.
+     */
+    UInt16 pktCacheSize;
+#endif
+
 } RcmClient_Params;
 
 /*!
@@ -541,10 +602,24 @@ typedef struct {
     UInt32              _f6;
     Bool                _f7;
     UInt16              _f8;
-    Ptr                 _f9;
-    Ptr                 _f10;
+    Bool                _f9;
+    UInt                _f10;
     Ptr                 _f11;
     Ptr                 _f12;
+    Ptr                 _f13;
+    Ptr                 _f14;
+    Ptr                 _f15;
+    Ptr                 _f16;
+    UInt                _f17;
+#if USE_MESSAGEQCOPY
+    UInt16              _f18;
+    UInt32              _f19;
+    UInt32              _f20;
+    Bool                _f21;
+    Ptr                 _f22;
+    UInt                _f23;
+    Ptr                 _f24;
+#endif
 } RcmClient_Struct;
 
 
@@ -983,6 +1058,42 @@ Int RcmClient_getSymbolIndex(
         UInt32 *                index
     );
 
+/*
+ *  ======== RcmClient_harvest ========
+ */
+/*!
+ *  @brief Collect completed pipelined messages
+ *
+ *  Blocks until at least one message submitted with RcmClient_submit()
+ *  has completed, then returns all completed messages, up to maxCount,
+ *  in the order their replies arrived. Each returned message frees one
+ *  slot in the submission window. The caller must free each message
+ *  with RcmClient_free().
+ *
+ *  Use the msgId field of the packet, as returned by RcmClient_submit(),
+ *  or the message contents to match completions to submissions. The
+ *  server status of each message is not checked here; see
+ *  RcmClient_exec() for the status values.
+ *
+ *  @param[in] handle Handle to an instance object
+ *
+ *  @param[out] msgs Array of at least maxCount message pointers.
+ *
+ *  @param[in] maxCount Maximum number of messages to return.
+ *
+ *  @param[out] count Number of messages returned.
+ *
+ *  @retval RcmClient_S_SUCCESS
+ *  @retval RcmClient_E_EXECASYNCNOTENABLED
+ *  @retval RcmClient_E_LOSTMSG
+ */
+Int RcmClient_harvest(
+        RcmClient_Handle        handle,
+        RcmClient_Message **    msgs,
+        UInt                    maxCount,
+        UInt *                  count
+    );
+
 /*
  *  ======== RcmClient_init ========
  */
@@ -1038,6 +1149,68 @@ Int RcmClient_removeSymbol(
         String                  name
     );
 
+/*
+ *  ======== RcmClient_setTimeToLive ========
+ */
+/*!
+ *  @brief Give a message a time-to-live
+ *
+ *  If the server has not started executing the message this long after
+ *  receiving it, it returns the message unexecuted and the call fails
+ *  with RcmClient_E_EXPIRED. Set this to the time the client is still
+ *  willing to wait, so that a busy server does not spend time on calls
+ *  nobody is waiting for.
+ *
+ *  The time-to-live travels in the last four bytes of the data buffer,
+ *  so allocate the message four bytes larger than the function needs.
+ *  The server removes it before the call, the remote function sees a
+ *  dataSize four bytes smaller. Only the MessageQCopy transport honors
+ *  it. Messages without a time-to-live are not affected.
+ *
+ *  @param[in] handle Handle to an instance object
+ *
+ *  @param[in] msg A pointer to an RcmClient_Message structure.
+ *
+ *  @param[in] timeToLive Time-to-live in microseconds, zero for no limit.
+ *
+ *  @retval RcmClient_S_SUCCESS
+ *  @retval RcmClient_E_INVALIDARG The data buffer has no room for it
+ */
+Int RcmClient_setTimeToLive(
+        RcmClient_Handle        handle,
+        RcmClient_Message *     msg,
+        UInt32                  timeToLive
+    );
+
+/*
+ *  ======== RcmClient_submit ========
+ */
+/*!
+ *  @brief Submit a message to a pipeline of outstanding calls
+ *
+ *  Like RcmClient_execNoWait(), but the return message is collected with
+ *  RcmClient_harvest() instead of RcmClient_waitUntilDone(). The number
+ *  of submitted messages not yet harvested is limited by the window
+ *  create param; this call blocks while the window is full. Upon
+ *  returning from this function, the ownership of the message has been
+ *  lost.
+ *
+ *  @param[in] handle Handle to an instance object
+ *
+ *  @param[in] cmdMsg A pointer to an RcmClient_Message structure.
+ *
+ *  @param[out] msgId The message id of the submitted message.
+ *
+ *  @retval RcmClient_S_SUCCESS
+ *  @retval RcmClient_E_EXECASYNCNOTENABLED
+ *  @retval RcmClient_E_EXECFAILED
+ */
+Int RcmClient_submit(
+        RcmClient_Handle        handle,
+        RcmClient_Message *     cmdMsg,
+        UInt16 *                msgId
+    );
+
 /*
  *  ======== RcmClient_waitUntilDone ========
  */
@@ -46,11 +46,13 @@
 #include <xdc/runtime/Assert.h>
 #include <xdc/runtime/Diags.h>
 #include <xdc/runtime/Error.h>
+#include <xdc/runtime/Gate.h>
 #include <xdc/runtime/IHeap.h>
 #include <xdc/runtime/Log.h>
 #include <xdc/runtime/Memory.h>
 #include <xdc/runtime/Registry.h>
 #include <xdc/runtime/Startup.h>
+#include <xdc/runtime/Timestamp.h>
 #include <xdc/runtime/knl/GateThread.h>
 #include <xdc/runtime/knl/ISemaphore.h>
 #include <xdc/runtime/knl/Semaphore.h>
@@ -58,8 +60,6 @@
 #include <xdc/runtime/knl/Thread.h>
 #include <xdc/runtime/System.h>
 
-#define MSGBUFFERSIZE    512   // Make global and move to MessageQCopy.h
-
 #if defined(RCM_ti_ipc)
 #include <ti/sdo/utils/List.h>
 #include <ti/ipc/MultiProc.h>
@@ -79,7 +79,9 @@
 #include "RcmServer.h"
 
 #if USE_MESSAGEQCOPY
+#include <ti/sysbios/hal/Cache.h>
 #include <ti/srvmgr/rpmsg_omx.h>
+#include <ti/ipc/rpmsg/EventLog.h>
 #endif
 
 #define _RCM_KeyResetValue 0x07FF       // key reset value
@@ -88,13 +90,38 @@
 
 #define RcmServer_MAX_TABLES 9          // max number of function tables
 #define RcmServer_POOL_MAP_LEN 4        // pool map length
+#define RcmServer_PKT_POOL_EXTRA 4      // packets beyond one per worker
+                                        // thread a pool may grow to
+#define RcmServer_JOB_TAB_LEN 32        // job table buckets (power of 2)
+#define RcmServer_SYM_TAB_LEN 128       // symbol index buckets (power of 2)
+#define RcmServer_SYM_NONE 0xFFFFFFFF   // end of symbol hash chain
+#define RcmServer_SLOT_NONE 0xFFFF      // end of free slot list
+#define RcmServer_NAME_CHUNK 512        // name arena chunk size
+
+#define RcmServer_jobBucket(id) ((id) & (RcmServer_JOB_TAB_LEN - 1))
+
+#define RcmServer_POOL_BUSY 0xFFFF      // pool slot reserved, not reachable
+#define RcmServer_GROW_POLL 1000        // usec between checks for a growing pool
+
+#define RcmServer_PKT_FREE 0            // packet state: free
+#define RcmServer_PKT_QUEUED 1          // packet state: waiting on a queue
+#define RcmServer_PKT_RUNNING 2         // packet state: being processed
+#define RcmServer_PKT_CANCELLED 3       // packet state: skip when dequeued
+
+#define RcmServer_blockPkt(blk, i) \
+    ((RcmClient_Packet *)((Char *)((blk) + 1) + ((i) * MSGBUFFERSIZE)))
+
+#define RcmServer_poolTabLen(i) (1 << ((i) + 2)) // dynamic pool table length
+
+#define RcmServer_MAX_MEMREGIONS 16     // host memory regions for pointers
 
 #define RcmServer_E_InvalidFxnIdx       (-101)
 #define RcmServer_E_JobIdNotFound       (-102)
 #define RcmServer_E_PoolIdNotFound      (-103)
+#define RcmServer_E_InvalidPtrArg       (-104)
+#define RcmServer_E_Expired             (-105)
 
-typedef struct {                        // function table element
-    String                      name;
+typedef struct {                        // function table element (hot)
 #if USE_MESSAGEQCOPY
     union  {
        RcmServer_MsgFxn         fxn;
@@ -104,8 +131,21 @@ typedef struct {                        // function table element
     RcmServer_MsgFxn            addr;
 #endif
     UInt16                      key;
+    UInt16                      flags;      // RcmServer_FxnFlag bits
 } RcmServer_FxnTabElem;
 
+typedef struct {                        // function table element (cold)
+    String                      name;
+    UInt32                      symNext;    // hash chain, or free list link
+    RcmServer_FxnStats          stats;      // execution statistics
+} RcmServer_FxnTabInfo;
+
+typedef struct RcmServer_NameChunk_tag {  // name arena chunk
+    struct RcmServer_NameChunk_tag * next;
+    SizeT                       size;       // bytes of name storage
+    SizeT                       used;       // bytes handed out
+} RcmServer_NameChunk;
+
 typedef struct {
     Int                         length;
     RcmServer_FxnTabElem *      elem;
@@ -120,29 +160,69 @@ typedef struct {
     String                      stackSeg;   // thread stack placement
     ISemaphore_Handle           sem;        // message semaphore (counting)
     List_Struct                 threadList; // list of worker threads
-    List_Struct                 readyQueue; // queue of messages
+    List_Struct                 readyQueue[RcmClient_Desc_NUMPRI]; // by pri
+    Int                         maxOsPriority; // limit for raised workers
+    UInt16                      key;        // dynamic pool key, 0 = unused
+    UInt                        maxCount;   // elastic pool thread limit
+    UInt                        growDepth;  // queue depth to add a thread
+    UInt                        idleTimeout;// usec before extra thread exits
+    UInt                        live;       // current thread count
+    UInt                        queued;     // ready queue depth (elastic)
+    Bool                        growing;    // a thread is being added
+    List_Struct                 retired;    // exited threads to reclaim
+    UInt                        pktShare;   // packets added for this pool
 } RcmServer_ThreadPool;
 
+#define RcmServer_isElastic(pool) ((pool)->maxCount > (pool)->count)
+
+#define RcmServer_poolPkts(pool) \
+    (RcmServer_isElastic(pool) ? (pool)->maxCount : (UInt)(pool)->count)
+
+typedef struct RcmServer_PktBlock_tag {   // packet buffers, the packets
+    struct RcmServer_PktBlock_tag * next;   // follow the block header
+    UInt                        count;      // packets in this block
+} RcmServer_PktBlock;
+
+#define RcmServer_pktPri(pkt) \
+    (((pkt)->desc & RcmClient_Desc_PRI_MASK) >> RcmClient_Desc_PRI_SHIFT)
+
 typedef struct RcmServer_Object_tag {
     GateThread_Struct           gate;       // instance gate
     Ptr                         run;        // run semaphore for the server
 #if USE_MESSAGEQCOPY
     MessageQCopy_Handle         serverQue;  // inbound message queue
     UInt32                      localAddr;  // inbound message queue address
-    UInt32                      replyAddr;  // Reply address (same per inst.)
-    UInt32                      dstProc;    // Reply processor.
+    UInt32                      replyAddr;  // source of the last request
+    UInt32                      dstProc;    // source proc of the last request
 #else
     MessageQ_Handle             serverQue;  // inbound message queue
 #endif
     Thread_Handle               serverThread; // server thread object
     RcmServer_FxnTabElemAry     fxnTabStatic; // static function table
     RcmServer_FxnTabElem *      fxnTab[RcmServer_MAX_TABLES]; // base pointers
+    RcmServer_FxnTabInfo *      fxnInfo[RcmServer_MAX_TABLES]; // cold data
+    UInt16                      fxnFree[RcmServer_MAX_TABLES]; // free slots
+    UInt32 *                    symTab;     // name hash to fxnIdx chain
+    RcmServer_NameChunk *       nameArena;  // dynamic symbol names
+    UInt                        nameLive;   // names in use in the arena
     UInt16                      key;        // function index key
     UInt16                      jobId;      // job id tracker
+    UInt16                      poolKey;    // dynamic pool key tracker
     Bool                        shutdown;   // server shutdown flag
     Int                         poolMap0Len;// length of static table
     RcmServer_ThreadPool *      poolMap[RcmServer_POOL_MAP_LEN];
-    List_Handle                 jobList;    // list of job stream queues
+    struct RcmServer_JobStream_tag ** jobTab; // job stream hash table
+    UInt32                      latHist[RcmServer_NUMLATSTAGES]
+                                       [RcmServer_NUMLATBUCKETS];
+#if USE_MESSAGEQCOPY
+    RcmServer_PktBlock *        pktBlock;   // packet pool buffers
+    UInt                        pktCount;   // number of packet buffers
+    UInt                        pktSpare;   // packets left by deleted pools
+    Bool                        pktAuto;    // grow the packets with the pools
+    List_Handle                 pktList;    // free packet buffers
+    Ptr                         pktSem;     // free packet count
+    UInt                        replyBatch; // max worker replies per kick
+#endif
 } RcmServer_Object;
 
 typedef struct {
@@ -154,16 +234,26 @@ typedef struct {
     RcmServer_Object *          server;     // server instance
 } RcmServer_WorkerThread;
 
-typedef struct {
-    List_Elem                   elem;
+typedef struct RcmServer_JobStream_tag {
+    struct RcmServer_JobStream_tag * next;  // next in hash bucket
     UInt16                      jobId;      // job stream id
     Bool                        empty;      // true if no messages on server
     List_Struct                 msgQue;     // queue of messages
 } RcmServer_JobStream;
 
+typedef struct {                        // host memory region
+    UInt32              pa;             // host physical address
+    UInt32              da;             // device address
+    UInt32              size;           // region size in bytes
+} RcmServer_MemRegion;
+
 typedef struct RcmServer_Module_tag {
     String              name;
     IHeap_Handle        heap;
+#if USE_MESSAGEQCOPY
+    UInt                memMapLen;      // number of regions in use
+    RcmServer_MemRegion memMap[RcmServer_MAX_MEMREGIONS];
+#endif
 } RcmServer_Module;
 
 
@@ -180,6 +270,46 @@ Int RcmServer_Instance_finalize_P(
         RcmServer_Object *              obj
     );
 
+static
+Int RcmServer_addWorker_P(
+        RcmServer_Object *              obj,
+        RcmServer_ThreadPool *          pool
+    );
+
+static
+Bool RcmServer_enqueue_P(
+        RcmServer_Object *              obj,
+        RcmServer_ThreadPool *          pool,
+        RcmClient_Packet *              packet
+    );
+
+static
+Void RcmServer_growPool_P(
+        RcmServer_Object *              obj,
+        RcmServer_ThreadPool *          pool
+    );
+
+static
+Void RcmServer_reapWorkers_P(
+        RcmServer_ThreadPool *          pool
+    );
+
+static inline
+RcmClient_Packet *RcmServer_getReady_I(
+        RcmServer_ThreadPool *          pool
+    );
+
+static
+Bool RcmServer_retireWorker_P(
+        RcmServer_WorkerThread *        worker
+    );
+
+static
+Int RcmServer_finalizePool_P(
+        RcmServer_Object *              obj,
+        RcmServer_ThreadPool *          pool
+    );
+
 static
 Int RcmServer_acqJobId_P(
         RcmServer_Object *              obj,
@@ -192,18 +322,68 @@ Int RcmServer_dispatch_P(
         RcmClient_Packet *              packet
     );
 
+static
+Int RcmServer_execFxn_I(
+        RcmServer_Object *              obj,
+        UInt32                          fxnIdx,
+        UInt32                          dataSize,
+        UInt32 *                        data,
+        Int32 *                         result
+    );
+
+static
+Void RcmServer_execBatch_P(
+        RcmServer_Object *              obj,
+        RcmClient_Packet *              packet
+    );
+
 static
 Int RcmServer_execMsg_I(
+        RcmServer_Object *              obj,
+        RcmClient_Packet *              packet
+    );
+
+#if USE_MESSAGEQCOPY
+static
+Int RcmServer_execPtrMsg_P(
         RcmServer_Object *              obj,
         RcmClient_Message *             msg
     );
 
+static inline
+UInt32 RcmServer_xlateAddr_I(
+        UInt32                          pa,
+        UInt32                          size
+    );
+#endif
+
 static
 Int RcmServer_getFxnAddr_P(
         RcmServer_Object *              obj,
         UInt32                          fxnIdx,
         RcmServer_MsgFxn *              addrPtr,
-        RcmServer_MsgCreateFxn *        createPtr
+        RcmServer_MsgCreateFxn *        createPtr,
+        RcmServer_FxnTabInfo **         infoPtr
+    );
+
+static
+Void RcmServer_fxnStat_I(
+        RcmServer_FxnStats *            stats,
+        UInt32                          delta,
+        Int32                           result
+    );
+
+static
+Int RcmServer_readFxnStats_P(
+        RcmServer_Object *              obj,
+        UInt32                          fxnIdx,
+        RcmServer_FxnStats *            stats,
+        Bool                            reset
+    );
+
+static inline
+UInt RcmServer_latBucket_I(
+        UInt32                          delta
     );
 
 static
@@ -218,17 +398,59 @@ Int RcmServer_getSymIdx_P(
         UInt32 *                        index
     );
 
+static inline
+RcmServer_FxnTabInfo *RcmServer_getInfo_I(
+        RcmServer_Object *              obj,
+        UInt32                          fxnIdx
+    );
+
+static
+String RcmServer_nameAlloc_P(
+        RcmServer_Object *              obj,
+        String                          name,
+        Error_Block *                   eb
+    );
+
+static
+Void RcmServer_nameReset_P(
+        RcmServer_Object *              obj
+    );
+
+static inline
+UInt RcmServer_symHash_I(
+        String                          name
+    );
+
+static
+Void RcmServer_symInsert_P(
+        RcmServer_Object *              obj,
+        UInt32                          fxnIdx
+    );
+
+static
+Void RcmServer_symRemove_P(
+        RcmServer_Object *              obj,
+        UInt32                          fxnIdx
+    );
+
+static inline
+RcmServer_JobStream *RcmServer_findJob_I(
+        RcmServer_Object *              obj,
+        UInt16                          jobId
+    );
+
 static
 Int RcmServer_getPool_P(
         RcmServer_Object *              obj,
-        RcmClient_Packet *              packet,
+        UInt16                          poolId,
         RcmServer_ThreadPool **         poolP
     );
 
 static
 Void RcmServer_process_P(
         RcmServer_Object *              obj,
-        RcmClient_Packet *              packet
+        RcmClient_Packet *              packet,
+        Bool                            kick
     );
 
 static
@@ -237,11 +459,85 @@ Int RcmServer_relJobId_P(
         UInt16                          jobId
     );
 
+static
+Void RcmServer_freeJob_P(
+        RcmServer_Object *              obj,
+        RcmServer_JobStream *           job
+    );
+
+static
+Int RcmServer_reply_P(
+        RcmServer_Object *              obj,
+        RcmClient_Packet *              packet,
+        Bool                            kick
+    );
+
+static inline
+Void RcmServer_flushReplies_I(
+        RcmServer_Object *              obj
+    );
+
 static
 Void RcmServer_serverThrFxn_P(
         IArg                            arg
     );
 
+#if USE_MESSAGEQCOPY
+static
+Int RcmServer_addPackets_P(
+        RcmServer_Object *              obj,
+        UInt                            count
+    );
+
+static inline
+RcmClient_Packet *RcmServer_allocPacket_I(
+        RcmServer_Object *              obj
+    );
+
+static inline
+Bool RcmServer_claimPacket_I(
+        RcmServer_Object *              obj,
+        RcmClient_Packet *              packet
+    );
+
+static
+Void RcmServer_cancel_P(
+        RcmServer_Object *              obj,
+        RcmClient_Packet *              packet
+    );
+
+static inline
+Void RcmServer_freePacket_I(
+        RcmServer_Object *              obj,
+        RcmClient_Packet *              packet
+    );
+
+static inline
+Bool RcmServer_isNonBlocking_I(
+        RcmServer_Object *              obj,
+        RcmClient_Packet *              packet
+    );
+
+static
+Bool RcmServer_swiRecv_P(
+        UArg                            arg,
+        Ptr                             data,
+        UInt16                          len,
+        UInt16                          srcProc,
+        UInt32                          srcEndpt
+    );
+
+static inline
+Bool RcmServer_expired_I(
+        RcmClient_Packet *              packet
+    );
+
+static inline
+Void RcmServer_takeTtl_I(
+        RcmClient_Packet *              packet
+    );
+#endif
+
 static inline
 Void RcmServer_setStatusCode_I(
         RcmClient_Packet *              packet,
@@ -333,8 +629,12 @@ Void RcmServer_Params_init(RcmServer_Params *params)
     params->defaultPool.count = 0;
     params->defaultPool.priority = Thread_Priority_NORMAL;
     params->defaultPool.osPriority = Thread_INVALID_OS_PRIORITY;
+    params->defaultPool.maxOsPriority = Thread_INVALID_OS_PRIORITY;
     params->defaultPool.stackSize = 0;  // use system default
     params->defaultPool.stackSeg = "";
+    params->defaultPool.maxCount = 0;   // fixed size pool
+    params->defaultPool.growDepth = 0;
+    params->defaultPool.idleTimeout = 0;
 
     /* worker pools */
     params->workerPools.length = 0;
@@ -343,6 +643,12 @@ Void RcmServer_Params_init(RcmServer_Params *params)
     /* function table */
     params->fxns.length = 0;
     params->fxns.elem = NULL;
+
+    /* packet pool */
+    params->packetCount = 0;  // size from the worker thread count
+
+    /* reply coalescing */
+    params->replyBatch = RcmServer_DEFREPLYBATCH;
 }
 
 
@@ -464,12 +770,10 @@ Int RcmServer_Instance_init_P(RcmServer_Object *obj, String name,
     Thread_Params threadP;
     SemThread_Params semThreadP;
     SemThread_Handle semThreadH;
-    Int i, j;
+    Int i, j, k;
     SizeT size;
     Char *cp;
     RcmServer_ThreadPool *poolAry;
-    RcmServer_WorkerThread *worker;
-    List_Handle listH;
     Int status = RcmServer_S_SUCCESS;
 
 
@@ -481,18 +785,34 @@ Int RcmServer_Instance_init_P(RcmServer_Object *obj, String name,
     obj->shutdown = FALSE;
     obj->key = 0;
     obj->jobId = 0xFFFF;
+    obj->poolKey = 0;
     obj->run = NULL;
     obj->serverQue = NULL;
     obj->serverThread = NULL;
     obj->fxnTabStatic.length = 0;
     obj->fxnTabStatic.elem = NULL;
     obj->poolMap0Len = 0;
-    obj->jobList = NULL;
+    obj->jobTab = NULL;
+    obj->symTab = NULL;
+    obj->nameArena = NULL;
+    obj->nameLive = 0;
+    _memset((Void *)obj->latHist, 0, sizeof(obj->latHist));
+#if USE_MESSAGEQCOPY
+    obj->replyAddr = RcmClient_INVALIDADDR;
+    obj->pktBlock = NULL;
+    obj->pktCount = 0;
+    obj->pktSpare = 0;
+    obj->pktAuto = FALSE;
+    obj->pktList = NULL;
+    obj->pktSem = NULL;
+#endif
 
 
     /* initialize the function table */
     for (i = 0; i < RcmServer_MAX_TABLES; i++) {
         obj->fxnTab[i] = NULL;
+        obj->fxnInfo[i] = NULL;
+        obj->fxnFree[i] = RcmServer_SLOT_NONE;
     }
 
     /* initialize the worker pool map */
@@ -509,26 +829,33 @@ Int RcmServer_Instance_init_P(RcmServer_Object *obj, String name,
         goto leave;
     }
 
-    /* create list for job objects */
-#if defined(RCM_ti_ipc)
-    List_Params_init(&listP);
-    obj->jobList = List_create(&listP, &eb);
+    /* create the hash table for job objects */
+    size = RcmServer_JOB_TAB_LEN * sizeof(RcmServer_JobStream *);
+    obj->jobTab = xdc_runtime_Memory_calloc(
+        RcmServer_Module_heap(), size, sizeof(Ptr), &eb);
 
     if (Error_check(&eb)) {
-        Log_error0(FXNN": could not create list object");
-        status = RcmServer_E_FAIL;
+        Log_error2(FXNN": out of memory: heap=0x%x, size=%u",
+            (IArg)RcmServer_Module_heap(), size);
+        status = RcmServer_E_NOMEMORY;
         goto leave;
     }
-#elif defined(RCM_ti_syslink)
-    List_Params_init(&listP);
-    obj->jobList = List_create(&listP, NULL);
 
-    if (obj->jobList == NULL) {
-        Log_error0(FXNN": could not create list object");
-        status = RcmServer_E_FAIL;
+    /* create the symbol index, all chains start empty */
+    size = RcmServer_SYM_TAB_LEN * sizeof(UInt32);
+    obj->symTab = xdc_runtime_Memory_alloc(
+        RcmServer_Module_heap(), size, sizeof(Ptr), &eb);
+
+    if (Error_check(&eb)) {
+        Log_error2(FXNN": out of memory: heap=0x%x, size=%u",
+            (IArg)RcmServer_Module_heap(), size);
+        status = RcmServer_E_NOMEMORY;
         goto leave;
     }
-#endif
+
+    for (i = 0; i < RcmServer_SYM_TAB_LEN; i++) {
+        obj->symTab[i] = RcmServer_SYM_NONE;
+    }
 
     /* create the static function table */
     if (params->fxns.length > 0) {
@@ -545,7 +872,19 @@ Int RcmServer_Instance_init_P(RcmServer_Object *obj, String name,
             status = RcmServer_E_NOMEMORY;
             goto leave;
         }
-        obj->fxnTabStatic.elem[0].name = NULL;
+
+        /* allocate the names and statistics kept apart from the table */
+        size = params->fxns.length * sizeof(RcmServer_FxnTabInfo);
+        obj->fxnInfo[0] = xdc_runtime_Memory_alloc(
+            RcmServer_Module_heap(), size, sizeof(Ptr), &eb);
+
+        if (Error_check(&eb)) {
+            Log_error2(FXNN": out of memory: heap=0x%x, size=%u",
+                (IArg)RcmServer_Module_heap(), size);
+            status = RcmServer_E_NOMEMORY;
+            goto leave;
+        }
+        obj->fxnInfo[0][0].name = NULL;
 
         /* allocate a single block to store all name strings */
         for (size = 0, i = 0; i < params->fxns.length; i++) {
@@ -564,14 +903,22 @@ Int RcmServer_Instance_init_P(RcmServer_Object *obj, String name,
         /* copy function table data into allocated memory blocks */
         for (i = 0; i < params->fxns.length; i++) {
             _strcpy(cp, params->fxns.elem[i].name);
-            obj->fxnTabStatic.elem[i].name = cp;
+            obj->fxnInfo[0][i].name = cp;
             cp += (_strlen(params->fxns.elem[i].name) + 1);
             obj->fxnTabStatic.elem[i].addr.fxn = params->fxns.elem[i].addr.fxn;
             obj->fxnTabStatic.elem[i].key = 0;
+            obj->fxnTabStatic.elem[i].flags = params->fxns.elem[i].flags;
+            _memset((Void *)&obj->fxnInfo[0][i].stats, 0,
+                sizeof(obj->fxnInfo[0][i].stats));
         }
 
         /* hook up the static function table */
         obj->fxnTab[0] = obj->fxnTabStatic.elem;
+
+        /* index the static symbols by name */
+        for (i = 0; i < params->fxns.length; i++) {
+            RcmServer_symInsert_P(obj, 0x80000000 | i);
+        }
     }
 
     /* create static worker pools */
@@ -638,12 +985,23 @@ Int RcmServer_Instance_init_P(RcmServer_Object *obj, String name,
     poolAry[0].count = params->defaultPool.count;
     poolAry[0].priority = params->defaultPool.priority;
     poolAry[0].osPriority = params->defaultPool.osPriority;
+    poolAry[0].maxOsPriority = params->defaultPool.maxOsPriority;
     poolAry[0].stackSize = params->defaultPool.stackSize;
+    poolAry[0].maxCount = params->defaultPool.maxCount;
+    poolAry[0].growDepth = params->defaultPool.growDepth;
+    poolAry[0].idleTimeout = params->defaultPool.idleTimeout;
+    poolAry[0].live = 0;
+    poolAry[0].queued = 0;
+    poolAry[0].growing = FALSE;
+    poolAry[0].pktShare = 0;
     poolAry[0].stackSeg = NULL;
     poolAry[0].sem = NULL;
 
     List_construct(&(poolAry[0].threadList), NULL);
-    List_construct(&(poolAry[0].readyQueue), NULL);
+    for (k = 0; k < RcmClient_Desc_NUMPRI; k++) {
+        List_construct(&(poolAry[0].readyQueue[k]), NULL);
+    }
+    List_construct(&(poolAry[0].retired), NULL);
 
     SemThread_Params_init(&semThreadP);
     semThreadP.mode = SemThread_Mode_COUNTING;
@@ -672,11 +1030,23 @@ Int RcmServer_Instance_init_P(RcmServer_Object *obj, String name,
         poolAry[i+1].count = params->workerPools.elem[i].count;
         poolAry[i+1].priority = params->workerPools.elem[i].priority;
         poolAry[i+1].osPriority =params->workerPools.elem[i].osPriority;
+        poolAry[i+1].maxOsPriority =
+            params->workerPools.elem[i].maxOsPriority;
         poolAry[i+1].stackSize = params->workerPools.elem[i].stackSize;
+        poolAry[i+1].maxCount = params->workerPools.elem[i].maxCount;
+        poolAry[i+1].growDepth = params->workerPools.elem[i].growDepth;
+        poolAry[i+1].idleTimeout = params->workerPools.elem[i].idleTimeout;
+        poolAry[i+1].live = 0;
+        poolAry[i+1].queued = 0;
+        poolAry[i+1].growing = FALSE;
+        poolAry[i+1].pktShare = 0;
         poolAry[i+1].stackSeg = NULL;
 
         List_construct(&(poolAry[i+1].threadList), NULL);
-        List_construct(&(poolAry[i+1].readyQueue), NULL);
+        for (k = 0; k < RcmClient_Desc_NUMPRI; k++) {
+            List_construct(&(poolAry[i+1].readyQueue[k]), NULL);
+        }
+        List_construct(&(poolAry[i+1].retired), NULL);
 
         SemThread_Params_init(&semThreadP);
         semThreadP.mode = SemThread_Mode_COUNTING;
@@ -692,52 +1062,64 @@ Int RcmServer_Instance_init_P(RcmServer_Object *obj, String name,
         poolAry[i+1].sem = SemThread_Handle_upCast(semThreadH);
     }
 
+#if USE_MESSAGEQCOPY
+    obj->replyBatch = params->replyBatch;
+#endif
+
     /* create the worker threads in each static pool */
     for (i = 0; i < obj->poolMap0Len; i++) {
         for (j = 0; j < poolAry[i].count; j++) {
+            status = RcmServer_addWorker_P(obj, &poolAry[i]);
 
-            /* allocate worker thread object */
-            size = sizeof(RcmServer_WorkerThread);
-            worker = (RcmServer_WorkerThread *)xdc_runtime_Memory_alloc(
-                RcmServer_Module_heap(), size, sizeof(Ptr), &eb);
-
-            if (Error_check(&eb)) {
-                Log_error2(FXNN": out of memory: heap=0x%x, size=%u",
-                    (IArg)RcmServer_Module_heap(), size);
-                status = RcmServer_E_NOMEMORY;
+            if (status < 0) {
+                Log_error2(FXNN": could not create worker thread, "
+                    "pool=%d, thread=%d", (IArg)i, (IArg)j);
                 goto leave;
             }
+        }
+    }
+
+#if USE_MESSAGEQCOPY
+    /* create the free packet list */
+    List_Params_init(&listP);
+    obj->pktList = List_create(&listP, &eb);
+
+    if (Error_check(&eb)) {
+        Log_error0(FXNN": could not create list object");
+        status = RcmServer_E_FAIL;
+        goto leave;
+    }
 
-            /* initialize worker thread object */
-            worker->jobId = RcmClient_DISCRETEJOBID;
-            worker->thread = NULL;
-            worker->terminate = FALSE;
-            worker->pool = &(poolAry[i]);
-            worker->server = obj;
+    /* counts the free packets, the server thread blocks when it is zero */
+    SemThread_Params_init(&semThreadP);
+    semThreadP.mode = SemThread_Mode_COUNTING;
 
-            /* add worker thread to worker pool */
-            listH = List_handle(&(poolAry[i].threadList));
-            List_putHead(listH, &(worker->elem));
+    obj->pktSem = SemThread_create(0, &semThreadP, &eb);
 
-            /* create worker thread */
-            Thread_Params_init(&threadP);
-            threadP.arg = (IArg)worker;
-            threadP.priority = poolAry[i].priority;
-            threadP.osPriority = poolAry[i].osPriority;
-            threadP.stackSize = poolAry[i].stackSize;
-            threadP.instance->name = "RcmServer_workerThr";
+    if (Error_check(&eb)) {
+        Log_error0(FXNN": could not create semaphore");
+        status = RcmServer_E_FAIL;
+        goto leave;
+    }
 
-            worker->thread = Thread_create(
-                (Thread_RunFxn)(RcmServer_workerThrFxn_P), &threadP, &eb);
+    /* size the packet pool, by default one packet per worker thread each
+     * pool may grow to plus extra; createPool then adds packets as well */
+    size = params->packetCount;
+    obj->pktAuto = (size == 0);
 
-            if (Error_check(&eb)) {
-                Log_error2(FXNN": could not create worker thread, "
-                    "pool=%d, thread=%d", (IArg)i, (IArg)j);
-                status = RcmServer_E_FAIL;
-                goto leave;
-            }
+    if (obj->pktAuto) {
+        for (i = 0; i < obj->poolMap0Len; i++) {
+            size += RcmServer_poolPkts(&poolAry[i]);
         }
+        size += RcmServer_PKT_POOL_EXTRA;
+    }
+
+    status = RcmServer_addPackets_P(obj, (UInt)size);
+
+    if (status < 0) {
+        goto leave;
     }
+#endif
 
     /* create the semaphore used to release the server thread */
     SemThread_Params_init(&semThreadP);
@@ -755,6 +1137,7 @@ Int RcmServer_Instance_init_P(RcmServer_Object *obj, String name,
 #if USE_MESSAGEQCOPY
     obj->serverQue = MessageQCopy_create(MessageQCopy_ASSIGN_ANY,
                                          &obj->localAddr);
+    /* replies go to each request's source, this is only the default */
 #ifdef BIOS_ONLY_TEST
     obj->dstProc = MultiProc_self();
 #else
@@ -860,17 +1243,10 @@ Int RcmServer_Instance_finalize_P(RcmServer_Object *obj)
     RcmServer_FxnTabElem *fdp;
     Error_Block eb;
     RcmServer_ThreadPool *poolAry;
-    RcmServer_WorkerThread *worker;
-    List_Elem *elem;
-    List_Handle listH;
-    List_Handle msgQueH;
-    RcmClient_Packet *packet;
-#if USE_MESSAGEQCOPY == 0
-    MessageQ_Msg msgqMsg;
+#if USE_MESSAGEQCOPY
+    RcmServer_PktBlock *pktBlock;
 #endif
-    SemThread_Handle semThreadH;
     RcmServer_JobStream *job;
-    Int rval;
     Int status = RcmClient_S_SUCCESS;
 
     Log_print1(Diags_ENTRY, "--> "FXNN": (obj=0x%x)", (IArg)obj);
@@ -897,123 +1273,29 @@ Int RcmServer_Instance_finalize_P(RcmServer_Object *obj)
     }
 
     /* delete any remaining job objects (there should not be any) */
-    while ((elem = List_get(obj->jobList)) != NULL) {
-        job = (RcmServer_JobStream *)elem;
-
-        /* return any remaining messages (there should not be any) */
-        msgQueH = List_handle(&job->msgQue);
-
-        while ((elem = List_get(msgQueH)) != NULL) {
-            packet = (RcmClient_Packet *)elem;
-            Log_warning2(
-                FXNN": returning unprocessed message, jobId=0x%x, packet=0x%x",
-                (IArg)job->jobId, (IArg)packet);
-
-            RcmServer_setStatusCode_I(packet, RcmServer_Status_Unprocessed);
-#if USE_MESSAGEQCOPY
-            packet->hdr.type = OMX_RAW_MSG;
-            packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-            rval = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-            msgqMsg = &packet->msgqHeader;
-            rval = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-            if (rval < 0) {
-                Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)rval);
+    if (obj->jobTab != NULL) {
+        for (i = 0; i < RcmServer_JOB_TAB_LEN; i++) {
+            while ((job = obj->jobTab[i]) != NULL) {
+                obj->jobTab[i] = job->next;
+                RcmServer_freeJob_P(obj, job);
             }
         }
 
-        /* finalize the job stream object */
-        List_destruct(&job->msgQue);
-
-        xdc_runtime_Memory_free(RcmServer_Module_heap(),
-            (Ptr)job, sizeof(RcmServer_JobStream));
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), (Ptr)obj->jobTab,
+            RcmServer_JOB_TAB_LEN * sizeof(RcmServer_JobStream *));
+        obj->jobTab = NULL;
     }
-    List_delete(&(obj->jobList));
 
     /* convenience alias */
     poolAry = obj->poolMap[0];
 
     /* free all the static pool resources */
     for (i = 0; i < obj->poolMap0Len; i++) {
+        status = RcmServer_finalizePool_P(obj, &poolAry[i]);
 
-        /* free all the worker thread objects */
-        listH = List_handle(&(poolAry[i].threadList));
-
-        /* mark each worker thread for termination */
-        elem = NULL;
-        while ((elem = List_next(listH, elem)) != NULL) {
-            worker = (RcmServer_WorkerThread *)elem;
-            worker->terminate = TRUE;
-        }
-
-        /* unblock each worker thread so it can terminate */
-        elem = NULL;
-        while ((elem = List_next(listH, elem)) != NULL) {
-            Semaphore_post(poolAry[i].sem, &eb);
-
-            if (Error_check(&eb)) {
-                Log_error0(FXNN": post failed on thread");
-                status = RcmServer_E_FAIL;
-                goto leave;
-            }
-        }
-
-        /* wait for each worker thread to terminate */
-        elem = NULL;
-        while ((elem = List_get(listH)) != NULL) {
-            worker = (RcmServer_WorkerThread *)elem;
-
-            Thread_join(worker->thread, &eb);
-
-            if (Error_check(&eb)) {
-                Log_error1(
-                    FXNN": worker thread did not exit properly, thread=0x%x",
-                    (IArg)worker->thread);
-                status = RcmServer_E_FAIL;
-                goto leave;
-            }
-
-            Thread_delete(&worker->thread);
-
-            /* free the worker thread object */
-            xdc_runtime_Memory_free(RcmServer_Module_heap(), (Ptr)worker,
-                sizeof(RcmServer_WorkerThread));
-        }
-
-        /* free up pool resources */
-        semThreadH = SemThread_Handle_downCast(poolAry[i].sem);
-        SemThread_delete(&semThreadH);
-        List_destruct(&(poolAry[i].threadList));
-
-        /* return any remaining messages on the readyQueue */
-        msgQueH = List_handle(&poolAry[i].readyQueue);
-
-        while ((elem = List_get(msgQueH)) != NULL) {
-            packet = (RcmClient_Packet *)elem;
-            Log_warning2(
-                FXNN": returning unprocessed message, msgId=0x%x, packet=0x%x",
-                (IArg)packet->msgId, (IArg)packet);
-
-            RcmServer_setStatusCode_I(packet, RcmServer_Status_Unprocessed);
-#if USE_MESSAGEQCOPY
-            packet->hdr.type = OMX_RAW_MSG;
-            packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-            rval = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-            msgqMsg = &packet->msgqHeader;
-            rval = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-            if (rval < 0) {
-                Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)rval);
-            }
+        if (status < 0) {
+            goto leave;
         }
-
-        List_destruct(&(poolAry[i].readyQueue));
     }
 
     /* free the name block for the static pools */
@@ -1030,31 +1312,60 @@ Int RcmServer_Instance_finalize_P(RcmServer_Object *obj)
         obj->poolMap[0] = NULL;
     }
 
-#if 0
     /* free all dynamic worker pools */
-    for (p = 1; p < RcmServer_POOL_MAP_LEN; p++) {
-        if ((poolAry = obj->poolMap[p]) == NULL) {
+    for (i = 1; i < RcmServer_POOL_MAP_LEN; i++) {
+        if ((poolAry = obj->poolMap[i]) == NULL) {
             continue;
         }
+
+        for (j = 0; j < RcmServer_poolTabLen(i); j++) {
+            if (poolAry[j].key == 0) {
+                continue;
+            }
+
+            status = RcmServer_finalizePool_P(obj, &poolAry[j]);
+
+            if (status < 0) {
+                goto leave;
+            }
+
+            if (poolAry[j].name != NULL) {
+                xdc_runtime_Memory_free(RcmServer_Module_heap(),
+                    poolAry[j].name, _strlen(poolAry[j].name) + 1);
+            }
+        }
+
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), (Ptr)poolAry,
+            RcmServer_poolTabLen(i) * sizeof(RcmServer_ThreadPool));
+        obj->poolMap[i] = NULL;
     }
-#endif
 
-    /* free up the dynamic function tables and any leftover name strings */
+    /* free up the dynamic function tables */
     for (i = 1; i < RcmServer_MAX_TABLES; i++) {
         if (obj->fxnTab[i] != NULL) {
             tabCount = (1 << (i + 4));
-            for (j = 0; j < tabCount; j++) {
-                if (((obj->fxnTab[i])+j)->name != NULL) {
-                    cp = ((obj->fxnTab[i])+j)->name;
-                    size = _strlen(cp) + 1;
-                    xdc_runtime_Memory_free(RcmServer_Module_heap(), cp, size);
-                }
-            }
             fdp = obj->fxnTab[i];
             size = tabCount * sizeof(RcmServer_FxnTabElem);
             xdc_runtime_Memory_free(RcmServer_Module_heap(), fdp, size);
             obj->fxnTab[i] = NULL;
         }
+        if (obj->fxnInfo[i] != NULL) {
+            tabCount = (1 << (i + 4));
+            size = tabCount * sizeof(RcmServer_FxnTabInfo);
+            xdc_runtime_Memory_free(RcmServer_Module_heap(),
+                obj->fxnInfo[i], size);
+            obj->fxnInfo[i] = NULL;
+        }
+    }
+
+    /* free any leftover dynamic name strings */
+    RcmServer_nameReset_P(obj);
+
+    /* free the symbol index */
+    if (NULL != obj->symTab) {
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), obj->symTab,
+            RcmServer_SYM_TAB_LEN * sizeof(UInt32));
+        obj->symTab = NULL;
     }
 
     if (NULL != obj->serverThread) {
@@ -1073,15 +1384,41 @@ Int RcmServer_Instance_finalize_P(RcmServer_Object *obj)
         SemThread_delete((SemThread_Handle *)(&obj->run));
     }
 
+#if USE_MESSAGEQCOPY
+    /* free the packet pool, all packets have been returned by now */
+    if (NULL != obj->pktSem) {
+        SemThread_delete((SemThread_Handle *)(&obj->pktSem));
+    }
+
+    if (NULL != obj->pktList) {
+        /* the buffers belong to the packet blocks, just empty the list */
+        while (List_get(obj->pktList) != NULL) {
+        }
+        List_delete(&obj->pktList);
+    }
+
+    while (NULL != (pktBlock = obj->pktBlock)) {
+        obj->pktBlock = pktBlock->next;
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), pktBlock,
+            sizeof(RcmServer_PktBlock) + (pktBlock->count * MSGBUFFERSIZE));
+    }
+    obj->pktCount = 0;
+#endif
+
     /* free the name block for the static function table */
-    if ((NULL != obj->fxnTabStatic.elem) &&
-        (NULL != obj->fxnTabStatic.elem[0].name)) {
+    if ((NULL != obj->fxnInfo[0]) && (NULL != obj->fxnInfo[0][0].name)) {
         for (size = 0, i = 0; i < obj->fxnTabStatic.length; i++) {
-            size += _strlen(obj->fxnTabStatic.elem[i].name) + 1;
+            size += _strlen(obj->fxnInfo[0][i].name) + 1;
         }
         xdc_runtime_Memory_free(
-            RcmServer_Module_heap(),
-            obj->fxnTabStatic.elem[0].name, size);
+            RcmServer_Module_heap(), obj->fxnInfo[0][0].name, size);
+    }
+
+    /* free the static function info table */
+    if (NULL != obj->fxnInfo[0]) {
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), obj->fxnInfo[0],
+            obj->fxnTabStatic.length * sizeof(RcmServer_FxnTabInfo));
+        obj->fxnInfo[0] = NULL;
     }
 
     /* free the static function table */
@@ -1103,402 +1440,550 @@ leave:
 
 
 /*
- *  ======== RcmServer_addSymbol ========
+ *  ======== RcmServer_addWorker_P ========
+ *
+ *  Create one worker thread and add it to the given pool. The gate only
+ *  covers the pool bookkeeping, the thread is created outside of it.
  */
-#define FXNN "RcmServer_addSymbol"
-Int RcmServer_addSymbol(RcmServer_Object *obj, String funcName,
-        RcmServer_MsgFxn addr, UInt32 *index)
+#define FXNN "RcmServer_addWorker_P"
+Int RcmServer_addWorker_P(RcmServer_Object *obj, RcmServer_ThreadPool *pool)
 {
+    Error_Block eb;
+    Thread_Params threadP;
+    RcmServer_WorkerThread *worker;
+    List_Handle listH;
     GateThread_Handle gateH;
     IArg key;
-    Int len;
-    UInt i, j;
-    UInt tabCount;
-    SizeT tabSize;
-    UInt32 fxnIdx = 0xFFFF;
-    RcmServer_FxnTabElem *slot = NULL;
-    Error_Block eb;
     Int status = RcmServer_S_SUCCESS;
 
 
-    Log_print3(Diags_ENTRY,
-        "--> "FXNN": (obj=0x%x, name=0x%x, addr=0x%x)",
-        (IArg)obj, (IArg)funcName, (IArg)addr);
-
     Error_init(&eb);
 
-    /* protect the symbol table while changing it */
+    /* allocate worker thread object */
+    worker = (RcmServer_WorkerThread *)xdc_runtime_Memory_alloc(
+        RcmServer_Module_heap(), sizeof(RcmServer_WorkerThread),
+        sizeof(Ptr), &eb);
+
+    if (Error_check(&eb)) {
+        Log_error2(FXNN": out of memory: heap=0x%x, size=%u",
+            (IArg)RcmServer_Module_heap(), sizeof(RcmServer_WorkerThread));
+        status = RcmServer_E_NOMEMORY;
+        goto leave;
+    }
+
+    /* initialize worker thread object */
+    worker->jobId = RcmClient_DISCRETEJOBID;
+    worker->thread = NULL;
+    worker->terminate = FALSE;
+    worker->pool = pool;
+    worker->server = obj;
+
+    /* add worker thread to worker pool */
+    listH = List_handle(&(pool->threadList));
     gateH = GateThread_handle(&obj->gate);
     key = GateThread_enter(gateH);
+    List_putHead(listH, &(worker->elem));
+    pool->live++;
+    GateThread_leave(gateH, key);
 
-    /* look for an empty slot to use */
-    for (i = 1; i < RcmServer_MAX_TABLES; i++) {
-        if (obj->fxnTab[i] != NULL) {
-            for (j = 0; j < (1 << (i + 4)); j++) {
-                if (((obj->fxnTab[i])+j)->addr.fxn == 0) {
-                    slot = (obj->fxnTab[i]) + j;  // found empty slot
-                    break;
-                }
-            }
-        }
-        else {
-            /* all previous tables are full, allocate a new table */
-            tabCount = (1 << (i + 4));
-            tabSize = tabCount * sizeof(RcmServer_FxnTabElem);
-            obj->fxnTab[i] = (RcmServer_FxnTabElem *)xdc_runtime_Memory_alloc(
-                RcmServer_Module_heap(), tabSize, sizeof(Ptr), &eb);
+    /* create worker thread */
+    Thread_Params_init(&threadP);
+    threadP.arg = (IArg)worker;
+    threadP.priority = pool->priority;
+    threadP.osPriority = pool->osPriority;
+    threadP.stackSize = pool->stackSize;
+    threadP.instance->name = "RcmServer_workerThr";
 
-            if (Error_check(&eb)) {
-                Log_error0(FXNN": unable to allocate new function table");
-                obj->fxnTab[i] = NULL;
-                status = RcmServer_E_NOMEMORY;
-                goto leave;
-            }
+    worker->thread = Thread_create(
+        (Thread_RunFxn)(RcmServer_workerThrFxn_P), &threadP, &eb);
 
-            /* initialize the new table */
-            for (j = 0; j < tabCount; j++) {
-                ((obj->fxnTab[i])+j)->addr.fxn = 0;
-                ((obj->fxnTab[i])+j)->name = NULL;
-                ((obj->fxnTab[i])+j)->key = 0;
-            }
+    if (Error_check(&eb)) {
+        Log_error1(FXNN": could not create worker thread, pool=0x%x",
+            (IArg)pool);
+        key = GateThread_enter(gateH);
+        List_remove(listH, &(worker->elem));
+        pool->live--;
+        GateThread_leave(gateH, key);
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), (Ptr)worker,
+            sizeof(RcmServer_WorkerThread));
+        status = RcmServer_E_FAIL;
+        goto leave;
+    }
 
-            /* use first slot in new table */
-            j = 0;
-            slot = (obj->fxnTab[i])+j;
-        }
+leave:
+    return(status);
+}
+#undef FXNN
 
-        /* if new slot found, break out of loop */
-        if (slot != NULL) {
-            break;
-        }
-    }
 
-    /* insert new symbol into slot */
-    if (slot != NULL) {
-        slot->addr.fxn = addr;
-        len = _strlen(funcName) + 1;
-        slot->name = (String)xdc_runtime_Memory_alloc(
-            RcmServer_Module_heap(), len, sizeof(Char *), &eb);
+/*
+ *  ======== RcmServer_enqueue_P ========
+ *
+ *  Put a message on the pool's ready queue and wake a worker. An elastic
+ *  pool needs another worker thread when its queue is deeper than the
+ *  grow threshold, up to its maxCount threads, or when it has no worker
+ *  thread at all (count is zero, or they all retired). Returns TRUE if
+ *  so; the caller must then call RcmServer_growPool_P once it has left
+ *  the gate, so that no thread is created while the gate is held.
+ */
+#define FXNN "RcmServer_enqueue_P"
+Bool RcmServer_enqueue_P(RcmServer_Object *obj, RcmServer_ThreadPool *pool,
+        RcmClient_Packet *packet)
+{
+    Error_Block eb;
+    GateThread_Handle gateH;
+    IArg key;
+    Bool grow = FALSE;
+
 
-        if (Error_check(&eb)) {
-            Log_error0(FXNN": unable to allocate function name");
-            slot->name = NULL;
-            status = RcmServer_E_NOMEMORY;
-            goto leave;
-        }
+    Error_init(&eb);
 
-        _strcpy(slot->name, funcName);
-        slot->key = RcmServer_getNextKey_P(obj);
-        fxnIdx = (slot->key << _RCM_KeyShift) | (i << 12) | j;
-    }
+    if (RcmServer_isElastic(pool)) {
+        gateH = GateThread_handle(&obj->gate);
+        key = GateThread_enter(gateH);
 
-    /* error, no more room to add new symbol */
-    else {
-        Log_error0(FXNN": cannot add symbol, table is full");
-        status = RcmServer_E_SYMBOLTABLEFULL;
-        goto leave;
+        pool->queued++;
+
+        /* only one thread is added at a time; a pool without workers
+         * must grow, or the message waits for a thread that never comes */
+        if (!pool->growing && (pool->live < pool->maxCount)
+            && ((pool->queued > pool->growDepth) || (pool->live == 0))) {
+            pool->growing = TRUE;
+            grow = TRUE;
+        }
+
+        GateThread_leave(gateH, key);
     }
 
+    List_put(List_handle(&pool->readyQueue[RcmServer_pktPri(packet)]),
+        (List_Elem *)packet);
 
-leave:
-    GateThread_leave(gateH, key);
+    /* dispatch a new worker thread */
+    Semaphore_post(pool->sem, &eb);
 
-    /* on success, return new function index */
-    if (status >= 0) {
-        *index = fxnIdx;
+    if (Error_check(&eb)) {
+        Log_error0(FXNN": semaphore post failed");
     }
-    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
-    return(status);
+
+    return(grow);
 }
 #undef FXNN
 
 
 /*
- *  ======== RcmServer_removeSymbol ========
+ *  ======== RcmServer_growPool_P ========
+ *
+ *  Add the worker thread requested by RcmServer_enqueue_P. Must not be
+ *  called with the gate held. RcmServer_finalizePool_P waits for this
+ *  to finish, so the pool cannot go away underneath it.
  */
-#define FXNN "RcmServer_removeSymbol"
-Int RcmServer_removeSymbol(RcmServer_Object *obj, String name)
+#define FXNN "RcmServer_growPool_P"
+Void RcmServer_growPool_P(RcmServer_Object *obj, RcmServer_ThreadPool *pool)
 {
     GateThread_Handle gateH;
     IArg key;
-    UInt32 fxnIdx;
-    UInt tabIdx, tabOff;
-    RcmServer_FxnTabElem *slot;
-    Int status = RcmServer_S_SUCCESS;
+    Int rval;
 
 
-    Log_print2(Diags_ENTRY,
-        "--> "FXNN": (obj=0x%x, name=0x%x)", (IArg)obj, (IArg)name);
+    rval = RcmServer_addWorker_P(obj, pool);
+
+    if (rval < 0) {
+        Log_error1(FXNN": could not grow pool=0x%x", (IArg)pool);
+    }
 
-    /* protect the symbol table while changing it */
     gateH = GateThread_handle(&obj->gate);
     key = GateThread_enter(gateH);
+    pool->growing = FALSE;
+    GateThread_leave(gateH, key);
+}
+#undef FXNN
 
-    /* find the symbol in the table */
-    status = RcmServer_getSymIdx_P(obj, name, &fxnIdx);
 
-    if (status < 0) {
-        Log_error0(FXNN": given symbol not found");
-        goto leave;
-    }
+/*
+ *  ======== RcmServer_getReady_I ========
+ *
+ *  Take the next message off the pool's ready queues, most urgent
+ *  priority class first. Each List_get is atomic, so no lock is needed.
+ */
+RcmClient_Packet *RcmServer_getReady_I(RcmServer_ThreadPool *pool)
+{
+    Int i;
+    List_Elem *elem = NULL;
 
-    /* static symbols have bit-31 set, cannot remove these symbols */
-    if (fxnIdx & 0x80000000) {
-        Log_error0(FXNN": cannot remove static symbol");
-        status = RcmServer_E_SYMBOLSTATIC;
-        goto leave;
+    for (i = RcmClient_Desc_NUMPRI - 1; (i >= 0) && (elem == NULL); i--) {
+        elem = List_get(List_handle(&pool->readyQueue[i]));
     }
 
-    /* get slot pointer */
-    tabIdx = (fxnIdx & 0xF000) >> 12;
-    tabOff = (fxnIdx & 0xFFF);
-    slot = (obj->fxnTab[tabIdx]) + tabOff;
+    return((RcmClient_Packet *)elem);
+}
 
-    /* clear the table index */
-    slot->addr.fxn = 0;
-    if (slot->name != NULL) {
-        xdc_runtime_Memory_free(
-            RcmServer_Module_heap(), slot->name, _strlen(slot->name) + 1);
-        slot->name = NULL;
+
+/*
+ *  ======== RcmServer_retireWorker_P ========
+ *
+ *  Called by an idle worker of an elastic pool. If the pool has more
+ *  than its minimum thread count, move the worker to the retired list
+ *  and return TRUE; the worker must then exit.
+ */
+Bool RcmServer_retireWorker_P(RcmServer_WorkerThread *worker)
+{
+    GateThread_Handle gateH;
+    IArg key;
+    RcmServer_ThreadPool *pool = worker->pool;
+    Bool retire = FALSE;
+
+
+    gateH = GateThread_handle(&worker->server->gate);
+    key = GateThread_enter(gateH);
+
+    if (!worker->terminate && (pool->live > pool->count)) {
+        List_remove(List_handle(&pool->threadList), &worker->elem);
+        List_put(List_handle(&pool->retired), &worker->elem);
+        pool->live--;
+        retire = TRUE;
     }
-    slot->key = 0;
 
-leave:
     GateThread_leave(gateH, key);
-    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
-    return(status);
+
+    return(retire);
 }
-#undef FXNN
 
 
 /*
- *  ======== RcmServer_start ========
+ *  ======== RcmServer_reapWorkers_P ========
+ *
+ *  Join and free retired worker threads.
  */
-#define FXNN "RcmServer_start"
-Int RcmServer_start(RcmServer_Object *obj)
+#define FXNN "RcmServer_reapWorkers_P"
+Void RcmServer_reapWorkers_P(RcmServer_ThreadPool *pool)
 {
     Error_Block eb;
-    Int status = RcmServer_S_SUCCESS;
-
+    List_Elem *elem;
+    RcmServer_WorkerThread *worker;
 
-    Log_print1(Diags_ENTRY, "--> "FXNN": (obj=0x%x)", (IArg)obj);
 
     Error_init(&eb);
 
-    /* unblock the server thread */
-    Semaphore_post(obj->run, &eb);
+    while ((elem = List_get(List_handle(&pool->retired))) != NULL) {
+        worker = (RcmServer_WorkerThread *)elem;
 
-    if (Error_check(&eb)) {
-        Log_error0(FXNN": semaphore post failed");
-        status = RcmServer_E_FAIL;
-    }
+        Thread_join(worker->thread, &eb);
 
-    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
-    return(status);
+        if (Error_check(&eb)) {
+            Log_error1(FXNN": worker thread did not exit properly, thread=0x%x",
+                (IArg)worker->thread);
+            Error_init(&eb);
+        }
+
+        Thread_delete(&worker->thread);
+
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), (Ptr)worker,
+            sizeof(RcmServer_WorkerThread));
+    }
 }
 #undef FXNN
 
 
 /*
- *  ======== RcmServer_acqJobId_P ========
+ *  ======== RcmServer_finalizePool_P ========
+ *
+ *  Terminate and free all worker threads of the given pool, return any
+ *  messages left on its ready queue and release the pool resources. The
+ *  pool must no longer be reachable from RcmServer_getPool_P.
  */
-#define FXNN "RcmServer_acqJobId_P"
-Int RcmServer_acqJobId_P(RcmServer_Object *obj, UInt16 *jobIdPtr)
+#define FXNN "RcmServer_finalizePool_P"
+Int RcmServer_finalizePool_P(RcmServer_Object *obj, RcmServer_ThreadPool *pool)
 {
     Error_Block eb;
     GateThread_Handle gateH;
     IArg key;
-    Int count;
-    UInt16 jobId;
+    RcmServer_WorkerThread *worker;
     List_Elem *elem;
-    RcmServer_JobStream *job;
+    List_Handle listH;
+    RcmClient_Packet *packet;
+    SemThread_Handle semThreadH;
+    Int i;
     Int status = RcmServer_S_SUCCESS;
 
 
-    Log_print2(Diags_ENTRY,
-        "--> "FXNN": (obj=0x%x, jobIdPtr=0x%x)", (IArg)obj, (IArg)jobIdPtr);
-
     Error_init(&eb);
-    gateH = GateThread_handle(&obj->gate);
 
-    /* enter critical section */
+    /* free all the worker thread objects */
+    listH = List_handle(&(pool->threadList));
+
+    /* mark each worker thread for termination, the gate keeps idle
+     * workers of an elastic pool from retiring at the same time; wait
+     * for a thread being added by RcmServer_growPool_P to join the list */
+    gateH = GateThread_handle(&obj->gate);
     key = GateThread_enter(gateH);
 
-    /* compute new job id */
-    for (count = 0xFFFF; count > 0; count--) {
+    while (pool->growing) {
+        GateThread_leave(gateH, key);
+        Thread_sleep(RcmServer_GROW_POLL, &eb);
+        key = GateThread_enter(gateH);
+    }
 
-        /* generate a new job id */
-        jobId = (obj->jobId == 0xFFFF ? obj->jobId = 1 : ++(obj->jobId));
+    elem = NULL;
+    while ((elem = List_next(listH, elem)) != NULL) {
+        worker = (RcmServer_WorkerThread *)elem;
+        worker->terminate = TRUE;
+    }
 
-        /* verify job id is not in use */
-        elem = NULL;
-        while ((elem = List_next(obj->jobList, elem)) != NULL) {
-            job = (RcmServer_JobStream *)elem;
-            if (jobId == job->jobId) {
-                jobId = RcmClient_DISCRETEJOBID;
-                break;
-            }
-        }
+    GateThread_leave(gateH, key);
 
-        if (jobId != RcmClient_DISCRETEJOBID) {
-            break;
+    /* unblock each worker thread so it can terminate */
+    elem = NULL;
+    while ((elem = List_next(listH, elem)) != NULL) {
+        Semaphore_post(pool->sem, &eb);
+
+        if (Error_check(&eb)) {
+            Log_error0(FXNN": post failed on thread");
+            status = RcmServer_E_FAIL;
+            goto leave;
         }
     }
 
-    /* check if job id was acquired */
-    if (jobId == RcmClient_DISCRETEJOBID) {
-        *jobIdPtr = RcmClient_DISCRETEJOBID;
-        Log_error0(FXNN": no job id available");
-        status = RcmServer_E_FAIL;
-        GateThread_leave(gateH, key);
-        goto leave;
-    }
+    /* wait for each worker thread to terminate */
+    elem = NULL;
+    while ((elem = List_get(listH)) != NULL) {
+        worker = (RcmServer_WorkerThread *)elem;
 
-    /* create a new job steam object */
-    job = xdc_runtime_Memory_alloc(RcmServer_Module_heap(),
-        sizeof(RcmServer_JobStream), sizeof(Ptr), &eb);
+        Thread_join(worker->thread, &eb);
 
-    if (Error_check(&eb)) {
-        Log_error2(FXNN": out of memory: heap=0x%x, size=%u",
-            (IArg)RcmServer_Module_heap(), sizeof(RcmServer_JobStream));
-        status = RcmServer_E_NOMEMORY;
-        GateThread_leave(gateH, key);
-        goto leave;
+        if (Error_check(&eb)) {
+            Log_error1(
+                FXNN": worker thread did not exit properly, thread=0x%x",
+                (IArg)worker->thread);
+            status = RcmServer_E_FAIL;
+            goto leave;
+        }
+
+        Thread_delete(&worker->thread);
+
+        /* free the worker thread object */
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), (Ptr)worker,
+            sizeof(RcmServer_WorkerThread));
     }
 
-    /* initialize new job stream object */
-    job->jobId = jobId;
-    job->empty = TRUE;
-    List_construct(&(job->msgQue), NULL);
+    /* reclaim any workers that retired on their own */
+    RcmServer_reapWorkers_P(pool);
 
-    /* put new job stream object at end of server list */
-    List_put(obj->jobList, (List_Elem *)job);
+    /* free up pool resources */
+    semThreadH = SemThread_Handle_downCast(pool->sem);
+    SemThread_delete(&semThreadH);
+    List_destruct(&(pool->threadList));
+    List_destruct(&(pool->retired));
 
-    /* leave critical section */
-    GateThread_leave(gateH, key);
+    /* return any remaining messages on the readyQueue */
+    while ((packet = RcmServer_getReady_I(pool)) != NULL) {
+        Log_warning2(
+            FXNN": returning unprocessed message, msgId=0x%x, packet=0x%x",
+            (IArg)packet->msgId, (IArg)packet);
 
-    /* return new job id */
-    *jobIdPtr = jobId;
+        RcmServer_setStatusCode_I(packet, RcmServer_Status_Unprocessed);
+        RcmServer_reply_P(obj, packet, FALSE);
+#if USE_MESSAGEQCOPY
+        RcmServer_freePacket_I(obj, packet);
+#endif
+    }
+    RcmServer_flushReplies_I(obj);
 
+    for (i = 0; i < RcmClient_Desc_NUMPRI; i++) {
+        List_destruct(&(pool->readyQueue[i]));
+    }
 
 leave:
-    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
     return(status);
 }
 #undef FXNN
 
 
 /*
- *  ======== RcmServer_dispatch_P ========
- *
- *  Return Value
- *      < 0: error
- *        0: success, job stream queue
- *      > 0: success, ready queue
- *
- *  Pool id description
- *
- *  Static Worker Pools
- *  --------------------------------------------------------------------
- *  15      1 = static pool
- *  14:8    reserved
- *  7:0     offset: 0 - 255
+ *  ======== RcmServer_createPool ========
  *
- *  Dynamic Worker Pools
- *  --------------------------------------------------------------------
- *  15      0 = dynamic pool
- *  14:7    key: 0 - 255
- *  6:5     index: 1 - 3
- *  4:0     offset: 0 - [7, 15, 31]
+ *  Dynamic pools live in poolMap[1 - 3], which hold 8, 16 and 32 pools.
+ *  A deleted pool's key is cleared, so stale pool ids are rejected.
  */
-#define FXNN "RcmServer_dispatch_P"
-Int RcmServer_dispatch_P(RcmServer_Object *obj, RcmClient_Packet *packet)
+#define FXNN "RcmServer_createPool"
+Int RcmServer_createPool(RcmServer_Object *obj,
+        const RcmServer_ThreadPoolDesc *desc, UInt16 *poolId)
 {
     GateThread_Handle gateH;
     IArg key;
-    List_Elem *elem;
-    List_Handle listH;
-    RcmServer_ThreadPool *pool;
-    UInt16 jobId;
-    RcmServer_JobStream *job;
     Error_Block eb;
+    SemThread_Params semThreadP;
+    SemThread_Handle semThreadH;
+    RcmServer_ThreadPool *pool = NULL;
+    UInt i, j, k, tabLen;
+#if USE_MESSAGEQCOPY
+    UInt pktShare;
+#endif
+    Int rval;
     Int status = RcmServer_S_SUCCESS;
 
 
-    Log_print2(Diags_ENTRY,
-        "--> "FXNN": (obj=0x%x, packet=0x%x)", (IArg)obj, (IArg)packet);
+    Log_print3(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, desc=0x%x, poolId=0x%x)",
+        (IArg)obj, (IArg)desc, (IArg)poolId);
 
     Error_init(&eb);
 
-    /* get the target pool id from the message */
-    status = RcmServer_getPool_P(obj, packet, &pool);
-
-    if (status < 0) {
+    if ((desc == NULL) || (poolId == NULL)) {
+        Log_error0(FXNN": invalid argument");
+        status = RcmServer_E_INVALIDARG;
         goto leave;
     }
 
-    System_printf("Rcm dispatch: p:%d j:%d f:%d l:%d\n",
-                  packet->message.poolId, packet->message.jobId,
-                  packet->message.fxnIdx, packet->message.dataSize);
-
-    /* discrete jobs go on the end of the ready queue */
-    jobId = packet->message.jobId;
+    /* protect the pool map while changing it */
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
 
-    if (jobId == RcmClient_DISCRETEJOBID) {
-        listH = List_handle(&pool->readyQueue);
-        List_put(listH, (List_Elem *)packet);
+    /* find an unused slot, allocating the next pool table if needed */
+    for (i = 1; i < RcmServer_POOL_MAP_LEN; i++) {
+        tabLen = RcmServer_poolTabLen(i);
 
-        /* dispatch a new worker thread */
-        Semaphore_post(pool->sem, &eb);
+        if (obj->poolMap[i] == NULL) {
+            obj->poolMap[i] = xdc_runtime_Memory_calloc(RcmServer_Module_heap(),
+                tabLen * sizeof(RcmServer_ThreadPool), sizeof(Ptr), &eb);
 
-        if (Error_check(&eb)) {
-            Log_error0(FXNN": semaphore post failed");
+            if (Error_check(&eb)) {
+                Log_error0(FXNN": unable to allocate new pool table");
+                obj->poolMap[i] = NULL;
+                status = RcmServer_E_NOMEMORY;
+                GateThread_leave(gateH, key);
+                goto leave;
+            }
         }
-    }
-
-    /* must be a job stream message */
-    else {
-        /* must protect job list while searching it */
-        gateH = GateThread_handle(&obj->gate);
-        key = GateThread_enter(gateH);
 
-        /* find the job stream object in the list */
-        elem = NULL;
-        while ((elem = List_next(obj->jobList, elem)) != NULL) {
-            job = (RcmServer_JobStream *)elem;
-            if (job->jobId == jobId) {
+        for (j = 0; j < tabLen; j++) {
+            if ((obj->poolMap[i])[j].key == 0) {
+                pool = &(obj->poolMap[i])[j];
                 break;
             }
         }
 
-        if (elem == NULL) {
-            Log_error1(FXNN": failed to find jobId=%d", (IArg)jobId);
-            status = RcmServer_E_JobIdNotFound;
+        /* if new slot found, break out of loop */
+        if (pool != NULL) {
+            break;
         }
+    }
 
-        /* if job object is empty, place message directly on ready queue */
-        else if (job->empty) {
-            job->empty = FALSE;
-            listH = List_handle(&pool->readyQueue);
-            List_put(listH, (List_Elem *)packet);
+    if (pool == NULL) {
+        Log_error0(FXNN": cannot add pool, table is full");
+        status = RcmServer_E_POOLTABLEFULL;
+        GateThread_leave(gateH, key);
+        goto leave;
+    }
 
-            /* dispatch a new worker thread */
-            Semaphore_post(pool->sem, &eb);
+    /* reserve the slot, messages cannot reach it until it has a key */
+    pool->key = RcmServer_POOL_BUSY;
 
-            if (Error_check(&eb)) {
-                Log_error0(FXNN": semaphore post failed");
-            }
+    GateThread_leave(gateH, key);
+
+    /* initialize the pool */
+    pool->name = NULL;
+    pool->count = desc->count;
+    pool->maxCount = desc->maxCount;
+    pool->growDepth = desc->growDepth;
+    pool->idleTimeout = desc->idleTimeout;
+    pool->live = 0;
+    pool->queued = 0;
+    pool->growing = FALSE;
+    pool->pktShare = 0;
+    pool->priority = desc->priority;
+    pool->osPriority = desc->osPriority;
+    pool->maxOsPriority = desc->maxOsPriority;
+    pool->stackSize = desc->stackSize;
+    pool->stackSeg = NULL;
+    List_construct(&(pool->threadList), NULL);
+    for (k = 0; k < RcmClient_Desc_NUMPRI; k++) {
+        List_construct(&(pool->readyQueue[k]), NULL);
+    }
+    List_construct(&(pool->retired), NULL);
+
+    SemThread_Params_init(&semThreadP);
+    semThreadP.mode = SemThread_Mode_COUNTING;
+    semThreadH = SemThread_create(0, &semThreadP, &eb);
+
+    if (Error_check(&eb)) {
+        Log_error0(FXNN": could not create semaphore");
+        List_destruct(&(pool->threadList));
+        for (k = 0; k < RcmClient_Desc_NUMPRI; k++) {
+            List_destruct(&(pool->readyQueue[k]));
         }
+        List_destruct(&(pool->retired));
+        pool->key = 0;
+        status = RcmServer_E_FAIL;
+        goto leave;
+    }
+    pool->sem = SemThread_Handle_upCast(semThreadH);
 
-        /* place message on job queue */
+    if (desc->name != NULL) {
+        pool->name = xdc_runtime_Memory_alloc(RcmServer_Module_heap(),
+            _strlen(desc->name) + 1, sizeof(Char *), &eb);
+
+        if (Error_check(&eb)) {
+            pool->name = NULL;
+            status = RcmServer_E_NOMEMORY;
+        }
         else {
-            listH = List_handle(&job->msgQue);
-            List_put(listH, (List_Elem *)packet);
+            _strcpy(pool->name, desc->name);
+        }
+    }
+
+    /* create the worker threads */
+    while ((status >= 0) && (pool->live < pool->count)) {
+        status = RcmServer_addWorker_P(obj, pool);
+    }
+
+    /* undo a partially created pool */
+    if (status < 0) {
+        rval = RcmServer_finalizePool_P(obj, pool);
+
+        if (rval < 0) {
+            Log_error1(FXNN": pool cleanup failed, 0x%x", (IArg)rval);
         }
+        if (pool->name != NULL) {
+            xdc_runtime_Memory_free(RcmServer_Module_heap(), pool->name,
+                _strlen(pool->name) + 1);
+        }
+        pool->key = 0;
+        goto leave;
+    }
+
+#if USE_MESSAGEQCOPY
+    /* give the pool its share of packets, reusing those of deleted pools */
+    if (obj->pktAuto) {
+        pktShare = RcmServer_poolPkts(pool);
 
+        key = GateThread_enter(gateH);
+        pool->pktShare = (obj->pktSpare < pktShare ? obj->pktSpare : pktShare);
+        obj->pktSpare -= pool->pktShare;
         GateThread_leave(gateH, key);
+
+        /* not fatal, the pool just competes for the packets it has */
+        if (pktShare > pool->pktShare) {
+            rval = RcmServer_addPackets_P(obj, pktShare - pool->pktShare);
+
+            if (rval < 0) {
+                Log_warning1(FXNN": packet pool not grown, pool=0x%x",
+                    (IArg)pool);
+            }
+            else {
+                pool->pktShare = pktShare;
+            }
+        }
     }
+#endif
+
+    /* publish the pool under a new key, 0 is never used as a key */
+    key = GateThread_enter(gateH);
+    obj->poolKey = (obj->poolKey >= 0xFF ? 1 : obj->poolKey + 1);
+    pool->key = obj->poolKey;
+    GateThread_leave(gateH, key);
 
+    /* key:14-7, index:6-5, offset:4-0 */
+    *poolId = (pool->key << 7) | (i << 5) | j;
 
 leave:
     Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
@@ -1508,191 +1993,184 @@ leave:
 
 
 /*
- *  ======== RcmServer_execMsg_I ========
+ *  ======== RcmServer_deletePool ========
  */
-Int RcmServer_execMsg_I(RcmServer_Object *obj, RcmClient_Message *msg)
+#define FXNN "RcmServer_deletePool"
+Int RcmServer_deletePool(RcmServer_Object *obj, UInt16 poolId)
 {
-    RcmServer_MsgFxn fxn;
-#if USE_MESSAGEQCOPY
-    RcmServer_MsgCreateFxn createFxn = NULL;
-#endif
-    Int status;
+    GateThread_Handle gateH;
+    IArg key;
+    RcmServer_ThreadPool *pool;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print2(Diags_ENTRY, "--> "FXNN": (obj=0x%x, poolId=0x%x)",
+        (IArg)obj, (IArg)poolId);
+
+    /* static pools persist for the life of the server */
+    if (poolId & 0x8000) {
+        Log_error1(FXNN": cannot delete static pool 0x%x", (IArg)poolId);
+        status = RcmServer_E_INVALIDARG;
+        goto leave;
+    }
+
+    /* clear the key so new messages can no longer reach the pool */
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
 
-    status = RcmServer_getFxnAddr_P(obj, msg->fxnIdx, &fxn, &createFxn);
+    status = RcmServer_getPool_P(obj, poolId, &pool);
 
     if (status >= 0) {
-#if 0
-        System_printf("RcmServer_execMsg_I: Calling fxnIdx: %d\n",
-                      (msg->fxnIdx & 0x0000FFFF));
-#endif
+        pool->key = RcmServer_POOL_BUSY;
+    }
+
+    GateThread_leave(gateH, key);
+
+    if (status < 0) {
+        status = RcmServer_E_POOLNOTFOUND;
+        goto leave;
+    }
+
+    /* stop the workers and return any messages still queued */
+    status = RcmServer_finalizePool_P(obj, pool);
+
+    if (pool->name != NULL) {
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), pool->name,
+            _strlen(pool->name) + 1);
+        pool->name = NULL;
+    }
+
+    /* the slot can now be reused, its packets by the next pool created */
+    key = GateThread_enter(gateH);
 #if USE_MESSAGEQCOPY
-        if (createFxn)  {
-            msg->result = (*createFxn)(obj, msg->dataSize, msg->data);
-        }
-        else {
-            msg->result = (*fxn)(msg->dataSize, msg->data);
-        }
-#else
-        msg->result = (*fxn)(msg->dataSize, msg->data);
+    obj->pktSpare += pool->pktShare;
+    pool->pktShare = 0;
 #endif
-    }
+    pool->key = 0;
+    GateThread_leave(gateH, key);
 
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
     return(status);
 }
+#undef FXNN
 
 
 /*
- *  ======== RcmServer_getFxnAddr_P ========
- *
- *  The function index (fxnIdx) uses the following format. Note that the
- *  format differs for static vs. dynamic functions. All static functions
- *  are in fxnTab[0], all dynamic functions are in fxnTab[1 - 8].
- *
- *  Bits    Description
- *
- *  Static Function Index
- *  --------------------------------------------------------------------
- *  31      static/dynamic function flag
- *              0 = dynamic function
- *              1 = static function
- *  30:20   reserved
- *  19:16   reserved
- *  15:0    offset: 0 - 65,535
- *
- *  Dynamic Function Index
- *  --------------------------------------------------------------------
- *  31      static/dynamic function flag
- *              0 = dynamic function
- *              1 = static function
- *  30:20   key
- *  19:16   reserved
- *  15:12   index: 1 - 8
- *  11:0    offset: 0 - [31, 63, 127, 255, 511, 1023, 2047, 4095]
+ *  ======== RcmServer_addSymbol ========
  */
-#define FXNN "RcmServer_getFxnAddr_P"
-Int RcmServer_getFxnAddr_P(RcmServer_Object *obj, UInt32 fxnIdx,
-        RcmServer_MsgFxn *addrPtr, RcmServer_MsgCreateFxn *createPtr)
+#define FXNN "RcmServer_addSymbol"
+Int RcmServer_addSymbol(RcmServer_Object *obj, String funcName,
+        RcmServer_MsgFxn addr, UInt32 *index)
 {
+    GateThread_Handle gateH;
+    IArg key;
+    String name;
     UInt i, j;
-    UInt16 key;
+    UInt tabCount;
+    SizeT tabSize;
+    UInt32 fxnIdx = 0xFFFF;
     RcmServer_FxnTabElem *slot;
-    RcmServer_MsgFxn addr = NULL;
-    RcmServer_MsgCreateFxn createAddr = NULL;
+    RcmServer_FxnTabInfo *info;
+    Error_Block eb;
     Int status = RcmServer_S_SUCCESS;
 
-    /* static functions have bit-31 set */
-    if (fxnIdx & 0x80000000) {
-        j = (fxnIdx & 0x0000FFFF);
-        if (j < (obj->fxnTabStatic.length)) {
 
-            /* fetch the function address from the table */
-            slot = (obj->fxnTab[0])+j;
-            if (j == 0)  {
-                 createAddr = slot->addr.createFxn;
-            }
-            else {
-                 addr = slot->addr.fxn;
-            }
-        }
-        else {
-            Log_error1(FXNN": invalid function index 0x%x", (IArg)fxnIdx);
-            status = RcmServer_E_InvalidFxnIdx;
-            goto leave;
-        }
-    }
-    /* must be a dynamic function */
-    else {
-        /* extract the key from the function index */
-        key = (fxnIdx & _RCM_KeyMask) >> _RCM_KeyShift;
+    Log_print3(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, name=0x%x, addr=0x%x)",
+        (IArg)obj, (IArg)funcName, (IArg)addr);
 
-        i = (fxnIdx & 0xF000) >> 12;
-        if ((i > 0) && (i < RcmServer_MAX_TABLES) && (obj->fxnTab[i] != NULL)) {
+    Error_init(&eb);
 
-            /* fetch the function address from the table */
-            j = (fxnIdx & 0x0FFF);
-            slot = (obj->fxnTab[i])+j;
-            addr = slot->addr.fxn;
+    /* protect the symbol table while changing it */
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
 
-            /* validate the key */
-            if (key != slot->key) {
-                Log_error1(FXNN": invalid function index 0x%x", (IArg)fxnIdx);
-                status = RcmServer_E_InvalidFxnIdx;
+    /* find the first table with a free slot */
+    for (i = 1; i < RcmServer_MAX_TABLES; i++) {
+        if (obj->fxnTab[i] == NULL) {
+            /* all previous tables are full, allocate a new table */
+            tabCount = (1 << (i + 4));
+            tabSize = tabCount * sizeof(RcmServer_FxnTabElem);
+            obj->fxnTab[i] = (RcmServer_FxnTabElem *)xdc_runtime_Memory_alloc(
+                RcmServer_Module_heap(), tabSize, sizeof(Ptr), &eb);
+
+            if (Error_check(&eb)) {
+                Log_error0(FXNN": unable to allocate new function table");
+                obj->fxnTab[i] = NULL;
+                status = RcmServer_E_NOMEMORY;
                 goto leave;
             }
-        }
-        else {
-            Log_error1(FXNN": invalid function index 0x%x", (IArg)fxnIdx);
-            status = RcmServer_E_InvalidFxnIdx;
-            goto leave;
-        }
-    }
-
-leave:
-    if (status >= 0) {
-       if (j == 0)  {
-           *createPtr = createAddr;
-       }
-       else {
-           *addrPtr = addr;
-       }
-    }
-    return(status);
-}
-#undef FXNN
-
-
-/* *  ======== RcmServer_getSymIdx_P ========
- *
- *  Must have table gate before calling this function.
- */
-#define FXNN "RcmServer_getSymIdx_P"
-Int RcmServer_getSymIdx_P(RcmServer_Object *obj, String name, UInt32 *index)
-{
-    UInt i, j, len;
-    RcmServer_FxnTabElem *slot;
-    UInt32 fxnIdx = 0xFFFFFFFF;
-    Int status = RcmServer_S_SUCCESS;
 
+            tabSize = tabCount * sizeof(RcmServer_FxnTabInfo);
+            obj->fxnInfo[i] = (RcmServer_FxnTabInfo *)xdc_runtime_Memory_alloc(
+                RcmServer_Module_heap(), tabSize, sizeof(Ptr), &eb);
 
-    Log_print3(Diags_ENTRY,
-        "--> "FXNN": (obj=0x%x, name=0x%x, index=0x%x)",
-        (IArg)obj, (IArg)name, (IArg)index);
+            if (Error_check(&eb)) {
+                Log_error0(FXNN": unable to allocate new function table");
+                xdc_runtime_Memory_free(RcmServer_Module_heap(),
+                    obj->fxnTab[i], tabCount * sizeof(RcmServer_FxnTabElem));
+                obj->fxnTab[i] = NULL;
+                obj->fxnInfo[i] = NULL;
+                status = RcmServer_E_NOMEMORY;
+                goto leave;
+            }
 
-    /* search tables for given function name */
-    for (i = 0; i < RcmServer_MAX_TABLES; i++) {
-        if (obj->fxnTab[i] != NULL) {
-            len = (i == 0) ? obj->fxnTabStatic.length : (1 << (i + 4));
-            for (j = 0; j < len; j++) {
-                slot = (obj->fxnTab[i]) + j;
-                if ((((obj->fxnTab[i])+j)->name != NULL) &&
-                    (_strcmp(((obj->fxnTab[i])+j)->name, name) == 0)) {
-                    /* found function name */
-                    if (i == 0) {
-                        fxnIdx = 0x80000000 | j;
-                    } else {
-                        fxnIdx = (slot->key << _RCM_KeyShift) | (i << 12) | j;
-                    }
-                    break;
-                }
+            /* initialize the new table, all slots on the free list */
+            for (j = 0; j < tabCount; j++) {
+                ((obj->fxnTab[i])+j)->addr.fxn = 0;
+                ((obj->fxnTab[i])+j)->key = 0;
+                ((obj->fxnInfo[i])+j)->name = NULL;
+                ((obj->fxnInfo[i])+j)->symNext =
+                    (j + 1 < tabCount ? j + 1 : RcmServer_SLOT_NONE);
             }
+            obj->fxnFree[i] = 0;
         }
 
-        if (0xFFFFFFFF != fxnIdx) {
+        /* if new slot found, break out of loop */
+        if (obj->fxnFree[i] != RcmServer_SLOT_NONE) {
             break;
         }
     }
 
-    /* log an error if the symbol was not found */
-    if (fxnIdx == 0xFFFFFFFF) {
-        Log_error0(FXNN": given symbol not found");
-        status = RcmServer_E_SYMBOLNOTFOUND;
+    /* error, no more room to add new symbol */
+    if (i == RcmServer_MAX_TABLES) {
+        Log_error0(FXNN": cannot add symbol, table is full");
+        status = RcmServer_E_SYMBOLTABLEFULL;
+        goto leave;
     }
 
-    /* if success, return symbol index */
+    j = obj->fxnFree[i];
+    slot = (obj->fxnTab[i]) + j;
+    info = (obj->fxnInfo[i]) + j;
+
+    /* copy the name into the arena, slot stays free on failure */
+    name = RcmServer_nameAlloc_P(obj, funcName, &eb);
+
+    if (name == NULL) {
+        Log_error0(FXNN": unable to allocate function name");
+        status = RcmServer_E_NOMEMORY;
+        goto leave;
+    }
+
+    /* take the slot off the free list and insert new symbol */
+    obj->fxnFree[i] = (UInt16)(info->symNext);
+    slot->addr.fxn = addr;
+    info->name = name;
+    _memset((Void *)&info->stats, 0, sizeof(info->stats));
+    slot->key = RcmServer_getNextKey_P(obj);
+    slot->flags = 0;
+    fxnIdx = (slot->key << _RCM_KeyShift) | (i << 12) | j;
+    RcmServer_symInsert_P(obj, fxnIdx);
+
+
+leave:
+    GateThread_leave(gateH, key);
+
+    /* on success, return new function index */
     if (status >= 0) {
         *index = fxnIdx;
     }
-
     Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
     return(status);
 }
@@ -1700,601 +2178,2093 @@ Int RcmServer_getSymIdx_P(RcmServer_Object *obj, String name, UInt32 *index)
 
 
 /*
- *  ======== RcmServer_getNextKey_P ========
+ *  ======== RcmServer_removeSymbol ========
  */
-UInt16 RcmServer_getNextKey_P(RcmServer_Object *obj)
+#define FXNN "RcmServer_removeSymbol"
+Int RcmServer_removeSymbol(RcmServer_Object *obj, String name)
 {
     GateThread_Handle gateH;
-    IArg gateKey;
-    UInt16 key;
+    IArg key;
+    UInt32 fxnIdx;
+    UInt tabIdx, tabOff;
+    RcmServer_FxnTabElem *slot;
+    RcmServer_FxnTabInfo *info;
+    Int status = RcmServer_S_SUCCESS;
 
 
+    Log_print2(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, name=0x%x)", (IArg)obj, (IArg)name);
+
+    /* protect the symbol table while changing it */
     gateH = GateThread_handle(&obj->gate);
-    gateKey = GateThread_enter(gateH);
+    key = GateThread_enter(gateH);
 
-    if (obj->key <= 1) {
-        obj->key = _RCM_KeyResetValue;  /* don't use 0 as a key value */
+    /* find the symbol in the table */
+    status = RcmServer_getSymIdx_P(obj, name, &fxnIdx);
+
+    if (status < 0) {
+        Log_error0(FXNN": given symbol not found");
+        goto leave;
     }
-    else {
-        (obj->key)--;
+
+    /* static symbols have bit-31 set, cannot remove these symbols */
+    if (fxnIdx & 0x80000000) {
+        Log_error0(FXNN": cannot remove static symbol");
+        status = RcmServer_E_SYMBOLSTATIC;
+        goto leave;
     }
-    key = obj->key;
 
-    GateThread_leave(gateH, gateKey);
+    /* drop the symbol from the name index */
+    RcmServer_symRemove_P(obj, fxnIdx);
 
-    return(key);
+    /* get slot pointers */
+    tabIdx = (fxnIdx & 0xF000) >> 12;
+    tabOff = (fxnIdx & 0xFFF);
+    slot = (obj->fxnTab[tabIdx]) + tabOff;
+    info = (obj->fxnInfo[tabIdx]) + tabOff;
+
+    /* clear the table index */
+    slot->addr.fxn = 0;
+    slot->key = 0;
+    info->name = NULL;
+
+    /* the arena is reclaimed once its last name is gone */
+    if (--obj->nameLive == 0) {
+        RcmServer_nameReset_P(obj);
+    }
+
+    /* return the slot to its table's free list */
+    info->symNext = obj->fxnFree[tabIdx];
+    obj->fxnFree[tabIdx] = (UInt16)tabOff;
+
+leave:
+    GateThread_leave(gateH, key);
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
 }
+#undef FXNN
 
 
 /*
- *  ======== RcmServer_getPool_P ========
+ *  ======== RcmServer_start ========
  */
-#define FXNN "RcmServer_getPool_P"
-Int RcmServer_getPool_P(RcmServer_Object *obj,
-        RcmClient_Packet *packet, RcmServer_ThreadPool **poolP)
+#define FXNN "RcmServer_start"
+Int RcmServer_start(RcmServer_Object *obj)
 {
-    UInt16 poolId;
-    UInt16 offset;
+    Error_Block eb;
+#if USE_MESSAGEQCOPY
+    Int i;
+#endif
     Int status = RcmServer_S_SUCCESS;
 
 
-    poolId = packet->message.poolId;
+    Log_print1(Diags_ENTRY, "--> "FXNN": (obj=0x%x)", (IArg)obj);
 
-    /* static pools have bit-15 set */
-    if (poolId & 0x8000) {
-        offset = (poolId & 0x00FF);
-        if (offset < obj->poolMap0Len) {
-            *poolP = &(obj->poolMap[0])[offset];
-        }
-        else {
-            Log_error1(FXNN": pool id=0x%x not found", (IArg)poolId);
-            *poolP = NULL;
-            status = RcmServer_E_PoolIdNotFound;
-            goto leave;
+    Error_init(&eb);
+
+#if USE_MESSAGEQCOPY
+    /* let the receive Swi run calls to non-blocking functions itself */
+    for (i = 0; i < obj->fxnTabStatic.length; i++) {
+        if (obj->fxnTabStatic.elem[i].flags & RcmServer_FxnFlag_NONBLOCKING) {
+            MessageQCopy_setRecvFxn(obj->serverQue, RcmServer_swiRecv_P,
+                (UArg)obj);
+            break;
         }
     }
+#endif
 
-leave:
+    /* unblock the server thread */
+    Semaphore_post(obj->run, &eb);
+
+    if (Error_check(&eb)) {
+        Log_error0(FXNN": semaphore post failed");
+        status = RcmServer_E_FAIL;
+    }
+
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
     return(status);
 }
 #undef FXNN
 
 
 /*
- *  ======== RcmServer_process_P ========
+ *  ======== RcmServer_acqJobId_P ========
  */
-#define FXNN "RcmServer_process_P"
-Void RcmServer_process_P(RcmServer_Object *obj, RcmClient_Packet *packet)
+#define FXNN "RcmServer_acqJobId_P"
+Int RcmServer_acqJobId_P(RcmServer_Object *obj, UInt16 *jobIdPtr)
 {
-    String name;
-    UInt32 fxnIdx;
-    RcmServer_MsgFxn fxn;
-    RcmClient_Message *rcmMsg;
-#if USE_MESSAGEQCOPY
-    RcmServer_MsgCreateFxn createFxn = NULL;
-#endif
-#if USE_MESSAGEQCOPY == 0
-    MessageQ_Msg msgqMsg;
-#endif
-    UInt16 messageType;
     Error_Block eb;
+    GateThread_Handle gateH;
+    IArg key;
+    Int count;
     UInt16 jobId;
-    Int rval;
+    RcmServer_JobStream *job;
     Int status = RcmServer_S_SUCCESS;
 
 
     Log_print2(Diags_ENTRY,
-        "--> "FXNN": (obj=0x%x, packet=0x%x)", (IArg)obj, (IArg)packet);
+        "--> "FXNN": (obj=0x%x, jobIdPtr=0x%x)", (IArg)obj, (IArg)jobIdPtr);
 
     Error_init(&eb);
+    gateH = GateThread_handle(&obj->gate);
 
-    /* decode the message */
-    rcmMsg = &packet->message;
-#if USE_MESSAGEQCOPY == 0
+    /* enter critical section */
+    key = GateThread_enter(gateH);
+
+    /* compute new job id, ids rotate so a collision is rare */
+    for (count = 0xFFFF; count > 0; count--) {
+
+        /* generate a new job id */
+        jobId = (obj->jobId == 0xFFFF ? obj->jobId = 1 : ++(obj->jobId));
+
+        /* verify job id is not in use */
+        if (RcmServer_findJob_I(obj, jobId) == NULL) {
+            break;
+        }
+        jobId = RcmClient_DISCRETEJOBID;
+    }
+
+    /* check if job id was acquired */
+    if (jobId == RcmClient_DISCRETEJOBID) {
+        *jobIdPtr = RcmClient_DISCRETEJOBID;
+        Log_error0(FXNN": no job id available");
+        status = RcmServer_E_FAIL;
+        GateThread_leave(gateH, key);
+        goto leave;
+    }
+
+    /* create a new job steam object */
+    job = xdc_runtime_Memory_alloc(RcmServer_Module_heap(),
+        sizeof(RcmServer_JobStream), sizeof(Ptr), &eb);
+
+    if (Error_check(&eb)) {
+        Log_error2(FXNN": out of memory: heap=0x%x, size=%u",
+            (IArg)RcmServer_Module_heap(), sizeof(RcmServer_JobStream));
+        status = RcmServer_E_NOMEMORY;
+        GateThread_leave(gateH, key);
+        goto leave;
+    }
+
+    /* initialize new job stream object */
+    job->jobId = jobId;
+    job->empty = TRUE;
+    List_construct(&(job->msgQue), NULL);
+
+    /* put new job stream object at head of its hash bucket */
+    job->next = obj->jobTab[RcmServer_jobBucket(jobId)];
+    obj->jobTab[RcmServer_jobBucket(jobId)] = job;
+
+    /* leave critical section */
+    GateThread_leave(gateH, key);
+
+    /* return new job id */
+    *jobIdPtr = jobId;
+
+
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_dispatch_P ========
+ *
+ *  Return Value
+ *      < 0: error
+ *        0: success, job stream queue
+ *      > 0: success, ready queue
+ *
+ *  Pool id description
+ *
+ *  Static Worker Pools
+ *  --------------------------------------------------------------------
+ *  15      1 = static pool
+ *  14:8    reserved
+ *  7:0     offset: 0 - 255
+ *
+ *  Dynamic Worker Pools
+ *  --------------------------------------------------------------------
+ *  15      0 = dynamic pool
+ *  14:7    key: 0 - 255
+ *  6:5     index: 1 - 3
+ *  4:0     offset: 0 - [7, 15, 31]
+ */
+#define FXNN "RcmServer_dispatch_P"
+Int RcmServer_dispatch_P(RcmServer_Object *obj, RcmClient_Packet *packet)
+{
+    GateThread_Handle gateH;
+    IArg key;
+    IArg poolKey = 0;
+    Bool dynamic;
+    List_Handle listH;
+    RcmServer_ThreadPool *pool;
+    UInt16 jobId;
+    RcmServer_JobStream *job;
+    Error_Block eb;
+    Bool grow = FALSE;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print2(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, packet=0x%x)", (IArg)obj, (IArg)packet);
+
+    Error_init(&eb);
+    gateH = GateThread_handle(&obj->gate);
+
+    /* a dynamic pool may be deleted, hold the gate until the message
+     * is queued so that the pool cannot go away underneath it */
+    dynamic = ((packet->message.poolId & 0x8000) == 0);
+
+    if (dynamic) {
+        poolKey = GateThread_enter(gateH);
+    }
+
+    /* get the target pool id from the message */
+    status = RcmServer_getPool_P(obj, packet->message.poolId, &pool);
+
+    if (status < 0) {
+        goto leave;
+    }
+
+#if USE_MESSAGEQCOPY
+    /* do not queue a message its client has already given up on */
+    if (RcmServer_expired_I(packet)) {
+        status = RcmServer_E_Expired;
+        goto leave;
+    }
+
+    EventLog_write4(EventLog_RCM_DISPATCH, packet->message.poolId,
+        packet->message.jobId, packet->message.fxnIdx,
+        packet->message.dataSize);
+#else
+    Log_print4(Diags_INFO, FXNN": pool=%d job=%d fxn=0x%x size=%d",
+        (IArg)packet->message.poolId, (IArg)packet->message.jobId,
+        (IArg)packet->message.fxnIdx, (IArg)packet->message.dataSize);
+#endif
+
+    /* discrete jobs go on the end of the ready queue */
+    jobId = packet->message.jobId;
+
+    if (jobId == RcmClient_DISCRETEJOBID) {
+        grow = RcmServer_enqueue_P(obj, pool, packet);
+    }
+
+    /* must be a job stream message */
+    else {
+        /* must protect job table while searching it */
+        key = GateThread_enter(gateH);
+
+        /* find the job stream object in the table */
+        job = RcmServer_findJob_I(obj, jobId);
+
+        if (job == NULL) {
+            Log_error1(FXNN": failed to find jobId=%d", (IArg)jobId);
+            status = RcmServer_E_JobIdNotFound;
+        }
+
+        /* if job object is empty, place message directly on ready queue */
+        else if (job->empty) {
+            job->empty = FALSE;
+            grow = RcmServer_enqueue_P(obj, pool, packet);
+        }
+
+        /* place message on job queue */
+        else {
+            listH = List_handle(&job->msgQue);
+            List_put(listH, (List_Elem *)packet);
+        }
+
+        GateThread_leave(gateH, key);
+    }
+
+
+leave:
+    if (dynamic) {
+        GateThread_leave(gateH, poolKey);
+    }
+
+    /* add a worker thread outside the gate */
+    if (grow) {
+        RcmServer_growPool_P(obj, pool);
+    }
+
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_execMsg_I ========
+ */
+Int RcmServer_execMsg_I(RcmServer_Object *obj, RcmClient_Packet *packet)
+{
+    RcmClient_Message *msg = &packet->message;
+
+#if USE_MESSAGEQCOPY
+    if (packet->desc & RcmClient_Desc_PTRARGS) {
+        return(RcmServer_execPtrMsg_P(obj, msg));
+    }
+#endif
+
+    return(RcmServer_execFxn_I(obj, msg->fxnIdx, msg->dataSize, msg->data,
+        &msg->result));
+}
+
+
+#if USE_MESSAGEQCOPY
+/*
+ *  ======== RcmServer_execPtrMsg_P ========
+ *
+ *  Execute a message whose payload is preceded by pointer descriptors.
+ *  Each described payload field holds a host physical address. It is
+ *  replaced by the device address for the duration of the call, with
+ *  cache maintenance on the referenced buffer around the call, and then
+ *  restored so the client gets back the payload it sent.
+ */
+#define FXNN "RcmServer_execPtrMsg_P"
+Int RcmServer_execPtrMsg_P(RcmServer_Object *obj, RcmClient_Message *msg)
+{
+    RcmClient_PtrArg *ptrArg;
+    UInt32 hostAddr[RcmClient_MAXPTRARGS];
+    UInt32 devAddr[RcmClient_MAXPTRARGS];
+    UInt32 *field;
+    UInt32 *payload;
+    UInt32 hdrSize;
+    UInt32 size;
+    UInt32 count;
+    UInt32 da;
+    UInt i;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    /* validate the descriptor table */
+    if (msg->dataSize < sizeof(UInt32)) {
+        return(RcmServer_E_InvalidPtrArg);
+    }
+
+    count = msg->data[0];
+    hdrSize = sizeof(UInt32) + (count * sizeof(RcmClient_PtrArg));
+
+    if ((count > RcmClient_MAXPTRARGS) || (hdrSize > msg->dataSize)) {
+        Log_error1(FXNN": bad pointer descriptor count %d", (IArg)count);
+        return(RcmServer_E_InvalidPtrArg);
+    }
+
+    ptrArg = (RcmClient_PtrArg *)&msg->data[1];
+    payload = (UInt32 *)((Char *)msg->data + hdrSize);
+    size = msg->dataSize - hdrSize;
+
+    /* translate the pointers, get the buffers out of the cache */
+    for (i = 0; i < count; i++) {
+        /* the pointer must fit in the payload, without the sum wrapping */
+        if ((ptrArg[i].offset & 3) || (size < sizeof(UInt32)) ||
+            (ptrArg[i].offset > size - sizeof(UInt32))) {
+            status = RcmServer_E_InvalidPtrArg;
+            break;
+        }
+
+        field = (UInt32 *)((Char *)payload + ptrArg[i].offset);
+        da = RcmServer_xlateAddr_I(*field, ptrArg[i].size);
+
+        if (da == 0) {
+            Log_error2(FXNN": address 0x%x size %d not in a host region",
+                (IArg)*field, (IArg)ptrArg[i].size);
+            status = RcmServer_E_InvalidPtrArg;
+            break;
+        }
+
+        hostAddr[i] = *field;
+        devAddr[i] = da;
+        *field = da;
+
+        if (ptrArg[i].flags & RcmClient_PtrArg_IN) {
+            Cache_inv((Ptr)da, ptrArg[i].size, Cache_Type_ALL, TRUE);
+        }
+    }
+
+    if (status >= 0) {
+        status = RcmServer_execFxn_I(obj, msg->fxnIdx, size, payload,
+            &msg->result);
+    }
+
+    /* write back what the function produced, restore the host addresses;
+     * the function may have changed the pointer in the payload, so use
+     * the address that was validated */
+    count = i;
+
+    for (i = 0; i < count; i++) {
+        field = (UInt32 *)((Char *)payload + ptrArg[i].offset);
+
+        if ((status >= 0) && (ptrArg[i].flags & RcmClient_PtrArg_OUT)) {
+            Cache_wb((Ptr)devAddr[i], ptrArg[i].size, Cache_Type_ALL, TRUE);
+        }
+
+        *field = hostAddr[i];
+    }
+
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_xlateAddr_I ========
+ *
+ *  Translate a host physical buffer to a device address. Returns 0 if
+ *  the buffer is not entirely inside one registered region.
+ */
+UInt32 RcmServer_xlateAddr_I(UInt32 pa, UInt32 size)
+{
+    RcmServer_MemRegion *r;
+    UInt i;
+
+    for (i = 0; i < RcmServer_Mod.memMapLen; i++) {
+        r = &RcmServer_Mod.memMap[i];
+
+        if ((pa >= r->pa) && ((pa - r->pa) < r->size) &&
+            (size <= (r->size - (pa - r->pa)))) {
+            return(r->da + (pa - r->pa));
+        }
+    }
+
+    return(0);
+}
+#endif
+
+
+/*
+ *  ======== RcmServer_execFxn_I ========
+ */
+Int RcmServer_execFxn_I(RcmServer_Object *obj, UInt32 fxnIdx,
+        UInt32 dataSize, UInt32 *data, Int32 *result)
+{
+    RcmServer_MsgFxn fxn;
+#if USE_MESSAGEQCOPY
+    RcmServer_MsgCreateFxn createFxn = NULL;
+#endif
+    RcmServer_FxnTabInfo *info;
+    UInt32 start;
+    UInt32 delta;
+    UInt b;
+    Int status;
+
+    status = RcmServer_getFxnAddr_P(obj, fxnIdx, &fxn, &createFxn, &info);
+
+    if (status >= 0) {
+        start = Timestamp_get32();
+#if 0
+        System_printf("RcmServer_execFxn_I: Calling fxnIdx: %d\n",
+                      (fxnIdx & 0x0000FFFF));
+#endif
+#if USE_MESSAGEQCOPY
+        if (createFxn)  {
+            *result = (*createFxn)(obj, dataSize, data);
+        }
+        else {
+            *result = (*fxn)(dataSize, data);
+        }
+#else
+        *result = (*fxn)(dataSize, data);
+#endif
+
+        /* unlocked; concurrent workers may lose the odd count */
+        delta = Timestamp_get32() - start;
+        b = RcmServer_latBucket_I(delta);
+        RcmServer_fxnStat_I(&info->stats, delta, *result);
+        info->stats.hist[b]++;
+        obj->latHist[RcmServer_LatStage_EXEC][b]++;
+    }
+
+    return(status);
+}
+
+
+/*
+ *  ======== RcmServer_execBatch_P ========
+ *
+ *  Execute each call record of a batch message in order. A failed call
+ *  does not stop the batch; its status code is stored in its record and
+ *  the packet status reports that at least one call failed. A malformed
+ *  record ends the batch with a general error.
+ */
+#define FXNN "RcmServer_execBatch_P"
+Void RcmServer_execBatch_P(RcmServer_Object *obj, RcmClient_Packet *packet)
+{
+    RcmClient_Message *rcmMsg;
+    RcmClient_BatchCall *call;
+    UInt8 *cursor;
+    UInt32 left;
+    UInt32 size;
+    UInt16 code = RcmServer_Status_SUCCESS;
+    Int32 count = 0;
+    Int rval;
+
+
+    Log_print2(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, packet=0x%x)", (IArg)obj, (IArg)packet);
+
+    rcmMsg = &packet->message;
+    cursor = (UInt8 *)rcmMsg->data;
+    left = rcmMsg->dataSize;
+
+    while (left > 0) {
+        call = (RcmClient_BatchCall *)cursor;
+
+        /* the record must fit in what is left of the buffer */
+        if (left < RcmClient_BatchCall_HDR_SIZE) {
+            code = RcmServer_Status_Error;
+            break;
+        }
+
+        size = RcmClient_BatchCall_SIZE(call->dataSize);
+
+        if (size > left) {
+            code = RcmServer_Status_Error;
+            break;
+        }
+
+        rval = RcmServer_execFxn_I(obj, call->fxnIdx, call->dataSize,
+            call->data, &call->result);
+
+        if (rval == RcmServer_E_InvalidFxnIdx) {
+            call->status = RcmServer_Status_INVALID_FXN;
+        }
+        else if (rval < 0) {
+            call->status = RcmServer_Status_Error;
+        }
+        else if (call->result < 0) {
+            call->status = RcmServer_Status_MSG_FXN_ERR;
+        }
+        else {
+            call->status = RcmServer_Status_SUCCESS;
+        }
+
+        if (call->status != RcmServer_Status_SUCCESS) {
+            code = RcmServer_Status_MSG_FXN_ERR;
+        }
+
+        count++;
+        cursor += size;
+        left -= size;
+    }
+
+    if (code == RcmServer_Status_Error) {
+        Log_error1(FXNN": malformed batch record, offset=%d",
+            (IArg)(rcmMsg->dataSize - left));
+    }
+
+    rcmMsg->result = count;
+    RcmServer_setStatusCode_I(packet, code);
+
+    Log_print1(Diags_EXIT, "<-- "FXNN": count=%d", (IArg)count);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_getFxnAddr_P ========
+ *
+ *  The function index (fxnIdx) uses the following format. Note that the
+ *  format differs for static vs. dynamic functions. All static functions
+ *  are in fxnTab[0], all dynamic functions are in fxnTab[1 - 8].
+ *
+ *  Bits    Description
+ *
+ *  Static Function Index
+ *  --------------------------------------------------------------------
+ *  31      static/dynamic function flag
+ *              0 = dynamic function
+ *              1 = static function
+ *  30:20   reserved
+ *  19:16   reserved
+ *  15:0    offset: 0 - 65,535
+ *
+ *  Dynamic Function Index
+ *  --------------------------------------------------------------------
+ *  31      static/dynamic function flag
+ *              0 = dynamic function
+ *              1 = static function
+ *  30:20   key
+ *  19:16   reserved
+ *  15:12   index: 1 - 8
+ *  11:0    offset: 0 - [31, 63, 127, 255, 511, 1023, 2047, 4095]
+ */
+#define FXNN "RcmServer_getFxnAddr_P"
+Int RcmServer_getFxnAddr_P(RcmServer_Object *obj, UInt32 fxnIdx,
+        RcmServer_MsgFxn *addrPtr, RcmServer_MsgCreateFxn *createPtr,
+        RcmServer_FxnTabInfo **infoPtr)
+{
+    UInt i, j;
+    UInt16 key;
+    RcmServer_FxnTabElem *slot;
+    RcmServer_MsgFxn addr = NULL;
+    RcmServer_MsgCreateFxn createAddr = NULL;
+    Int status = RcmServer_S_SUCCESS;
+
+    /* static functions have bit-31 set */
+    if (fxnIdx & 0x80000000) {
+        i = 0;
+        j = (fxnIdx & 0x0000FFFF);
+        if (j < (obj->fxnTabStatic.length)) {
+
+            /* fetch the function address from the table */
+            slot = (obj->fxnTab[0])+j;
+            if (j == 0)  {
+                 createAddr = slot->addr.createFxn;
+            }
+            else {
+                 addr = slot->addr.fxn;
+            }
+        }
+        else {
+            Log_error1(FXNN": invalid function index 0x%x", (IArg)fxnIdx);
+            status = RcmServer_E_InvalidFxnIdx;
+            goto leave;
+        }
+    }
+    /* must be a dynamic function */
+    else {
+        /* extract the key from the function index */
+        key = (fxnIdx & _RCM_KeyMask) >> _RCM_KeyShift;
+
+        i = (fxnIdx & 0xF000) >> 12;
+        if ((i > 0) && (i < RcmServer_MAX_TABLES) && (obj->fxnTab[i] != NULL)) {
+
+            /* fetch the function address from the table */
+            j = (fxnIdx & 0x0FFF);
+            slot = (obj->fxnTab[i])+j;
+            addr = slot->addr.fxn;
+
+            /* validate the key */
+            if (key != slot->key) {
+                Log_error1(FXNN": invalid function index 0x%x", (IArg)fxnIdx);
+                status = RcmServer_E_InvalidFxnIdx;
+                goto leave;
+            }
+        }
+        else {
+            Log_error1(FXNN": invalid function index 0x%x", (IArg)fxnIdx);
+            status = RcmServer_E_InvalidFxnIdx;
+            goto leave;
+        }
+    }
+
+leave:
+    if (status >= 0) {
+       if (j == 0)  {
+           *createPtr = createAddr;
+       }
+       else {
+           *addrPtr = addr;
+       }
+       if (infoPtr != NULL) {
+           *infoPtr = (obj->fxnInfo[i]) + j;
+       }
+    }
+    return(status);
+}
+#undef FXNN
+
+
+/* *  ======== RcmServer_getSymIdx_P ========
+ *
+ *  Must have table gate before calling this function.
+ */
+#define FXNN "RcmServer_getSymIdx_P"
+Int RcmServer_getSymIdx_P(RcmServer_Object *obj, String name, UInt32 *index)
+{
+    RcmServer_FxnTabInfo *info;
+    UInt32 fxnIdx;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print3(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, name=0x%x, index=0x%x)",
+        (IArg)obj, (IArg)name, (IArg)index);
+
+    /* walk the hash chain for the given function name */
+    fxnIdx = obj->symTab[RcmServer_symHash_I(name)];
+
+    while (fxnIdx != RcmServer_SYM_NONE) {
+        info = RcmServer_getInfo_I(obj, fxnIdx);
+
+        if (_strcmp(info->name, name) == 0) {
+            break;  /* found function name */
+        }
+        fxnIdx = info->symNext;
+    }
+
+    /* log an error if the symbol was not found */
+    if (fxnIdx == RcmServer_SYM_NONE) {
+        Log_error0(FXNN": given symbol not found");
+        status = RcmServer_E_SYMBOLNOTFOUND;
+    }
+
+    /* if success, return symbol index */
+    if (status >= 0) {
+        *index = fxnIdx;
+    }
+
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_getInfo_I ========
+ *
+ *  Map a valid function index to its name and statistics entry.
+ */
+RcmServer_FxnTabInfo *RcmServer_getInfo_I(RcmServer_Object *obj,
+        UInt32 fxnIdx)
+{
+    /* static symbols have bit-31 set */
+    if (fxnIdx & 0x80000000) {
+        return((obj->fxnInfo[0]) + (fxnIdx & 0xFFFF));
+    }
+    return((obj->fxnInfo[(fxnIdx & 0xF000) >> 12]) + (fxnIdx & 0xFFF));
+}
+
+
+/*
+ *  ======== RcmServer_symHash_I ========
+ */
+UInt RcmServer_symHash_I(String name)
+{
+    UInt32 h = 5381;
+
+    while (*name != '\0') {
+        h = (h << 5) + h + (UInt8)(*name++);
+    }
+    return(h & (RcmServer_SYM_TAB_LEN - 1));
+}
+
+
+/*
+ *  ======== RcmServer_symInsert_P ========
+ *
+ *  Must have table gate before calling this function.
+ */
+Void RcmServer_symInsert_P(RcmServer_Object *obj, UInt32 fxnIdx)
+{
+    RcmServer_FxnTabInfo *info;
+    UInt b;
+
+
+    info = RcmServer_getInfo_I(obj, fxnIdx);
+    b = RcmServer_symHash_I(info->name);
+
+    info->symNext = obj->symTab[b];
+    obj->symTab[b] = fxnIdx;
+}
+
+
+/*
+ *  ======== RcmServer_symRemove_P ========
+ *
+ *  Must have table gate before calling this function.
+ */
+Void RcmServer_symRemove_P(RcmServer_Object *obj, UInt32 fxnIdx)
+{
+    RcmServer_FxnTabInfo *info;
+    UInt32 *link;
+
+
+    info = RcmServer_getInfo_I(obj, fxnIdx);
+    link = &obj->symTab[RcmServer_symHash_I(info->name)];
+
+    while (*link != RcmServer_SYM_NONE) {
+        if (*link == fxnIdx) {
+            *link = info->symNext;
+            break;
+        }
+        link = &(RcmServer_getInfo_I(obj, *link)->symNext);
+    }
+    info->symNext = RcmServer_SYM_NONE;
+}
+
+
+/*
+ *  ======== RcmServer_nameAlloc_P ========
+ *
+ *  Copy a dynamic symbol name into the server's name arena. Names are
+ *  bump allocated from the newest chunk; a new chunk is added when it
+ *  fills up. Must have table gate before calling this function.
+ */
+String RcmServer_nameAlloc_P(RcmServer_Object *obj, String name,
+        Error_Block *eb)
+{
+    RcmServer_NameChunk *chunk;
+    SizeT len, size;
+    Char *cp;
+
+
+    len = _strlen(name) + 1;
+    chunk = obj->nameArena;
+
+    if ((chunk == NULL) || ((chunk->size - chunk->used) < len)) {
+        size = (len > RcmServer_NAME_CHUNK ? len : RcmServer_NAME_CHUNK);
+        chunk = (RcmServer_NameChunk *)xdc_runtime_Memory_alloc(
+            RcmServer_Module_heap(), sizeof(RcmServer_NameChunk) + size,
+            sizeof(Ptr), eb);
+
+        if (Error_check(eb)) {
+            return(NULL);
+        }
+
+        chunk->next = obj->nameArena;
+        chunk->size = size;
+        chunk->used = 0;
+        obj->nameArena = chunk;
+    }
+
+    cp = (Char *)(chunk + 1) + chunk->used;
+    chunk->used += len;
+    _strcpy(cp, name);
+    obj->nameLive++;
+
+    return(cp);
+}
+
+
+/*
+ *  ======== RcmServer_nameReset_P ========
+ *
+ *  Free every chunk of the name arena. Must have table gate before calling
+ *  this function.
+ */
+Void RcmServer_nameReset_P(RcmServer_Object *obj)
+{
+    RcmServer_NameChunk *chunk;
+
+
+    while ((chunk = obj->nameArena) != NULL) {
+        obj->nameArena = chunk->next;
+        xdc_runtime_Memory_free(RcmServer_Module_heap(), (Ptr)chunk,
+            sizeof(RcmServer_NameChunk) + chunk->size);
+    }
+    obj->nameLive = 0;
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_getNextKey_P ========
+ */
+UInt16 RcmServer_getNextKey_P(RcmServer_Object *obj)
+{
+    GateThread_Handle gateH;
+    IArg gateKey;
+    UInt16 key;
+
+
+    gateH = GateThread_handle(&obj->gate);
+    gateKey = GateThread_enter(gateH);
+
+    if (obj->key <= 1) {
+        obj->key = _RCM_KeyResetValue;  /* don't use 0 as a key value */
+    }
+    else {
+        (obj->key)--;
+    }
+    key = obj->key;
+
+    GateThread_leave(gateH, gateKey);
+
+    return(key);
+}
+
+
+/*
+ *  ======== RcmServer_getPool_P ========
+ *
+ *  Dynamic pools can be deleted at any time, so for a dynamic pool id the
+ *  caller must hold the server gate until it is done with the pool.
+ */
+#define FXNN "RcmServer_getPool_P"
+Int RcmServer_getPool_P(RcmServer_Object *obj, UInt16 poolId,
+        RcmServer_ThreadPool **poolP)
+{
+    UInt16 offset;
+    UInt16 index;
+    UInt16 key;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    /* static pools have bit-15 set */
+    if (poolId & 0x8000) {
+        offset = (poolId & 0x00FF);
+        if (offset < obj->poolMap0Len) {
+            *poolP = &(obj->poolMap[0])[offset];
+        }
+        else {
+            Log_error1(FXNN": pool id=0x%x not found", (IArg)poolId);
+            *poolP = NULL;
+            status = RcmServer_E_PoolIdNotFound;
+            goto leave;
+        }
+    }
+
+    /* must be a dynamic pool */
+    else {
+        key = (poolId & 0x7F80) >> 7;
+        index = (poolId & 0x0060) >> 5;
+        offset = (poolId & 0x001F);
+
+        if ((index > 0) && (obj->poolMap[index] != NULL)
+            && (offset < RcmServer_poolTabLen(index)) && (key != 0)
+            && ((obj->poolMap[index])[offset].key == key)) {
+            *poolP = &(obj->poolMap[index])[offset];
+        }
+        else {
+            Log_error1(FXNN": pool id=0x%x not found", (IArg)poolId);
+            *poolP = NULL;
+            status = RcmServer_E_PoolIdNotFound;
+            goto leave;
+        }
+    }
+
+leave:
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_process_P ========
+ *
+ *  Execute the given message and send its reply, if any. When kick is
+ *  FALSE the reply is left for the caller to flush with
+ *  RcmServer_flushReplies_I.
+ */
+#define FXNN "RcmServer_process_P"
+Void RcmServer_process_P(RcmServer_Object *obj, RcmClient_Packet *packet,
+        Bool kick)
+{
+    String name;
+    UInt32 fxnIdx;
+    RcmServer_MsgFxn fxn;
+    RcmClient_Message *rcmMsg;
+#if USE_MESSAGEQCOPY
+    RcmServer_MsgCreateFxn createFxn = NULL;
+#endif
+#if USE_MESSAGEQCOPY == 0
+    MessageQ_Msg msgqMsg;
+#endif
+    UInt16 messageType;
+    Error_Block eb;
+    UInt16 jobId;
+    GateThread_Handle gateH;
+    IArg gateKey;
+#if USE_MESSAGEQCOPY
+    UInt32 recvTime;
+#endif
+    Int rval;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print2(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, packet=0x%x)", (IArg)obj, (IArg)packet);
+
+    Error_init(&eb);
+
+    /* decode the message */
+    rcmMsg = &packet->message;
+#if USE_MESSAGEQCOPY == 0
     msgqMsg = &packet->msgqHeader;
 #endif
-    Log_print1(Diags_INFO, FXNN": message desc=0x%x", (IArg)packet->desc);
+#if USE_MESSAGEQCOPY
+    recvTime = packet->recvTime;
+    obj->latHist[RcmServer_LatStage_QUEUE]
+        [RcmServer_latBucket_I(Timestamp_get32() - recvTime)]++;
+#endif
+    Log_print1(Diags_INFO, FXNN": message desc=0x%x", (IArg)packet->desc);
+
+    /* extract the message type from the packet descriptor field */
+    messageType = (RcmClient_Desc_TYPE_MASK & packet->desc) >>
+        RcmClient_Desc_TYPE_SHIFT;
+
+#if USE_MESSAGEQCOPY
+    /* a call which waited past its time-to-live is not executed */
+    if (((messageType == RcmClient_Desc_RCM_MSG)
+        || (messageType == RcmClient_Desc_CMD)
+        || (messageType == RcmClient_Desc_DPC)
+        || (messageType == RcmClient_Desc_BATCH))
+        && RcmServer_expired_I(packet)) {
+
+        Log_print2(Diags_INFO, FXNN": expired, msgId=0x%x packet=0x%x",
+            (IArg)packet->msgId, (IArg)packet);
+
+        RcmServer_setStatusCode_I(packet, RcmServer_Status_Expired);
+        rcmMsg->result = RcmServer_E_Expired;
+        RcmServer_reply_P(obj, packet, kick);
+        goto leave;
+    }
+#endif
+
+    /* process the given message */
+    switch (messageType) {
+
+        case RcmClient_Desc_RCM_MSG:
+            rval = RcmServer_execMsg_I(obj, packet);
+
+            if (rval < 0) {
+                switch (rval) {
+                    case RcmServer_E_InvalidFxnIdx:
+                        RcmServer_setStatusCode_I(
+                            packet, RcmServer_Status_INVALID_FXN);
+                        break;
+                    default:
+                        RcmServer_setStatusCode_I(
+                            packet, RcmServer_Status_Error);
+                        break;
+                }
+            }
+            else if (rcmMsg->result < 0) {
+                RcmServer_setStatusCode_I(packet, RcmServer_Status_MSG_FXN_ERR);
+            }
+            else {
+                RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
+            }
+
+            RcmServer_reply_P(obj, packet, kick);
+            break;
+
+        case RcmClient_Desc_BATCH:
+            RcmServer_execBatch_P(obj, packet);
+
+            RcmServer_reply_P(obj, packet, kick);
+            break;
+
+        case RcmClient_Desc_CMD:
+            status = RcmServer_execMsg_I(obj, packet);
+
+            /* if all went well, free the message */
+            if ((status >= 0) && (rcmMsg->result >= 0)) {
+
+#if USE_MESSAGEQCOPY == 0
+                status = MessageQ_free(msgqMsg);
+#endif
+                if (status < 0) {
+                    Log_error1(
+                        FXNN": MessageQ_free returned error %d", (IArg)status);
+                }
+            }
+
+            /* an error occurred, must return message to client */
+            else {
+                if (status < 0) {
+                    /* error trying to process the message */
+                    switch (status) {
+                        case RcmServer_E_InvalidFxnIdx:
+                            RcmServer_setStatusCode_I(
+                                packet, RcmServer_Status_INVALID_FXN);
+                            break;
+                        default:
+                            RcmServer_setStatusCode_I(
+                                packet, RcmServer_Status_Error);
+                            break;
+                    }
+                }
+                else  {
+                    /* error in message function */
+                    RcmServer_setStatusCode_I(
+                        packet, RcmServer_Status_MSG_FXN_ERR);
+                }
+
+                /* send error message back to client */
+                RcmServer_reply_P(obj, packet, kick);
+            }
+            break;
+
+        case RcmClient_Desc_DPC:
+            rval = RcmServer_getFxnAddr_P(obj, rcmMsg->fxnIdx, &fxn,
+                                          &createFxn, NULL);
+
+            if (rval < 0) {
+                RcmServer_setStatusCode_I(
+                    packet, RcmServer_Status_SYMBOL_NOT_FOUND);
+                Error_init(&eb);
+            }
+
+            /* the function may run indefinitely, the reply must go now */
+            RcmServer_reply_P(obj, packet, TRUE);
+
+            /* invoke the function with a null context */
+#if USE_MESSAGEQCOPY
+            if (createFxn)  {
+                 (*createFxn)(obj, 0, NULL);
+            }
+            else {
+                 (*fxn)(0, NULL);
+            }
+#else
+            (*fxn)(0, NULL);
+#endif
+            break;
+
+        case RcmClient_Desc_SYM_ADD:
+            break;
+
+        case RcmClient_Desc_SYM_IDX:
+            name = (String)rcmMsg->data;
+
+            /* protect the symbol table while searching it */
+            gateH = GateThread_handle(&obj->gate);
+            gateKey = GateThread_enter(gateH);
+            rval = RcmServer_getSymIdx_P(obj, name, &fxnIdx);
+            GateThread_leave(gateH, gateKey);
+
+            if (rval < 0) {
+                RcmServer_setStatusCode_I(
+                    packet, RcmServer_Status_SYMBOL_NOT_FOUND);
+            }
+            else {
+                RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
+                rcmMsg->data[0] = fxnIdx;
+                rcmMsg->result = 0;
+            }
+
+            RcmServer_reply_P(obj, packet, kick);
+            break;
+
+#if USE_MESSAGEQCOPY
+        case RcmClient_Desc_CANCEL:
+            RcmServer_cancel_P(obj, packet);
+            RcmServer_reply_P(obj, packet, kick);
+            break;
+#endif
+
+        case RcmClient_Desc_FXN_STATS:
+            if (rcmMsg->dataSize < sizeof(RcmServer_FxnStats)) {
+                RcmServer_setStatusCode_I(packet, RcmServer_Status_Error);
+                rcmMsg->result = RcmServer_E_INVALIDARG;
+            }
+            else {
+                /* data[0] is the reset flag on input */
+                gateH = GateThread_handle(&obj->gate);
+                gateKey = GateThread_enter(gateH);
+                rval = RcmServer_readFxnStats_P(obj, rcmMsg->fxnIdx,
+                    (RcmServer_FxnStats *)rcmMsg->data,
+                    (Bool)(rcmMsg->data[0] != 0));
+                GateThread_leave(gateH, gateKey);
+
+                if (rval < 0) {
+                    RcmServer_setStatusCode_I(
+                        packet, RcmServer_Status_INVALID_FXN);
+                    rcmMsg->result = rval;
+                }
+                else {
+                    RcmServer_setStatusCode_I(
+                        packet, RcmServer_Status_SUCCESS);
+                    rcmMsg->result = 0;
+                }
+            }
+
+            RcmServer_reply_P(obj, packet, kick);
+            break;
+
+        case RcmClient_Desc_JOB_ACQ:
+            rval = RcmServer_acqJobId_P(obj, &jobId);
+
+            if (rval < 0) {
+                RcmServer_setStatusCode_I(packet, RcmServer_Status_Error);
+            }
+            else {
+                RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
+                *(UInt16 *)(&rcmMsg->data[0]) = jobId;
+                rcmMsg->result = 0;
+            }
+
+            RcmServer_reply_P(obj, packet, kick);
+            break;
+
+        case RcmClient_Desc_JOB_REL:
+            jobId = (UInt16)(rcmMsg->data[0]);
+            rval = RcmServer_relJobId_P(obj, jobId);
+
+            if (rval < 0) {
+                switch (rval) {
+                    case RcmServer_E_JobIdNotFound:
+                        RcmServer_setStatusCode_I(
+                            packet, RcmServer_Status_JobNotFound);
+                        break;
+                    default:
+                        RcmServer_setStatusCode_I(
+                            packet, RcmServer_Status_Error);
+                        break;
+                }
+                rcmMsg->result = rval;
+            }
+            else {
+                RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
+                rcmMsg->result = 0;
+            }
+
+            RcmServer_reply_P(obj, packet, kick);
+            break;
+
+        default:
+            Log_error1(FXNN": unknown message type recieved, 0x%x",
+                (IArg)messageType);
+            break;
+    }
+
+#if USE_MESSAGEQCOPY
+leave:
+    /* packet may already be reused, so use the saved receive time */
+    obj->latHist[RcmServer_LatStage_TOTAL]
+        [RcmServer_latBucket_I(Timestamp_get32() - recvTime)]++;
+#endif
 
-    /* extract the message type from the packet descriptor field */
-    messageType = (RcmClient_Desc_TYPE_MASK & packet->desc) >>
-        RcmClient_Desc_TYPE_SHIFT;
+    Log_print0(Diags_EXIT, "<-- "FXNN":");
+}
+#undef FXNN
 
-    /* process the given message */
-    switch (messageType) {
 
-        case RcmClient_Desc_RCM_MSG:
-            rval = RcmServer_execMsg_I(obj, rcmMsg);
+/*
+ *  ======== RcmServer_relJobId_P ========
+ */
+#define FXNN "RcmServer_relJobId_P"
+Int RcmServer_relJobId_P(RcmServer_Object *obj, UInt16 jobId)
+{
+    GateThread_Handle gateH;
+    IArg key;
+    RcmServer_JobStream **link;
+    RcmServer_JobStream *job;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print2(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, jobId=0x%x)", (IArg)obj, (IArg)jobId);
+
+
+    /* must protect job table while searching and modifying it */
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
+
+    /* find the job stream object in its hash bucket */
+    link = &obj->jobTab[RcmServer_jobBucket(jobId)];
+
+    while (((job = *link) != NULL) && (job->jobId != jobId)) {
+        link = &job->next;
+    }
+
+    /* remove the job stream object from the table */
+    if (job != NULL) {
+        *link = job->next;
+    }
+
+    GateThread_leave(gateH, key);
+
+    if (job == NULL) {
+        status = RcmServer_E_JobIdNotFound;
+        Log_error1(FXNN": failed to find jobId=%d", (IArg)jobId);
+        goto leave;
+    }
+
+    /* return any pending messages and free the job stream object */
+    RcmServer_freeJob_P(obj, job);
+
+
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_freeJob_P ========
+ *
+ *  Return any messages still queued on the job stream to the client, then
+ *  free the job stream object. The job must already be out of the table.
+ */
+#define FXNN "RcmServer_freeJob_P"
+Void RcmServer_freeJob_P(RcmServer_Object *obj, RcmServer_JobStream *job)
+{
+    List_Elem *elem;
+    List_Handle msgQueH;
+    RcmClient_Packet *packet;
+
+
+    msgQueH = List_handle(&job->msgQue);
+
+    while ((elem = List_get(msgQueH)) != NULL) {
+        packet = (RcmClient_Packet *)elem;
+        Log_warning2(
+            FXNN": returning unprocessed message, jobId=0x%x, packet=0x%x",
+            (IArg)job->jobId, (IArg)packet);
+
+        RcmServer_setStatusCode_I(packet, RcmServer_Status_Unprocessed);
+        RcmServer_reply_P(obj, packet, FALSE);
+#if USE_MESSAGEQCOPY
+        RcmServer_freePacket_I(obj, packet);
+#endif
+    }
+    RcmServer_flushReplies_I(obj);
+
+    /* finalize the job stream object */
+    List_destruct(&job->msgQue);
+
+    xdc_runtime_Memory_free(RcmServer_Module_heap(),
+        (Ptr)job, sizeof(RcmServer_JobStream));
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_findJob_I ========
+ *
+ *  Must have the server gate before calling this function.
+ */
+RcmServer_JobStream *RcmServer_findJob_I(RcmServer_Object *obj, UInt16 jobId)
+{
+    RcmServer_JobStream *job;
+
+
+    job = obj->jobTab[RcmServer_jobBucket(jobId)];
+
+    while ((job != NULL) && (job->jobId != jobId)) {
+        job = job->next;
+    }
+
+    return(job);
+}
+
+
+/*
+ *  ======== RcmServer_serverThrFxn_P ========
+ */
+#define FXNN "RcmServer_serverThrFxn_P"
+Void RcmServer_serverThrFxn_P(IArg arg)
+{
+    Error_Block eb;
+    RcmClient_Packet *packet;
+#if USE_MESSAGEQCOPY
+    UInt16       len;
+    UInt16       replyProc;
+#else
+    MessageQ_Msg msgqMsg = NULL;
+#endif
+    Int rval;
+    Bool running = TRUE;
+    RcmServer_Object *obj = (RcmServer_Object *)arg;
+
+
+    Log_print1(Diags_ENTRY, "--> "FXNN": (arg=0x%x)", arg);
+
+    Error_init(&eb);
+
+    /* wait until ready to run */
+    Semaphore_pend(obj->run, Semaphore_FOREVER, &eb);
+
+    if (Error_check(&eb)) {
+        Log_error0(FXNN": Semaphore_pend failure in server thread");
+    }
+
+    /* main processing loop */
+    while (running) {
+        Log_print1(Diags_INFO,
+            FXNN": waiting for message, thread=0x%x",
+            (IArg)(obj->serverThread));
+
+#if USE_MESSAGEQCOPY
+        /* take a free packet, blocks while all packets are in flight */
+        packet = RcmServer_allocPacket_I(obj);
+#endif
+
+        /* block until message arrives */
+        do {
+#if USE_MESSAGEQCOPY
+            rval = MessageQCopy_recvFrom(obj->serverQue, (Ptr)&packet->hdr,
+                      &len, &replyProc, &packet->replyAddr,
+                      MessageQCopy_FOREVER);
+            packet->recvTime = Timestamp_get32();
+            packet->replyProc = replyProc;
+            obj->replyAddr = packet->replyAddr;
+            obj->dstProc = replyProc;
+#if 0
+            System_printf("RcmServer_serverThrFxn_P: Received msg of len %d "
+                          "from: %d\n",
+                         len, obj->replyAddr);
+
+            System_printf("hdr - t:%d f:%d l:%d\n", packet->hdr.type,
+                          packet->hdr.flags, packet->hdr.len);
+
+            System_printf("pkt - d:%d m:%d\n", packet->desc, packet->msgId);
+#endif
+            if (packet->hdr.type == OMX_DISC_REQ) {
+                System_printf("RcmServer_serverThrFxn_P: Got OMX_DISCONNECT\n");
+            }
+            Assert_isTrue((len <= PACKET_MAXSIZE), NULL);
+            Assert_isTrue((packet->hdr.type == OMX_RAW_MSG) ||
+                          (packet->hdr.type == OMX_DISC_REQ) , NULL);
+
+            if ((rval < 0) && (rval != MessageQCopy_E_UNBLOCKED)) {
+#else
+            rval = MessageQ_get(obj->serverQue, &msgqMsg, MessageQ_FOREVER);
+            if ((rval < 0) && (rval != MessageQ_E_UNBLOCKED)) {
+#endif
+                Log_error1(FXNN": ipc error 0x%x", (IArg)rval);
+                /* keep running and hope for the best */
+            }
+#if USE_MESSAGEQCOPY
+        } while (FALSE);
+#else
+        } while ((msgqMsg == NULL) && !obj->shutdown);
+#endif
+
+        /* if shutdown, exit this thread */
+#if USE_MESSAGEQCOPY
+        if (obj->shutdown || packet->hdr.type == OMX_DISC_REQ) {
+            running = FALSE;
+            Log_print1(Diags_INFO,
+                FXNN": terminating, thread=0x%x", (IArg)(obj->serverThread));
+            RcmServer_freePacket_I(obj, packet);
+            continue;
+        }
+
+        /* take the time-to-live off the message, the call never sees it */
+        RcmServer_takeTtl_I(packet);
+#else
+        if (obj->shutdown) {
+            running = FALSE;
+            Log_print1(Diags_INFO,
+                FXNN": terminating, thread=0x%x", (IArg)(obj->serverThread));
+            if (msgqMsg == NULL ) {
+                continue;
+            }
+        }
+#endif
+
+#if USE_MESSAGEQCOPY == 0
+        packet = (RcmClient_Packet *)msgqMsg;
+#endif
+
+        Log_print2(Diags_INFO,
+            FXNN": message received, thread=0x%x packet=0x%x",
+            (IArg)(obj->serverThread), (IArg)packet);
+
+#if USE_MESSAGEQCOPY
+        /* a cancel must not wait behind the messages it cancels */
+        if (((packet->desc & RcmClient_Desc_TYPE_MASK)
+            >> RcmClient_Desc_TYPE_SHIFT) == RcmClient_Desc_CANCEL) {
+            packet->state = RcmServer_PKT_RUNNING;
+            RcmServer_process_P(obj, packet, TRUE);
+            RcmServer_freePacket_I(obj, packet);
+            continue;
+        }
+
+        packet->state = RcmServer_PKT_QUEUED;
+#endif
+
+        if ((packet->message.poolId == RcmClient_DEFAULTPOOLID)
+            && ((obj->poolMap[0])[0].count == 0)) {
+
+            /* in-band (server thread) message processing */
+            RcmServer_process_P(obj, packet, TRUE);
+#if USE_MESSAGEQCOPY
+            RcmServer_freePacket_I(obj, packet);
+#endif
+        }
+        else {
+            /* out-of-band (worker thread) message processing */
+            rval = RcmServer_dispatch_P(obj, packet);
 
+            /* if error, message was not dispatched; must return to client */
             if (rval < 0) {
                 switch (rval) {
-                    case RcmServer_E_InvalidFxnIdx:
+                    case RcmServer_E_JobIdNotFound:
                         RcmServer_setStatusCode_I(
-                            packet, RcmServer_Status_INVALID_FXN);
+                            packet, RcmServer_Status_JobNotFound);
+                        break;
+
+                    case RcmServer_E_PoolIdNotFound:
+                        RcmServer_setStatusCode_I(
+                            packet, RcmServer_Status_PoolNotFound);
+                        break;
+
+                    case RcmServer_E_Expired:
+                        RcmServer_setStatusCode_I(
+                            packet, RcmServer_Status_Expired);
                         break;
+
                     default:
                         RcmServer_setStatusCode_I(
                             packet, RcmServer_Status_Error);
                         break;
                 }
-            }
-            else if (rcmMsg->result < 0) {
-                RcmServer_setStatusCode_I(packet, RcmServer_Status_MSG_FXN_ERR);
-            }
-            else {
-                RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
-            }
+                packet->message.result = rval;
 
+                /* return the message to the client */
+                RcmServer_reply_P(obj, packet, TRUE);
 #if USE_MESSAGEQCOPY
-#if 0
-            System_printf("RcmServer_process_P: Sending reply from: %d to: %d\n",
-                      obj->localAddr, obj->replyAddr);
+                RcmServer_freePacket_I(obj, packet);
 #endif
-
-            packet->hdr.type = OMX_RAW_MSG;
-            packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-            status = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-            status = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-            if (status < 0) {
-                Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)status);
             }
-            break;
+        }
+    }
 
-        case RcmClient_Desc_CMD:
-            status = RcmServer_execMsg_I(obj, rcmMsg);
+    System_printf("RcmServer_serverThrFxn_P: Exiting thread.\n");
 
-            /* if all went well, free the message */
-            if ((status >= 0) && (rcmMsg->result >= 0)) {
+    Log_print0(Diags_EXIT, "<-- "FXNN":");
+}
+#undef FXNN
 
-#if USE_MESSAGEQCOPY == 0
-                status = MessageQ_free(msgqMsg);
-#endif
-                if (status < 0) {
-                    Log_error1(
-                        FXNN": MessageQ_free returned error %d", (IArg)status);
-                }
-            }
 
-            /* an error occurred, must return message to client */
-            else {
-                if (status < 0) {
-                    /* error trying to process the message */
-                    switch (status) {
-                        case RcmServer_E_InvalidFxnIdx:
-                            RcmServer_setStatusCode_I(
-                                packet, RcmServer_Status_INVALID_FXN);
-                            break;
-                        default:
-                            RcmServer_setStatusCode_I(
-                                packet, RcmServer_Status_Error);
-                            break;
-                    }
-                }
-                else  {
-                    /* error in message function */
-                    RcmServer_setStatusCode_I(
-                        packet, RcmServer_Status_MSG_FXN_ERR);
-                }
+/*
+ *  ======== RcmServer_latBucket_I ========
+ *
+ *  Latency histogram bucket b counts deltas in [4^b, 4^(b+1)) ticks.
+ */
+UInt RcmServer_latBucket_I(UInt32 delta)
+{
+    UInt b = 0;
 
-                /* send error message back to client */
-#if USE_MESSAGEQCOPY
-                packet->hdr.type = OMX_RAW_MSG;
-                packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-                status = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-                status = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-                if (status < 0) {
-                    Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)status);
-                }
-            }
-            break;
+    while ((delta >= 4) && (b < (RcmServer_NUMLATBUCKETS - 1))) {
+        delta >>= 2;
+        b++;
+    }
+    return(b);
+}
 
-        case RcmClient_Desc_DPC:
-            rval = RcmServer_getFxnAddr_P(obj, rcmMsg->fxnIdx, &fxn,
-                                          &createFxn);
 
-            if (rval < 0) {
-                RcmServer_setStatusCode_I(
-                    packet, RcmServer_Status_SYMBOL_NOT_FOUND);
-                Error_init(&eb);
-            }
+/*
+ *  ======== RcmServer_fxnStat_I ========
+ *
+ *  Account one call of a remote function. Called without a lock, so
+ *  concurrent workers may lose the odd update.
+ */
+Void RcmServer_fxnStat_I(RcmServer_FxnStats *stats, UInt32 delta,
+        Int32 result)
+{
+    if ((stats->calls == 0) || (delta < stats->minTime)) {
+        stats->minTime = delta;
+    }
+    if (delta > stats->maxTime) {
+        stats->maxTime = delta;
+    }
+    if (result < 0) {
+        stats->errors++;
+    }
+    stats->totalTime += delta;
+    stats->calls++;
+}
 
-#if USE_MESSAGEQCOPY
-            packet->hdr.type = OMX_RAW_MSG;
-            packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-            status = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-            status = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-            if (status < 0) {
-                Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)status);
-            }
 
-            /* invoke the function with a null context */
-#if USE_MESSAGEQCOPY
-            if (createFxn)  {
-                 (*createFxn)(obj, 0, NULL);
-            }
-            else {
-                 (*fxn)(0, NULL);
-            }
-#else
-            (*fxn)(0, NULL);
-#endif
-            break;
+/*
+ *  ======== RcmServer_readFxnStats_P ========
+ *
+ *  Copy out the statistics of the function at fxnIdx. Must be called
+ *  with the server gate held, so the function cannot be removed.
+ */
+Int RcmServer_readFxnStats_P(RcmServer_Object *obj, UInt32 fxnIdx,
+        RcmServer_FxnStats *stats, Bool reset)
+{
+    RcmServer_MsgFxn fxn;
+    RcmServer_MsgCreateFxn createFxn = NULL;
+    RcmServer_FxnTabInfo *info;
+    Int status;
 
-        case RcmClient_Desc_SYM_ADD:
-            break;
 
-        case RcmClient_Desc_SYM_IDX:
-            name = (String)rcmMsg->data;
-            rval = RcmServer_getSymIdx_P(obj, name, &fxnIdx);
+    status = RcmServer_getFxnAddr_P(obj, fxnIdx, &fxn, &createFxn, &info);
 
-            if (rval < 0) {
-                RcmServer_setStatusCode_I(
-                    packet, RcmServer_Status_SYMBOL_NOT_FOUND);
-            }
-            else {
-                RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
-                rcmMsg->data[0] = fxnIdx;
-                rcmMsg->result = 0;
-            }
+    if (status < 0) {
+        return(status);
+    }
 
-#if USE_MESSAGEQCOPY
-            packet->hdr.type = OMX_RAW_MSG;
-            packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-            status = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-            status = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-            if (status < 0) {
-                Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)status);
-            }
-            break;
+    _memcpy((Void *)stats, (Void *)&info->stats, sizeof(info->stats));
 
-        case RcmClient_Desc_JOB_ACQ:
-            rval = RcmServer_acqJobId_P(obj, &jobId);
+    if (reset) {
+        _memset((Void *)&info->stats, 0, sizeof(info->stats));
+    }
+
+    return(status);
+}
 
-            if (rval < 0) {
-                RcmServer_setStatusCode_I(packet, RcmServer_Status_Error);
-            }
-            else {
-                RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
-                *(UInt16 *)(&rcmMsg->data[0]) = jobId;
-                rcmMsg->result = 0;
-            }
 
 #if USE_MESSAGEQCOPY
-            packet->hdr.type = OMX_RAW_MSG;
-            packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-            status = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-            status = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-            if (status < 0) {
-                Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)status);
-            }
-            break;
+/*
+ *  ======== RcmServer_addPackets_P ========
+ *
+ *  Add a block of packet buffers to the packet pool. Blocks are only
+ *  freed when the server is deleted.
+ */
+#define FXNN "RcmServer_addPackets_P"
+Int RcmServer_addPackets_P(RcmServer_Object *obj, UInt count)
+{
+    GateThread_Handle gateH;
+    IArg key;
+    Error_Block eb;
+    RcmServer_PktBlock *block;
+    RcmClient_Packet *packet;
+    SizeT size;
+    UInt i;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print2(Diags_ENTRY, "--> "FXNN": (obj=0x%x, count=%d)",
+        (IArg)obj, (IArg)count);
+
+    Error_init(&eb);
+
+    if (count == 0) {
+        goto leave;
+    }
+
+    size = sizeof(RcmServer_PktBlock) + (count * MSGBUFFERSIZE);
+    block = xdc_runtime_Memory_alloc(
+        RcmServer_Module_heap(), size, sizeof(Ptr), &eb);
+
+    if (Error_check(&eb)) {
+        Log_error2(FXNN": out of memory: heap=0x%x, size=%u",
+            (IArg)RcmServer_Module_heap(), size);
+        status = RcmServer_E_NOMEMORY;
+        goto leave;
+    }
+
+    block->count = count;
+
+    for (i = 0; i < count; i++) {
+        RcmServer_blockPkt(block, i)->state = RcmServer_PKT_FREE;
+    }
+
+    /* link the block before any of its packets can be received into */
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
+    block->next = obj->pktBlock;
+    obj->pktBlock = block;
+    obj->pktCount += count;
+    GateThread_leave(gateH, key);
+
+    for (i = 0; i < count; i++) {
+        packet = RcmServer_blockPkt(block, i);
+        List_put(obj->pktList, (List_Elem *)packet);
+        Semaphore_post(obj->pktSem, &eb);
+    }
+
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_allocPacket_I ========
+ *
+ *  Blocks until a packet buffer is free. A packet stays allocated until
+ *  its reply has been sent, so it may sit on a ready or job queue.
+ */
+#define FXNN "RcmServer_allocPacket_I"
+RcmClient_Packet *RcmServer_allocPacket_I(RcmServer_Object *obj)
+{
+    Error_Block eb;
+
+
+    Error_init(&eb);
+    Semaphore_pend(obj->pktSem, Semaphore_FOREVER, &eb);
+
+    if (Error_check(&eb)) {
+        Log_error0(FXNN": semaphore pend failed");
+    }
+
+    return((RcmClient_Packet *)List_get(obj->pktList));
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_freePacket_I ========
+ */
+#define FXNN "RcmServer_freePacket_I"
+Void RcmServer_freePacket_I(RcmServer_Object *obj, RcmClient_Packet *packet)
+{
+    Error_Block eb;
+
+
+    Error_init(&eb);
+    packet->state = RcmServer_PKT_FREE;
+    List_put(obj->pktList, (List_Elem *)packet);
+    Semaphore_post(obj->pktSem, &eb);
+
+    if (Error_check(&eb)) {
+        Log_error0(FXNN": semaphore post failed");
+    }
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_expired_I ========
+ *
+ *  TRUE if the message has a time-to-live and the server has held it
+ *  longer than that since receiving it.
+ */
+Bool RcmServer_expired_I(RcmClient_Packet *packet)
+{
+    Types_FreqHz freq;
+    UInt32 ttl = packet->ttl;
+    UInt32 ticksPerMs;
+    UInt32 ticks;
+
+
+    if (ttl == 0) {
+        return(FALSE);
+    }
+
+    /* convert to Timestamp ticks without 64-bit math; a time-to-live
+     * beyond half the timestamp range never expires */
+    Timestamp_getFreq(&freq);
+    ticksPerMs = freq.lo / 1000;
+
+    if ((ttl / 1000) > (0x7FFFFFFF / (ticksPerMs + 1))) {
+        return(FALSE);
+    }
+    ticks = ((ttl / 1000) * ticksPerMs) + (((ttl % 1000) * ticksPerMs) / 1000);
+
+    return((Timestamp_get32() - packet->recvTime) > ticks);
+}
+
+
+/*
+ *  ======== RcmServer_takeTtl_I ========
+ *
+ *  Move the time-to-live word of a RcmClient_PROTO_TTL message from the
+ *  end of its data buffer into the packet. RcmServer_reply_P puts the
+ *  word back into the reply.
+ */
+Void RcmServer_takeTtl_I(RcmClient_Packet *packet)
+{
+    RcmClient_Message *rcmMsg = &packet->message;
 
-        case RcmClient_Desc_JOB_REL:
-            jobId = (UInt16)(rcmMsg->data[0]);
-            rval = RcmServer_relJobId_P(obj, jobId);
 
-            if (rval < 0) {
-                switch (rval) {
-                    case RcmServer_E_JobIdNotFound:
-                        RcmServer_setStatusCode_I(
-                            packet, RcmServer_Status_JobNotFound);
-                        break;
-                    default:
-                        RcmServer_setStatusCode_I(
-                            packet, RcmServer_Status_Error);
-                        break;
-                }
-                rcmMsg->result = rval;
-            }
-            else {
-                RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
-                rcmMsg->result = 0;
-            }
+    packet->ttl = 0;
 
-#if USE_MESSAGEQCOPY
-            packet->hdr.type = OMX_RAW_MSG;
-            packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-            status = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-            status = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-            if (status < 0) {
-                Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)status);
-            }
-            break;
+    if ((packet->desc & RcmClient_Desc_VER_MASK) < RcmClient_PROTO_TTL) {
+        return;
+    }
 
-        default:
-            Log_error1(FXNN": unknown message type recieved, 0x%x",
-                (IArg)messageType);
-            break;
+    /* no room for the word, handle it like a message without one */
+    if (rcmMsg->dataSize < sizeof(UInt32)) {
+        packet->desc &= ~RcmClient_Desc_VER_MASK;
+        return;
     }
 
-    Log_print0(Diags_EXIT, "<-- "FXNN":");
+    rcmMsg->dataSize -= sizeof(UInt32);
+    _memcpy((Void *)&packet->ttl,
+        (Void *)((Char *)rcmMsg->data + rcmMsg->dataSize), sizeof(UInt32));
 }
-#undef FXNN
 
 
 /*
- *  ======== RcmServer_relJobId_P ========
+ *  ======== RcmServer_isNonBlocking_I ========
+ *
+ *  TRUE if the packet calls a static function flagged
+ *  RcmServer_FxnFlag_NONBLOCKING. Dynamic functions are never assumed
+ *  to be, as their tables may be changing under the caller.
  */
-#define FXNN "RcmServer_relJobId_P"
-Int RcmServer_relJobId_P(RcmServer_Object *obj, UInt16 jobId)
+Bool RcmServer_isNonBlocking_I(RcmServer_Object *obj, RcmClient_Packet *packet)
 {
-    GateThread_Handle gateH;
-    IArg key;
-    List_Elem *elem;
-    List_Handle msgQueH;
-    RcmClient_Packet *packet;
-    RcmServer_JobStream *job;
-#if USE_MESSAGEQCOPY == 0
-    MessageQ_Msg msgqMsg;
-#endif
-    Int rval;
-    Int status = RcmServer_S_SUCCESS;
+    UInt32 fxnIdx = packet->message.fxnIdx;
 
+    if (((packet->desc & RcmClient_Desc_TYPE_MASK) !=
+        (RcmClient_Desc_RCM_MSG << RcmClient_Desc_TYPE_SHIFT))
+        || !(fxnIdx & 0x80000000) || ((fxnIdx & 0x0000FFFF) == 0)
+        || ((fxnIdx & 0x0000FFFF) >= obj->fxnTabStatic.length)) {
+        return(FALSE);
+    }
 
-    Log_print2(Diags_ENTRY,
-        "--> "FXNN": (obj=0x%x, jobId=0x%x)", (IArg)obj, (IArg)jobId);
+    return((obj->fxnTabStatic.elem[fxnIdx & 0x0000FFFF].flags
+        & RcmServer_FxnFlag_NONBLOCKING) != 0);
+}
 
 
-    /* must protect job list while searching and modifying it */
-    gateH = GateThread_handle(&obj->gate);
-    key = GateThread_enter(gateH);
+/*
+ *  ======== RcmServer_swiRecv_P ========
+ *
+ *  MessageQCopy receive hook, runs in the receive Swi. A call to a static
+ *  function flagged RcmServer_FxnFlag_NONBLOCKING is executed in place in
+ *  the vring buffer and its reply sent from there, without waking the
+ *  server thread. Returns FALSE to leave any other message to the server
+ *  thread.
+ */
+#define FXNN "RcmServer_swiRecv_P"
+Bool RcmServer_swiRecv_P(UArg arg, Ptr data, UInt16 len, UInt16 srcProc,
+        UInt32 srcEndpt)
+{
+    RcmServer_Object *obj = (RcmServer_Object *)arg;
+    RcmClient_Packet *packet;
+    RcmClient_Message *rcmMsg;
+    UInt32 fxnIdx;
+    UInt32 size;
+    UInt32 start;
+    Int rval;
 
-    /* find the job stream object in the list */
-    elem = NULL;
-    while ((elem = List_next(obj->jobList, elem)) != NULL) {
-        job = (RcmServer_JobStream *)elem;
 
-        /* remove the job stream object from the list */
-        if (job->jobId == jobId) {
-            List_remove(obj->jobList, elem);
-            break;
-        }
+    /* the buffer holds the packet from the hdr field on, like a recv */
+    packet = (RcmClient_Packet *)((Char *)data -
+        offsetof(RcmClient_Packet, hdr));
+    rcmMsg = &packet->message;
+
+    if (obj->shutdown || (len < PACKET_HDR_SIZE)
+        || (packet->hdr.type != OMX_RAW_MSG)
+        || ((PACKET_HDR_SIZE + rcmMsg->dataSize) > len)) {
+        return(FALSE);
     }
 
-    GateThread_leave(gateH, key);
+    /* only plain exec messages, job streams must stay in order */
+    if (((packet->desc & RcmClient_Desc_TYPE_MASK) !=
+        (RcmClient_Desc_RCM_MSG << RcmClient_Desc_TYPE_SHIFT))
+        || (packet->desc & RcmClient_Desc_PTRARGS)
+        || (rcmMsg->jobId != RcmClient_DISCRETEJOBID)) {
+        return(FALSE);
+    }
 
-    if (elem == NULL) {
-        status = RcmServer_E_JobIdNotFound;
-        Log_error1(FXNN": failed to find jobId=%d", (IArg)jobId);
-        goto leave;
+    if (!RcmServer_isNonBlocking_I(obj, packet)) {
+        return(FALSE);
     }
+    fxnIdx = rcmMsg->fxnIdx;
 
-    /* return any pending messages on the message queue */
-    msgQueH = List_handle(&job->msgQue);
+    /* the call runs as it arrives, so a time-to-live is just skipped; the
+     * buffer is sent back as is, the word included */
+    size = rcmMsg->dataSize;
 
-    while ((elem = List_get(msgQueH)) != NULL) {
-        packet = (RcmClient_Packet *)elem;
-        Log_warning2(
-            FXNN": returning unprocessed message, jobId=0x%x, packet=0x%x",
-            (IArg)jobId, (IArg)packet);
+    if ((packet->desc & RcmClient_Desc_VER_MASK) >= RcmClient_PROTO_TTL) {
+        if (size < sizeof(UInt32)) {
+            return(FALSE);
+        }
+        size -= sizeof(UInt32);
+    }
 
-        RcmServer_setStatusCode_I(packet, RcmServer_Status_Unprocessed);
+    start = Timestamp_get32();
+    obj->latHist[RcmServer_LatStage_QUEUE][0]++;
 
-#if USE_MESSAGEQCOPY
-        packet->hdr.type = OMX_RAW_MSG;
-        packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-        rval = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-        msgqMsg = &packet->msgqHeader;
-        rval = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-        if (rval < 0) {
-            Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)rval);
-        }
+    rval = RcmServer_execFxn_I(obj, fxnIdx, size, rcmMsg->data,
+        &rcmMsg->result);
+
+    if (rval < 0) {
+        RcmServer_setStatusCode_I(packet, RcmServer_Status_INVALID_FXN);
+    }
+    else if (rcmMsg->result < 0) {
+        RcmServer_setStatusCode_I(packet, RcmServer_Status_MSG_FXN_ERR);
+    }
+    else {
+        RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
     }
 
-    /* finalize the job stream object */
-    List_destruct(&job->msgQue);
+    /* the Swi kicks the host once for all replies it produced */
+    packet->hdr.type = OMX_RAW_MSG;
+    packet->hdr.len = PACKET_DATA_SIZE + rcmMsg->dataSize;
+    rval = MessageQCopy_sendNoKick(srcProc, srcEndpt, obj->localAddr,
+        (Ptr)&packet->hdr, PACKET_HDR_SIZE + rcmMsg->dataSize);
 
-    xdc_runtime_Memory_free(RcmServer_Module_heap(),
-        (Ptr)job, sizeof(RcmServer_JobStream));
+    if (rval < 0) {
+        Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)rval);
+    }
 
+    obj->latHist[RcmServer_LatStage_TOTAL]
+        [RcmServer_latBucket_I(Timestamp_get32() - start)]++;
 
-leave:
-    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
-    return(status);
+    return(TRUE);
 }
 #undef FXNN
 
 
 /*
- *  ======== RcmServer_serverThrFxn_P ========
+ *  ======== RcmServer_claimPacket_I ========
+ *
+ *  Called by a worker before processing a packet. Returns FALSE if the
+ *  packet was cancelled while it was queued. The system gate makes the
+ *  state change atomic with RcmServer_cancel_P.
  */
-#define FXNN "RcmServer_serverThrFxn_P"
-Void RcmServer_serverThrFxn_P(IArg arg)
+Bool RcmServer_claimPacket_I(RcmServer_Object *obj, RcmClient_Packet *packet)
 {
-    Error_Block eb;
-    RcmClient_Packet *packet;
-#if USE_MESSAGEQCOPY
-    Char         recvBuf[MSGBUFFERSIZE];
-    UInt16       len;
-#else
-    MessageQ_Msg msgqMsg = NULL;
-#endif
-    Int rval;
-    Bool running = TRUE;
-    RcmServer_Object *obj = (RcmServer_Object *)arg;
-    Int dataSize;
+    Bits16 *state;
+    IArg key;
+    Bool claimed = TRUE;
 
-#if USE_MESSAGEQCOPY
-    packet = (RcmClient_Packet *)&recvBuf[0];
-#endif
 
-    Log_print1(Diags_ENTRY, "--> "FXNN": (arg=0x%x)", arg);
+    state = &packet->state;
+    key = Gate_enterSystem();
 
-    Error_init(&eb);
+    if (*state == RcmServer_PKT_CANCELLED) {
+        claimed = FALSE;
+    }
+    else {
+        *state = RcmServer_PKT_RUNNING;
+    }
 
-    /* wait until ready to run */
-    Semaphore_pend(obj->run, Semaphore_FOREVER, &eb);
+    Gate_leaveSystem(key);
 
-    if (Error_check(&eb)) {
-        Log_error0(FXNN": Semaphore_pend failure in server thread");
-    }
+    return(claimed);
+}
 
-    /* main processing loop */
-    while (running) {
-        Log_print1(Diags_INFO,
-            FXNN": waiting for message, thread=0x%x",
-            (IArg)(obj->serverThread));
 
-        /* block until message arrives */
-        do {
-#if USE_MESSAGEQCOPY
-            rval = MessageQCopy_recv(obj->serverQue, (Ptr)&packet->hdr, &len,
-                      &obj->replyAddr, MessageQCopy_FOREVER);
-#if 0
-            System_printf("RcmServer_serverThrFxn_P: Received msg of len %d "
-                          "from: %d\n",
-                         len, obj->replyAddr);
+/*
+ *  ======== RcmServer_cancel_P ========
+ *
+ *  Cancel the queued packets selected by a cancel message. The message
+ *  data holds the mode and its argument on input; on output it holds
+ *  the msgIds of the cancelled packets, as many as fit, and the result
+ *  field holds the number of packets cancelled.
+ *
+ *  The whole packet pool is scanned, which finds packets on the ready
+ *  queues and on the job queues alike without walking any list. A
+ *  cancelled packet stays on its queue; the worker which dequeues it
+ *  frees it without executing it and sends no reply.
+ */
+#define FXNN "RcmServer_cancel_P"
+Void RcmServer_cancel_P(RcmServer_Object *obj, RcmClient_Packet *packet)
+{
+    RcmClient_Message *rcmMsg;
+    RcmServer_PktBlock *block;
+    RcmClient_Packet *pkt;
+    UInt32 mode;
+    UInt32 arg;
+    UInt32 room;
+    Bool match;
+    IArg key;
+    UInt i;
+    Int32 count = 0;
 
-            System_printf("hdr - t:%d f:%d l:%d\n", packet->hdr.type,
-                          packet->hdr.flags, packet->hdr.len);
 
-            System_printf("pkt - d:%d m:%d\n", packet->desc, packet->msgId);
-#endif
-            if (packet->hdr.type == OMX_DISC_REQ) {
-                System_printf("RcmServer_serverThrFxn_P: Got OMX_DISCONNECT\n");
-            }
-            Assert_isTrue((len <= MSGBUFFERSIZE), NULL);
-            Assert_isTrue((packet->hdr.type == OMX_RAW_MSG) ||
-                          (packet->hdr.type == OMX_DISC_REQ) , NULL);
+    Log_print2(Diags_ENTRY,
+        "--> "FXNN": (obj=0x%x, packet=0x%x)", (IArg)obj, (IArg)packet);
 
-            if ((rval < 0) && (rval != MessageQCopy_E_UNBLOCKED)) {
-#else
-            rval = MessageQ_get(obj->serverQue, &msgqMsg, MessageQ_FOREVER);
-            if ((rval < 0) && (rval != MessageQ_E_UNBLOCKED)) {
-#endif
-                Log_error1(FXNN": ipc error 0x%x", (IArg)rval);
-                /* keep running and hope for the best */
-            }
-#if USE_MESSAGEQCOPY
-        } while (FALSE);
-#else
-        } while ((msgqMsg == NULL) && !obj->shutdown);
-#endif
+    rcmMsg = &packet->message;
 
-        /* if shutdown, exit this thread */
-#if USE_MESSAGEQCOPY
-        if (obj->shutdown || packet->hdr.type == OMX_DISC_REQ) {
-            running = FALSE;
-            Log_print1(Diags_INFO,
-                FXNN": terminating, thread=0x%x", (IArg)(obj->serverThread));
-            continue;
-        }
-#else
-        if (obj->shutdown) {
-            running = FALSE;
-            Log_print1(Diags_INFO,
-                FXNN": terminating, thread=0x%x", (IArg)(obj->serverThread));
-            if (msgqMsg == NULL ) {
-                continue;
-            }
-        }
-#endif
+    if (rcmMsg->dataSize < (2 * sizeof(UInt32))) {
+        RcmServer_setStatusCode_I(packet, RcmServer_Status_Error);
+        rcmMsg->result = RcmServer_E_INVALIDARG;
+        goto leave;
+    }
 
-#if USE_MESSAGEQCOPY == 0
-        packet = (RcmClient_Packet *)msgqMsg;
-#endif
+    mode = rcmMsg->data[0];
+    arg = rcmMsg->data[1];
+    room = rcmMsg->dataSize / sizeof(UInt32);
 
-        Log_print2(Diags_INFO,
-            FXNN": message received, thread=0x%x packet=0x%x",
-            (IArg)(obj->serverThread), (IArg)packet);
+    if (mode > RcmClient_Cancel_ALL) {
+        RcmServer_setStatusCode_I(packet, RcmServer_Status_Error);
+        rcmMsg->result = RcmServer_E_INVALIDARG;
+        goto leave;
+    }
 
-        if ((packet->message.poolId == RcmClient_DEFAULTPOOLID)
-            && ((obj->poolMap[0])[0].count == 0)) {
+    /* blocks are only ever added at the head, so the walk is safe */
+    for (block = obj->pktBlock; block != NULL; block = block->next) {
+        for (i = 0; i < block->count; i++) {
+            pkt = RcmServer_blockPkt(block, i);
 
-            /* in-band (server thread) message processing */
-            RcmServer_process_P(obj, packet);
-        }
-        else {
-            /* out-of-band (worker thread) message processing */
-            rval = RcmServer_dispatch_P(obj, packet);
+            key = Gate_enterSystem();
 
-            /* if error, message was not dispatched; must return to client */
-            if (rval < 0) {
-                switch (rval) {
-                    case RcmServer_E_JobIdNotFound:
-                        RcmServer_setStatusCode_I(
-                            packet, RcmServer_Status_JobNotFound);
-                        break;
+            match = FALSE;
 
-                    case RcmServer_E_PoolIdNotFound:
-                        RcmServer_setStatusCode_I(
-                            packet, RcmServer_Status_PoolNotFound);
+            if (pkt->state == RcmServer_PKT_QUEUED) {
+                switch (mode) {
+                    case RcmClient_Cancel_MSGID:
+                        match = (pkt->msgId == (UInt16)arg);
+                        break;
+                    case RcmClient_Cancel_JOB:
+                        match = (pkt->message.jobId == (UInt16)arg);
                         break;
-
                     default:
-                        RcmServer_setStatusCode_I(
-                            packet, RcmServer_Status_Error);
+                        match = TRUE;
                         break;
                 }
-                packet->message.result = rval;
+            }
 
-                /* return the message to the client */
-#if USE_MESSAGEQCOPY
-#if 0
-                System_printf("RcmServer_serverThrFxn_P: "
-                              "Sending response from: %d to: %d\n",
-                              obj->localAddr, obj->replyAddr);
-                System_printf("sending: %d + %d\n", PACKET_HDR_SIZE,
-                              packet->message.dataSize);
-#endif
-                packet->hdr.type = OMX_RAW_MSG;
-                if (rval < 0) {
-                    packet->hdr.len = sizeof(UInt32);
-                    packet->desc = 0x4142;
-                    packet->msgId = 0x0044;
-                    dataSize = sizeof(struct rpmsg_omx_hdr) + sizeof(UInt32);
-                }
-                else {
-                    packet->hdr.len = PACKET_DATA_SIZE +
-                        packet->message.dataSize;
-                    dataSize = PACKET_HDR_SIZE + packet->message.dataSize;
-                }
-                rval = MessageQCopy_send(obj->dstProc, obj->replyAddr,
-                                 obj->localAddr, (Ptr)&packet->hdr, dataSize);
-#else
-                rval = MessageQ_put(MessageQ_getReplyQueue(msgqMsg), msgqMsg);
-#endif
-                if (rval < 0) {
-                    Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)rval);
+            if (match) {
+                pkt->state = RcmServer_PKT_CANCELLED;
+            }
+
+            Gate_leaveSystem(key);
+
+            if (match) {
+                if (count < room) {
+                    rcmMsg->data[count] = pkt->msgId;
                 }
+                count++;
             }
         }
     }
 
-    System_printf("RcmServer_serverThrFxn_P: Exiting thread.\n");
+    rcmMsg->result = count;
+    RcmServer_setStatusCode_I(packet, RcmServer_Status_SUCCESS);
+
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": count=%d", (IArg)count);
+}
+#undef FXNN
+#endif
+
+
+/*
+ *  ======== RcmServer_reply_P ========
+ *
+ *  Return a message to its client. With kick FALSE the reply is published
+ *  to the host without raising an interrupt, so that several replies can
+ *  share one; the caller must then call RcmServer_flushReplies_I before
+ *  it can block.
+ */
+#define FXNN "RcmServer_reply_P"
+Int RcmServer_reply_P(RcmServer_Object *obj, RcmClient_Packet *packet,
+        Bool kick)
+{
+    Int status;
+
+
+#if USE_MESSAGEQCOPY
+    /* return the time-to-live word taken off by RcmServer_takeTtl_I */
+    if ((packet->desc & RcmClient_Desc_VER_MASK) >= RcmClient_PROTO_TTL) {
+        packet->message.dataSize += sizeof(UInt32);
+    }
+
+    packet->hdr.type = OMX_RAW_MSG;
+    packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
+
+    if (kick) {
+        status = MessageQCopy_send(packet->replyProc, packet->replyAddr,
+                obj->localAddr, (Ptr)&packet->hdr,
+                PACKET_HDR_SIZE + packet->message.dataSize);
+    }
+    else {
+        status = MessageQCopy_sendNoKick(packet->replyProc, packet->replyAddr,
+                obj->localAddr, (Ptr)&packet->hdr,
+                PACKET_HDR_SIZE + packet->message.dataSize);
+    }
+#else
+    status = MessageQ_put(MessageQ_getReplyQueue(&packet->msgqHeader),
+            &packet->msgqHeader);
+#endif
+
+    if (status < 0) {
+        Log_error1(FXNN": unknown ipc error, 0x%x", (IArg)status);
+    }
 
-    Log_print0(Diags_EXIT, "<-- "FXNN":");
+    return(status);
 }
 #undef FXNN
 
 
+/*
+ *  ======== RcmServer_flushReplies_I ========
+ *
+ *  Interrupt each client processor once for all replies sent with kick
+ *  FALSE.
+ */
+Void RcmServer_flushReplies_I(RcmServer_Object *obj)
+{
+#if USE_MESSAGEQCOPY
+    MessageQCopy_kickAll();
+#endif
+}
+
+
 /*
  *  ======== RcmServer_setStatusCode_I ========
  */
@@ -2320,24 +4290,38 @@ Void RcmServer_workerThrFxn_P(IArg arg)
     RcmClient_Packet *packet;
     List_Elem *elem;
     List_Handle listH;
-    List_Handle readyQueueH;
+    Thread_Handle self;
+    Int basePri;
+    Int runPri;
     UInt16 jobId;
     GateThread_Handle gateH;
     IArg key;
     RcmServer_ThreadPool *pool;
     RcmServer_JobStream *job;
     RcmServer_WorkerThread *obj;
+    Bool grow;
     Bool running;
+    UInt timeout;
+    Int pendStatus;
     Int rval;
+#if USE_MESSAGEQCOPY
+    UInt numDeferred;
+#endif
 
 
     Log_print1(Diags_ENTRY, "--> "FXNN": (arg=0x%x)", arg);
 
     Error_init(&eb);
     obj = (RcmServer_WorkerThread *)arg;
-    readyQueueH = List_handle(&obj->pool->readyQueue);
     packet = NULL;
     running = TRUE;
+#if USE_MESSAGEQCOPY
+    numDeferred = 0;
+#endif
+
+    /* urgent messages run above the pool priority, up to its limit */
+    self = Thread_self(&eb);
+    basePri = Thread_getOsPri(self);
 
     /* main processing loop */
     while (running) {
@@ -2346,11 +4330,48 @@ Void RcmServer_workerThrFxn_P(IArg arg)
 
         /* if no current message, wait until signaled to run */
         if (packet == NULL) {
-            Semaphore_pend(obj->pool->sem, Semaphore_FOREVER, &eb);
+            timeout = Semaphore_FOREVER;
+
+            if (RcmServer_isElastic(obj->pool) && (obj->pool->idleTimeout > 0)) {
+                timeout = obj->pool->idleTimeout;
+            }
+
+#if USE_MESSAGEQCOPY
+            /* Replies are held back while more work is ready, so that a
+             * run of short calls interrupts the host only once. They must
+             * go out before this worker blocks, runs a call which is not
+             * flagged RcmServer_FxnFlag_NONBLOCKING, or the batch is full.
+             */
+            pendStatus = Semaphore_PendStatus_TIMEOUT;
+
+            if ((numDeferred > 0)
+                && (numDeferred < obj->server->replyBatch)) {
+                pendStatus = Semaphore_pend(obj->pool->sem, 0, &eb);
+            }
+            if (pendStatus != Semaphore_PendStatus_SUCCESS) {
+                if (numDeferred > 0) {
+                    RcmServer_flushReplies_I(obj->server);
+                    numDeferred = 0;
+                }
+                pendStatus = Semaphore_pend(obj->pool->sem, timeout, &eb);
+            }
+#else
+            pendStatus = Semaphore_pend(obj->pool->sem, timeout, &eb);
+#endif
 
             if (Error_check(&eb)) {
                 Log_error0(FXNN": semaphore pend failed");
             }
+
+            /* idle too long, an extra worker of an elastic pool exits */
+            if (pendStatus == Semaphore_PendStatus_TIMEOUT) {
+                if (RcmServer_retireWorker_P(obj)) {
+                    running = FALSE;
+                    Log_print1(Diags_INFO,
+                        FXNN": retiring, thread=0x%x", (IArg)(obj->thread));
+                }
+                continue;
+            }
         }
 
         /* check if thread should terminate */
@@ -2363,7 +4384,7 @@ Void RcmServer_workerThrFxn_P(IArg arg)
 
         /* get next message from ready queue */
         if (packet == NULL) {
-            packet = (RcmClient_Packet *)List_get(readyQueueH);
+            packet = RcmServer_getReady_I(obj->pool);
         }
 
         if (packet == NULL) {
@@ -2372,16 +4393,66 @@ Void RcmServer_workerThrFxn_P(IArg arg)
             continue;
         }
 
+        /* track the ready queue depth of an elastic pool, and reclaim
+         * threads which retired since, here rather than in the server
+         * thread so that joining them does not delay dispatch */
+        if (RcmServer_isElastic(obj->pool)) {
+            gateH = GateThread_handle(&obj->server->gate);
+            key = GateThread_enter(gateH);
+            obj->pool->queued--;
+            GateThread_leave(gateH, key);
+
+            RcmServer_reapWorkers_P(obj->pool);
+        }
+
         Log_print2(Diags_INFO, FXNN": job received, thread=0x%x packet=0x%x",
             (IArg)obj->thread, (IArg)packet);
 
         /* remember the message job id */
         jobId = packet->message.jobId;
 
+        /* raise the thread priority for an urgent message */
+        runPri = basePri;
+
+        if (obj->pool->maxOsPriority != Thread_INVALID_OS_PRIORITY) {
+            runPri = basePri + RcmServer_pktPri(packet);
+
+            if (runPri > obj->pool->maxOsPriority) {
+                runPri = obj->pool->maxOsPriority;
+            }
+            if (runPri > basePri) {
+                Thread_setOsPri(self, runPri, &eb);
+            }
+        }
+
+#if USE_MESSAGEQCOPY
+        /* held replies must not wait behind a call that may run long */
+        if ((numDeferred > 0)
+            && !RcmServer_isNonBlocking_I(obj->server, packet)) {
+            RcmServer_flushReplies_I(obj->server);
+            numDeferred = 0;
+        }
+
+        /* process the message, unless it was cancelled while queued */
+        if (RcmServer_claimPacket_I(obj->server, packet)) {
+            RcmServer_process_P(obj->server, packet, FALSE);
+            numDeferred++;
+        }
+        else {
+            Log_print2(Diags_INFO, FXNN": cancelled, msgId=0x%x packet=0x%x",
+                (IArg)packet->msgId, (IArg)packet);
+        }
+        RcmServer_freePacket_I(obj->server, packet);
+#else
         /* process the message */
-        RcmServer_process_P(obj->server, packet);
+        RcmServer_process_P(obj->server, packet, TRUE);
+#endif
         packet = NULL;
 
+        if (runPri > basePri) {
+            Thread_setOsPri(self, basePri, &eb);
+        }
+
         /* If this worker thread just finished processing a job message,
          * queue up the next message for this job id. As an optimization,
          * if the message is addressed to this worker's pool, then don't
@@ -2391,27 +4462,22 @@ Void RcmServer_workerThrFxn_P(IArg arg)
          */
         if (jobId != RcmClient_DISCRETEJOBID) {
 
-            /* must protect job list while searching it */
+            /* must protect job table while searching it */
             gateH = GateThread_handle(&obj->server->gate);
             key = GateThread_enter(gateH);
 
-            /* find the job object in the list */
-            elem = NULL;
-            while ((elem = List_next(obj->server->jobList, elem)) != NULL) {
-                job = (RcmServer_JobStream *)elem;
-                if (job->jobId == jobId) {
-                    break;
-                }
-            }
+            /* find the job object in the table */
+            job = RcmServer_findJob_I(obj->server, jobId);
 
             /* if job object not found, it is not an error */
-            if (elem == NULL) {
+            if (job == NULL) {
                 GateThread_leave(gateH, key);
                 continue;
             }
 
             /* found the job object */
             listH = List_handle(&job->msgQue);
+            grow = FALSE;
 
             /* get next job message and either process it or queue it */
             do {
@@ -2424,7 +4490,8 @@ Void RcmServer_workerThrFxn_P(IArg arg)
                 else {
                     /* get target pool id */
                     packet = (RcmClient_Packet *)elem;
-                    rval = RcmServer_getPool_P(obj->server, packet, &pool);
+                    rval = RcmServer_getPool_P(obj->server,
+                        packet->message.poolId, &pool);
 
                     /* if error, return the message to the client */
                     if (rval < 0) {
@@ -2441,35 +4508,19 @@ Void RcmServer_workerThrFxn_P(IArg arg)
                         }
                         packet->message.result = rval;
 
+                        RcmServer_reply_P(obj->server, packet, FALSE);
 #if USE_MESSAGEQCOPY
-                        packet->hdr.type = OMX_RAW_MSG;
-                        packet->hdr.len = PACKET_DATA_SIZE + packet->message.dataSize;
-                        rval = MessageQCopy_send(
-                                 (obj->server)->dstProc,
-                                 (obj->server)->replyAddr,
-                                 (obj->server)->localAddr, (Ptr)&packet->hdr,
-                                 PACKET_HDR_SIZE + packet->message.dataSize);
-#else
-                        rval = MessageQ_put(
-                            MessageQ_getReplyQueue(&packet->msgqHeader),
-                            &packet->msgqHeader);
+                        RcmServer_freePacket_I(obj->server, packet);
+                        numDeferred++;
 #endif
-                        if (rval < 0) {
-                            Log_error1(
-                                FXNN": unknown ipc error, 0x%x", (IArg)rval);
-                        }
+                        packet = NULL;
+                        rval = RcmServer_E_FAIL;
                     }
                     /* packet is valid, queue it in the corresponding pool's
                      * ready queue */
                     else {
-                        listH = List_handle(&pool->readyQueue);
-                        List_put(listH, elem);
+                        grow = RcmServer_enqueue_P(obj->server, pool, packet);
                         packet = NULL;
-                        Semaphore_post(pool->sem, &eb);
-
-                        if (Error_check(&eb)) {
-                            Log_error0(FXNN": semaphore post failed");
-                        }
                     }
 
                     /* loop around and wait to be run again */
@@ -2478,14 +4529,326 @@ Void RcmServer_workerThrFxn_P(IArg arg)
             } while (rval < 0);
 
             GateThread_leave(gateH, key);
+
+            /* add a worker thread outside the gate */
+            if (grow) {
+                RcmServer_growPool_P(obj->server, pool);
+            }
         }
     }  /* while (running) */
 
+#if USE_MESSAGEQCOPY
+    /* a terminating worker may still hold deferred replies */
+    if (numDeferred > 0) {
+        RcmServer_flushReplies_I(obj->server);
+    }
+#endif
+
     Log_print0(Diags_EXIT, "<-- "FXNN":");
 }
 #undef FXNN
 
 
+/*
+ *  ======== RcmServer_getFxnLatency ========
+ */
+#define FXNN "RcmServer_getFxnLatency"
+Int RcmServer_getFxnLatency(RcmServer_Object *obj, String name,
+        UInt32 *hist, Bool reset)
+{
+    GateThread_Handle gateH;
+    IArg key;
+    UInt32 fxnIdx;
+    RcmServer_FxnTabInfo *info;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print3(Diags_ENTRY, "--> "FXNN": (obj=0x%x, name=0x%x, hist=0x%x)",
+        (IArg)obj, (IArg)name, (IArg)hist);
+
+    /* protect the symbol table while reading it */
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
+
+    status = RcmServer_getSymIdx_P(obj, name, &fxnIdx);
+
+    if (status < 0) {
+        goto leave;
+    }
+
+    info = RcmServer_getInfo_I(obj, fxnIdx);
+
+    _memcpy((Void *)hist, (Void *)info->stats.hist, sizeof(info->stats.hist));
+
+    if (reset) {
+        _memset((Void *)info->stats.hist, 0, sizeof(info->stats.hist));
+    }
+
+leave:
+    GateThread_leave(gateH, key);
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_getFxnStats ========
+ */
+#define FXNN "RcmServer_getFxnStats"
+Int RcmServer_getFxnStats(RcmServer_Object *obj, String name,
+        RcmServer_FxnStats *stats, Bool reset)
+{
+    GateThread_Handle gateH;
+    IArg key;
+    UInt32 fxnIdx;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print3(Diags_ENTRY, "--> "FXNN": (obj=0x%x, name=0x%x, stats=0x%x)",
+        (IArg)obj, (IArg)name, (IArg)stats);
+
+    /* protect the symbol table while reading it */
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
+
+    status = RcmServer_getSymIdx_P(obj, name, &fxnIdx);
+
+    if (status < 0) {
+        goto leave;
+    }
+
+    status = RcmServer_readFxnStats_P(obj, fxnIdx, stats, reset);
+
+leave:
+    GateThread_leave(gateH, key);
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_getLatency ========
+ */
+#define FXNN "RcmServer_getLatency"
+Int RcmServer_getLatency(RcmServer_Object *obj, UInt stage, UInt32 *hist,
+        Bool reset)
+{
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print3(Diags_ENTRY, "--> "FXNN": (obj=0x%x, stage=%d, hist=0x%x)",
+        (IArg)obj, (IArg)stage, (IArg)hist);
+
+    if (stage >= RcmServer_NUMLATSTAGES) {
+        Log_error1(FXNN": invalid stage %d", (IArg)stage);
+        status = RcmServer_E_INVALIDARG;
+        goto leave;
+    }
+
+    _memcpy((Void *)hist, (Void *)obj->latHist[stage],
+        sizeof(obj->latHist[stage]));
+
+    if (reset) {
+        _memset((Void *)obj->latHist[stage], 0, sizeof(obj->latHist[stage]));
+    }
+
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+#if USE_MESSAGEQCOPY
+/*
+ *  ======== RcmServer_addMemRegion ========
+ *
+ *  This function must be serialized by the caller
+ */
+#define FXNN "RcmServer_addMemRegion"
+Int RcmServer_addMemRegion(UInt32 pa, UInt32 da, UInt32 size)
+{
+    RcmServer_MemRegion *r;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print3(Diags_ENTRY, "--> "FXNN": (pa=0x%x, da=0x%x, size=0x%x)",
+        (IArg)pa, (IArg)da, (IArg)size);
+
+    if ((size == 0) || (da == 0)) {
+        status = RcmServer_E_INVALIDARG;
+        goto leave;
+    }
+
+    if (RcmServer_Mod.memMapLen >= RcmServer_MAX_MEMREGIONS) {
+        Log_error0(FXNN": memory region table is full");
+        status = RcmServer_E_NOMEMORY;
+        goto leave;
+    }
+
+    r = &RcmServer_Mod.memMap[RcmServer_Mod.memMapLen];
+    r->pa = pa;
+    r->da = da;
+    r->size = size;
+    RcmServer_Mod.memMapLen++;
+
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+
+
+/*
+ *  ======== RcmServer_reset ========
+ */
+#define FXNN "RcmServer_reset"
+Int RcmServer_reset(RcmServer_Object *obj)
+{
+    GateThread_Handle gateH;
+    IArg key;
+    RcmServer_JobStream *jobs;
+    RcmServer_JobStream *job;
+    RcmServer_ThreadPool *pool;
+    RcmServer_PktBlock *block;
+    RcmClient_Packet *pkt;
+    RcmServer_FxnTabElem *slot;
+    RcmServer_FxnTabInfo *info;
+    UInt tabCount;
+    UInt i, j;
+    Bool busy = FALSE;
+    Int rval;
+    Int status = RcmServer_S_SUCCESS;
+
+
+    Log_print1(Diags_ENTRY, "--> "FXNN": (obj=0x%x)", (IArg)obj);
+
+    /* fail before changing anything if a message is being executed */
+    for (block = obj->pktBlock; block != NULL; block = block->next) {
+        for (i = 0; (i < block->count) && !busy; i++) {
+            pkt = RcmServer_blockPkt(block, i);
+            busy = (pkt->state == RcmServer_PKT_RUNNING);
+        }
+    }
+
+    if (busy) {
+        Log_error0(FXNN": server is still executing a message");
+        status = RcmServer_E_FAIL;
+        goto leave;
+    }
+
+    /* drop all queued packets, the workers free them when dequeued */
+    for (block = obj->pktBlock; block != NULL; block = block->next) {
+        for (i = 0; i < block->count; i++) {
+            pkt = RcmServer_blockPkt(block, i);
+            key = Gate_enterSystem();
+
+            if (pkt->state == RcmServer_PKT_QUEUED) {
+                pkt->state = RcmServer_PKT_CANCELLED;
+            }
+
+            Gate_leaveSystem(key);
+        }
+    }
+
+    /* forget the previous client until the next request arrives */
+    obj->replyAddr = RcmClient_INVALIDADDR;
+    obj->dstProc = MultiProc_INVALIDID;
+
+    /* take all job streams out of the table, then release them */
+    gateH = GateThread_handle(&obj->gate);
+    key = GateThread_enter(gateH);
+    jobs = NULL;
+
+    for (i = 0; i < RcmServer_JOB_TAB_LEN; i++) {
+        while ((job = obj->jobTab[i]) != NULL) {
+            obj->jobTab[i] = job->next;
+            job->next = jobs;
+            jobs = job;
+        }
+    }
+
+    GateThread_leave(gateH, key);
+
+    while ((job = jobs) != NULL) {
+        jobs = job->next;
+        RcmServer_freeJob_P(obj, job);
+    }
+
+    /* delete the dynamic worker pools */
+    for (i = 1; i < RcmServer_POOL_MAP_LEN; i++) {
+        if (obj->poolMap[i] == NULL) {
+            continue;
+        }
+
+        for (j = 0; j < RcmServer_poolTabLen(i); j++) {
+            pool = &(obj->poolMap[i])[j];
+
+            if ((pool->key == 0) || (pool->key == RcmServer_POOL_BUSY)) {
+                continue;
+            }
+
+            rval = RcmServer_deletePool(obj,
+                (UInt16)((pool->key << 7) | (i << 5) | j));
+
+            if (rval < 0) {
+                status = rval;
+            }
+        }
+    }
+
+    /* remove the dynamic symbols, all slots go back on the free lists */
+    key = GateThread_enter(gateH);
+
+    for (i = 1; i < RcmServer_MAX_TABLES; i++) {
+        if (obj->fxnTab[i] == NULL) {
+            continue;
+        }
+
+        tabCount = (1 << (i + 4));
+
+        for (j = 0; j < tabCount; j++) {
+            slot = (obj->fxnTab[i]) + j;
+            info = (obj->fxnInfo[i]) + j;
+
+            if (info->name != NULL) {
+                RcmServer_symRemove_P(obj,
+                    (slot->key << _RCM_KeyShift) | (i << 12) | j);
+                slot->addr.fxn = 0;
+                slot->key = 0;
+                info->name = NULL;
+            }
+        }
+
+        for (j = 0; j < tabCount; j++) {
+            ((obj->fxnInfo[i])+j)->symNext =
+                (j + 1 < tabCount ? j + 1 : RcmServer_SLOT_NONE);
+        }
+        obj->fxnFree[i] = 0;
+    }
+    RcmServer_nameReset_P(obj);
+
+    /* the next client starts with clean statistics */
+    if (obj->fxnInfo[0] != NULL) {
+        for (i = 0; i < obj->fxnTabStatic.length; i++) {
+            _memset((Void *)&obj->fxnInfo[0][i].stats, 0,
+                sizeof(obj->fxnInfo[0][i].stats));
+        }
+    }
+    _memset((Void *)obj->latHist, 0, sizeof(obj->latHist));
+
+    GateThread_leave(gateH, key);
+
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return(status);
+}
+#undef FXNN
+#endif
+
+
 /*
  *  ======== RcmServer_getLocalAddress ========
  */
@@ -127,9 +127,106 @@ extern "C" {
  */
 #define RcmServer_E_SYMBOLTABLEFULL (-5)
 
+/*!
+ *  @brief An invalid argument was given
+ */
+#define RcmServer_E_INVALIDARG (-6)
+
+/*!
+ *  @brief The given worker pool id does not name a dynamic pool
+ *
+ *  The pool was never created, it has already been deleted, or the
+ *  id is for a static pool.
+ */
+#define RcmServer_E_POOLNOTFOUND (-7)
+
+/*!
+ *  @brief The server's dynamic worker pool table is full
+ */
+#define RcmServer_E_POOLTABLEFULL (-8)
+
 
 // -------- constants and types --------
 
+/*!
+ *  @brief Number of buckets in a latency histogram
+ *
+ *  Bucket b counts latencies in [4^b, 4^(b+1)) Timestamp ticks; bucket 0
+ *  also counts latencies of 0 ticks. See Timestamp_getFreq().
+ */
+#define RcmServer_NUMLATBUCKETS (16)
+
+/*!
+ *  @brief Latency stage: from message receipt until processing begins
+ *
+ *  This is the time spent waiting on the worker pool's ready queue (or
+ *  job stream queue).
+ */
+#define RcmServer_LatStage_QUEUE (0)
+
+/*!
+ *  @brief Latency stage: execution of the remote function
+ */
+#define RcmServer_LatStage_EXEC (1)
+
+/*!
+ *  @brief Latency stage: from message receipt until the reply is sent
+ */
+#define RcmServer_LatStage_TOTAL (2)
+
+/*!
+ *  @brief Number of latency stages
+ */
+#define RcmServer_NUMLATSTAGES (3)
+
+/*!
+ *  @brief Default value of RcmServer_Params.replyBatch
+ */
+#define RcmServer_DEFREPLYBATCH (8)
+
+/*!
+ *  @brief Execution statistics of a remote function
+ *
+ *  Times are in Timestamp ticks, see Timestamp_getFreq(). The average
+ *  execution time is totalTime / calls.
+ *
+ *  A remote client reads these with an RcmClient_Desc_FXN_STATS message
+ *  whose fxnIdx field names the function. On input, a nonzero first data
+ *  word requests a reset; the reply data holds this structure.
+ */
+typedef struct {
+    /*!
+     *  @brief Number of calls
+     */
+    UInt32 calls;
+
+    /*!
+     *  @brief Number of calls which returned a negative result
+     */
+    UInt32 errors;
+
+    /*!
+     *  @brief Shortest execution time
+     */
+    UInt32 minTime;
+
+    /*!
+     *  @brief Longest execution time
+     */
+    UInt32 maxTime;
+
+    /*!
+     *  @brief Sum of all execution times
+     */
+    UInt64 totalTime;
+
+    /*!
+     *  @brief Execution time histogram, see RcmServer_NUMLATBUCKETS
+     */
+    UInt32 hist[RcmServer_NUMLATBUCKETS];
+
+} RcmServer_FxnStats;
+
 /*!
  *  @brief Remote function type
  *
@@ -159,6 +256,18 @@ typedef Int32 (*RcmServer_MsgCreateFxn)(Void *, UInt32, UInt32 *);
 
 
 
+/*!
+ *  @brief Function flag: the function never blocks
+ *
+ *  The server may then run the function directly in the MessageQCopy
+ *  receive Swi, and reply from there, instead of passing the message to
+ *  its server thread. This only applies to static functions (see
+ *  RcmServer_Params.fxns) called with plain RcmClient_Desc_RCM_MSG
+ *  messages outside a job stream. Such a function runs at Swi priority:
+ *  it must be short and may not pend on anything.
+ */
+#define RcmServer_FxnFlag_NONBLOCKING (0x0001)
+
 /*!
  *  @brief Function descriptor
  *
@@ -191,6 +300,13 @@ typedef struct {
     RcmServer_MsgFxn addr;
 #endif
 
+    /*!
+     *  @brief Function flags, a bitwise OR of RcmServer_FxnFlag values.
+     *
+     *  May be left out of a static initializer, which gives zero.
+     */
+    UInt16 flags;
+
 } RcmServer_FxnDesc;
 
 /*!
@@ -243,6 +359,18 @@ typedef struct {
      */
     Int osPriority;
 
+    /*!
+     *  @brief The highest priority (OS-specific) of a worker thread
+     *
+     *  While executing a message of priority class n (see
+     *  RcmClient_Desc_PRI_MASK), a worker thread runs n levels above
+     *  its pool priority, but never above this value. The default,
+     *  Thread_INVALID_OS_PRIORITY, leaves all workers at the pool
+     *  priority. Urgent messages are always taken from the ready queue
+     *  first.
+     */
+    Int maxOsPriority;
+
     /*!
      *  @brief The stack size in bytes of a worker thread.
      */
@@ -253,6 +381,26 @@ typedef struct {
      */
     String stackSeg;
 
+    /*!
+     *  @brief The maximum number of worker threads in the pool.
+     *
+     *  When larger than count, the pool is elastic: worker threads
+     *  are added on demand and extra threads exit when idle. Use 0
+     *  for a fixed size pool.
+     */
+    UInt maxCount;
+
+    /*!
+     *  @brief Ready queue depth at which an elastic pool adds a thread.
+     */
+    UInt growDepth;
+
+    /*!
+     *  @brief Idle time in microseconds before an extra worker thread
+     *  of an elastic pool exits. Use 0 to keep extra threads forever.
+     */
+    UInt idleTimeout;
+
 } RcmServer_ThreadPoolDesc;
 
 /*!
@@ -365,6 +513,31 @@ typedef struct {
      */
     RcmServer_FxnDescAry fxns;
 
+    /*!
+     *  @brief Number of inbound packet buffers owned by the server.
+     *
+     *  Every received message is held in one of these buffers until its
+     *  reply has been sent, which lets messages wait on a worker pool's
+     *  ready queue or on a job stream queue. When all buffers are in use,
+     *  the server thread stops reading messages until one is released.
+     *  A value of zero gives one buffer per worker thread each pool may
+     *  grow to (its maxCount) plus a few extra, and adds buffers for each
+     *  pool made by RcmServer_createPool. A non-zero value is fixed.
+     */
+    UInt packetCount;
+
+    /*!
+     *  @brief Maximum number of worker replies sent with one host interrupt.
+     *
+     *  A worker thread which finds more messages on its pool's ready queue
+     *  sends its reply without interrupting the host, and interrupts it
+     *  once for the whole run when the queue drains or this many replies
+     *  are pending. Held back replies only wait behind calls to functions
+     *  flagged RcmServer_FxnFlag_NONBLOCKING; they are sent before any
+     *  other call runs. Replies from the server thread are never held back.
+     */
+    UInt replyBatch;
+
 } RcmServer_Params;
 
 /*!
@@ -378,18 +551,36 @@ typedef struct {
     GateThread_Struct   _f1;
     Ptr                 _f2;
     Ptr                 _f3;
+#if USE_MESSAGEQCOPY
+    UInt32              _f3a[3];
+#endif
     Ptr                 _f4;
     struct {
         Int     _f1;
         Ptr     _f2;
     }                   _f5;
     Ptr                 _f6[9];
+    Ptr                 _f6a[9];
+    UInt16              _f6b[9];
+    Ptr                 _f6c;
+    Ptr                 _f6d;
+    UInt                _f6e;
     UInt16              _f7;
     UInt16              _f8;
+    UInt16              _f8a;
     Bool                _f9;
     Int                 _f10;
     Ptr                 _f11[4];
     Ptr                 _f12;
+    UInt32              _f13[3][16];
+#if USE_MESSAGEQCOPY
+    Ptr                 _f14;
+    UInt                _f15;
+    UInt                _f15a;
+    Bool                _f15b;
+    Ptr                 _f16[2];
+    UInt                _f18;
+#endif
 } RcmServer_Struct;
 
 
@@ -484,6 +675,36 @@ Int RcmServer_create(
         RcmServer_Handle *      handle
     );
 
+/*
+ *  ======== RcmServer_createPool ========
+ */
+/*!
+ *  @brief Create a worker pool at runtime
+ *
+ *  The new pool is addressed by the returned dynamic pool id, which the
+ *  client places in RcmClient_Message.poolId. The pool's worker threads
+ *  are created before this function returns.
+ *
+ *  @param[in] handle Handle to an instance object.
+ *
+ *  @param[in] desc Name, thread count, priority and stack size of the pool.
+ *
+ *  @param[out] poolId The pool's id.
+ *
+ *  @retval RcmServer_S_SUCCESS
+ *  @retval RcmServer_E_INVALIDARG
+ *  @retval RcmServer_E_NOMEMORY
+ *  @retval RcmServer_E_POOLTABLEFULL
+ *  @retval RcmServer_E_FAIL
+ *
+ *  @sa RcmServer_deletePool
+ */
+Int RcmServer_createPool(
+        RcmServer_Handle        handle,
+        const RcmServer_ThreadPoolDesc *desc,
+        UInt16 *                poolId
+    );
+
 /*
  *  ======== RcmServer_delete ========
  */
@@ -496,6 +717,31 @@ Int RcmServer_delete(
         RcmServer_Handle *      handlePtr
     );
 
+/*
+ *  ======== RcmServer_deletePool ========
+ */
+/*!
+ *  @brief Delete a worker pool created with RcmServer_createPool()
+ *
+ *  New messages for the pool are rejected with a pool-not-found status
+ *  as soon as this function is called. Messages already running are
+ *  allowed to finish. Messages still queued for the pool are returned
+ *  to the client unprocessed.
+ *
+ *  @param[in] handle Handle to an instance object.
+ *
+ *  @param[in] poolId The id returned by RcmServer_createPool().
+ *
+ *  @retval RcmServer_S_SUCCESS
+ *  @retval RcmServer_E_INVALIDARG
+ *  @retval RcmServer_E_POOLNOTFOUND
+ *  @retval RcmServer_E_FAIL
+ */
+Int RcmServer_deletePool(
+        RcmServer_Handle        handle,
+        UInt16                  poolId
+    );
+
 /*
  *  ======== RcmServer_destruct ========
  */
@@ -523,6 +769,88 @@ Int RcmServer_destruct(
  */
 Void RcmServer_exit(Void);
 
+/*
+ *  ======== RcmServer_getFxnLatency ========
+ */
+/*!
+ *  @brief Read a remote function's execution latency histogram
+ *
+ *  Each call of the named function is timed and counted in this histogram.
+ *  Counts are updated without locking and may be approximate when the
+ *  function runs concurrently in several worker threads.
+ *
+ *  @param[in] handle Handle to an instance object.
+ *
+ *  @param[in] name The function's name.
+ *
+ *  @param[out] hist Array of RcmServer_NUMLATBUCKETS counts.
+ *
+ *  @param[in] reset Clear the histogram after reading it.
+ *
+ *  @retval RcmServer_S_SUCCESS
+ *  @retval RcmServer_E_SYMBOLNOTFOUND
+ */
+Int RcmServer_getFxnLatency(
+        RcmServer_Handle        handle,
+        String                  name,
+        UInt32 *                hist,
+        Bool                    reset
+    );
+
+/*
+ *  ======== RcmServer_getFxnStats ========
+ */
+/*!
+ *  @brief Read a remote function's execution statistics
+ *
+ *  Counts are updated without locking and may be approximate when the
+ *  function runs concurrently in several worker threads.
+ *
+ *  @param[in] handle Handle to an instance object.
+ *
+ *  @param[in] name The function's name.
+ *
+ *  @param[out] stats The function's statistics.
+ *
+ *  @param[in] reset Clear the statistics after reading them.
+ *
+ *  @retval RcmServer_S_SUCCESS
+ *  @retval RcmServer_E_SYMBOLNOTFOUND
+ */
+Int RcmServer_getFxnStats(
+        RcmServer_Handle        handle,
+        String                  name,
+        RcmServer_FxnStats *    stats,
+        Bool                    reset
+    );
+
+/*
+ *  ======== RcmServer_getLatency ========
+ */
+/*!
+ *  @brief Read one of the server's per-stage latency histograms
+ *
+ *  Together with MessageQCopy_getLatency(), these histograms show where
+ *  the time between a message's arrival and its reply is spent.
+ *
+ *  @param[in] handle Handle to an instance object.
+ *
+ *  @param[in] stage One of the RcmServer_LatStage values.
+ *
+ *  @param[out] hist Array of RcmServer_NUMLATBUCKETS counts.
+ *
+ *  @param[in] reset Clear the histogram after reading it.
+ *
+ *  @retval RcmServer_S_SUCCESS
+ *  @retval RcmServer_E_INVALIDARG
+ */
+Int RcmServer_getLatency(
+        RcmServer_Handle        handle,
+        UInt                    stage,
+        UInt32 *                hist,
+        Bool                    reset
+    );
+
 /*
  *  ======== RcmServer_init ========
  */
@@ -587,6 +915,65 @@ Int RcmServer_start(
 
 
 #if USE_MESSAGEQCOPY
+/*
+ *  ======== RcmServer_addMemRegion ========
+ */
+/*!
+ *  @brief Register a host memory region for pointer arguments
+ *
+ *  Messages may pass buffers by host physical address (see
+ *  RcmClient_Desc_PTRARGS). Such a buffer must lie entirely inside a
+ *  registered region; its address is translated to the device address
+ *  before the remote function is called. Typically the carveout and
+ *  device memory entries of the resource table are registered at
+ *  startup.
+ *
+ *  This function must be serialized by the caller.
+ *
+ *  @param[in] pa Host physical address of the region.
+ *
+ *  @param[in] da Device address of the region.
+ *
+ *  @param[in] size Size of the region in bytes.
+ *
+ *  @retval RcmServer_S_SUCCESS
+ *  @retval RcmServer_E_INVALIDARG
+ *  @retval RcmServer_E_NOMEMORY
+ */
+Int RcmServer_addMemRegion(
+        UInt32                  pa,
+        UInt32                  da,
+        UInt32                  size
+    );
+
+/*
+ *  ======== RcmServer_reset ========
+ */
+/*!
+ *  @brief Return a started server to its freshly created state
+ *
+ *  Lets a server instance be reused for a new client once the previous
+ *  one has gone. Queued messages are dropped, job streams are released
+ *  (returning their queued messages unprocessed), dynamic worker pools
+ *  are deleted, dynamic symbols are removed and the statistics are
+ *  cleared. The server thread and its endpoint are kept.
+ *
+ *  The remote address and processor are cleared until the next client
+ *  sends its first message, see RcmServer_getRemoteAddress().
+ *
+ *  Fails, without changing anything, if the server is still executing a
+ *  message; the instance must then be deleted instead. The caller must
+ *  make sure no new messages arrive during the reset.
+ *
+ *  @param[in] handle Handle to an instance object.
+ *
+ *  @retval RcmServer_S_SUCCESS
+ *  @retval RcmServer_E_FAIL The server is still executing a message
+ */
+Int RcmServer_reset(
+        RcmServer_Handle        handle
+    );
+
 /*
  *  ======== RcmServer_getLocalAddress ========
  */
@@ -607,6 +994,10 @@ UInt32 RcmServer_getLocalAddress(
 /*!
  *  @brief Get the remote messageQ endpoint for the client of this server.
  *
+ *  This is the source of the last request received. It is
+ *  RcmClient_INVALIDADDR before the first request, and again after
+ *  RcmServer_reset().
+ *
  *  @param[in] handle Handle to an instance object.
  *
  *  @retval 32 bit address.
@@ -65,7 +65,9 @@
  *
  *  Bits    Description
  *  --------------------------------------------------------------------
- *  [15:12] reserved
+ *  [15]    client private, returned unchanged in the reply
+ *  [14]    payload starts with pointer descriptors (RcmClient_PtrArg)
+ *  [13:12] priority class, 0 = normal, 3 = most urgent
  *  [11:8]  message type
  *  [7:0]   client protocol version
  *
@@ -74,7 +76,7 @@
  *
  *  Bits    Description
  *  --------------------------------------------------------------------
- *  [15:12] reserved
+ *  [15:12] copied from the out-bound message descriptor
  *  [11:8]  server status code
  *  [7:0]   server protocol version
  */
@@ -87,9 +89,35 @@
 #define RcmClient_Desc_CMD        0x5       // cmd message (one-way)
 #define RcmClient_Desc_JOB_ACQ    0x6       // acquire a job id
 #define RcmClient_Desc_JOB_REL    0x7       // release a job id
+#define RcmClient_Desc_BATCH      0x8       // batch of exec calls
+#define RcmClient_Desc_FXN_STATS  0x9       // read fxn execution stats
+#define RcmClient_Desc_CANCEL     0xA       // cancel queued messages
 #define RcmClient_Desc_TYPE_MASK  0x0F00    // field mask
 #define RcmClient_Desc_TYPE_SHIFT 8         // field shift width
 
+/* priority class values */
+#define RcmClient_Desc_PRI_MASK   0x3000    // field mask
+#define RcmClient_Desc_PRI_SHIFT  12        // field shift width
+#define RcmClient_Desc_NUMPRI     4         // number of priority classes
+
+/* pointer arguments, see RcmClient_PtrArg */
+#define RcmClient_Desc_PTRARGS    0x4000    // flag: pointer descriptors
+
+/* client private flag, marks pipelined messages (see RcmClient_submit) */
+#define RcmClient_Desc_PIPE       0x8000
+
+/* client protocol versions; from RcmClient_PROTO_TTL on, the last four
+ * bytes of the data buffer (counted in dataSize) hold a time-to-live in
+ * microseconds, zero for no limit. The server takes it off the message
+ * before the call and restores it in the reply. */
+#define RcmClient_Desc_VER_MASK   0x00FF    // field mask
+#define RcmClient_PROTO_TTL       0x01      // message carries a time-to-live
+
+/* cancel message modes, in data[0]; data[1] holds the msgId or job id */
+#define RcmClient_Cancel_MSGID    0         // the message with this msgId
+#define RcmClient_Cancel_JOB      1         // all messages of this job id
+#define RcmClient_Cancel_ALL      2         // all queued messages
+
 /* server status codes must be 0 - 15, it has to fit in a 4-bit field */
 #define RcmServer_Status_SUCCESS          ((UInt16)0) // success
 #define RcmServer_Status_INVALID_FXN      ((UInt16)1) // invalid fxn index
@@ -100,6 +128,54 @@
 #define RcmServer_Status_Unprocessed      ((UInt16)6) // unprocessed message
 #define RcmServer_Status_JobNotFound      ((UInt16)7) // job id not found
 #define RcmServer_Status_PoolNotFound     ((UInt16)8) // pool id not found
+#define RcmServer_Status_Expired          ((UInt16)9) // time-to-live passed
+
+/*
+ *  ======== RcmClient_BatchCall ========
+ *
+ *  A batch message (RcmClient_Desc_BATCH) carries a sequence of calls in
+ *  its data buffer, packed back to back. Each call record is padded to
+ *  a 4-byte boundary. The server executes the calls in order, stores
+ *  each result and status code in the record, and returns the whole
+ *  batch in one reply. The message result field is set to the number
+ *  of calls executed.
+ */
+typedef struct {
+    UInt32  fxnIdx;     // function index
+    Int32   result;     // out: function return value
+    UInt16  status;     // out: server status code for this call
+    UInt16  dataSize;   // size of data in chars
+    UInt32  data[1];    // function payload
+} RcmClient_BatchCall;
+
+#define RcmClient_BatchCall_HDR_SIZE (3 * sizeof(UInt32))
+#define RcmClient_BatchCall_SIZE(dataSize) \
+    (RcmClient_BatchCall_HDR_SIZE + (((dataSize) + 3) & ~3))
+
+/*
+ *  ======== RcmClient_PtrArg ========
+ *
+ *  An exec or cmd message with the RcmClient_Desc_PTRARGS flag set passes
+ *  buffers by reference instead of copying them into the message. Its
+ *  data buffer starts with a descriptor count, data[0], followed by that
+ *  many RcmClient_PtrArg descriptors and then the function payload.
+ *
+ *  Each descriptor marks a 32-bit payload field holding the host physical
+ *  address of a buffer. The buffer must be inside a region registered
+ *  with RcmServer_addMemRegion(). The server replaces the field with the
+ *  device address while the function runs, invalidates the buffer in the
+ *  cache before the call (IN) and writes it back after the call (OUT).
+ *  The function receives only the payload.
+ */
+typedef struct {
+    UInt32  offset;     // byte offset of the address field in the payload
+    UInt32  size;       // size of the referenced buffer in chars
+    UInt32  flags;      // RcmClient_PtrArg_IN and/or RcmClient_PtrArg_OUT
+} RcmClient_PtrArg;
+
+#define RcmClient_PtrArg_IN       0x1       // host wrote the buffer
+#define RcmClient_PtrArg_OUT      0x2       // host reads the buffer back
+#define RcmClient_MAXPTRARGS      8         // max descriptors per message
 
 /* the packet structure (actual message send to server) */
 
@@ -111,11 +187,16 @@ struct rpmsg_omx_hdr {
     UInt32 len;
 };
 
-// Warning: This packet cannot be placed on RCMServer job queues, so can't use
-// that capability for now.
+// The server receives each packet into a buffer from its packet pool, which
+// stays valid until the reply is sent, so packets may wait on job queues.
 typedef struct {
     Bits32             reserved0; // reserved for List.elem->next
     Bits32             reserved1; // reserved for List.elem->prev
+    Bits32             recvTime;  // local only: server receive timestamp
+    Bits32             ttl;       // local only: time-to-live, 0 = none
+    Bits32             replyAddr; // local only: endpoint to reply to
+    Bits16             replyProc; // local only: processor to reply to
+    Bits16             state;     // local only: server packet state
     struct rpmsg_omx_hdr hdr;
     UInt16             desc;      // protocol, descriptor, status
     UInt16             msgId;     // message id
@@ -124,11 +205,20 @@ typedef struct {
 
 /*
  * Defined to equal packed structure size received on the host.
- * Strips off the first two ListElem fields and the .data[1] field in .message
+ * Strips off the first two ListElem fields, the recvTime, ttl, replyAddr,
+ * replyProc and state fields and the .data[1] field in .message
  */
-#define PACKET_HDR_SIZE  (sizeof(RcmClient_Packet) - 3 * sizeof(UInt32))
+#define PACKET_HDR_SIZE  (sizeof(RcmClient_Packet) - 7 * sizeof(UInt32))
 #define PACKET_DATA_SIZE (PACKET_HDR_SIZE - sizeof(struct rpmsg_omx_hdr))
 
+/* largest packet the transport carries, header included */
+#define PACKET_MAXSIZE   MessageQCopy_MAXPAYLOADSIZE
+
+/* size of a packet buffer, the local-only fields plus the largest packet */
+#define MSGBUFFERSIZE \
+    (sizeof(RcmClient_Packet) - PACKET_HDR_SIZE - sizeof(UInt32) + \
+    PACKET_MAXSIZE)
+
 /* To test on BIOS side only, uncomment and rebuild anything that
  * calls MessageQCopy()
  */
@@ -146,6 +236,7 @@ typedef struct {
 
 /* string functions */
 Void *_memset(Void *s, Int c, Int n);
+Void *_memcpy(Void *s, const Void *t, Int n);
 Int _strcmp(Char *s, Char *t);
 Void _strcpy(Char *s, Char *t);
 Int _strlen(const Char *s);
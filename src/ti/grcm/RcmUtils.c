@@ -55,6 +55,22 @@ Void *_memset(Void *s, Int c, Int n)
 }
 
 
+/*
+ *  ======== _memcpy ========
+ */
+Void *_memcpy(Void *s, const Void *t, Int n)
+{
+    UChar *p = (UChar *)s;
+    const UChar *q = (const UChar *)t;
+
+    while (n-- > 0) {
+        *p++ = *q++;
+    }
+
+    return(s);
+}
+
+
 /*
  *  ======== _strcpy ========
  *  Copy t to s, including null character.
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** ============================================================================
+ *  @file       EventLog.c
+ *
+ *  @brief      Binary event log for the rpmsg/RCM message paths.
+ *
+ *  The event log header should be included in an application as follows:
+ *  @code
+ *  #include <ti/ipc/rpmsg/EventLog.h>
+ *  @endcode
+ *
+ */
+
+#include <xdc/std.h>
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
+
+#include <ti/sysbios/hal/Hwi.h>
+
+#include <ti/ipc/rpmsg/EventLog.h>
+
+EventLog_Buf EventLog_buf = {
+    EventLog_MAGIC,
+    EventLog_NUMRECS,
+    0,
+    0
+};
+
+/*!
+ * ======== EventLog_write4 ========
+ */
+Void EventLog_write4(UInt32 event, UArg a0, UArg a1, UArg a2, UArg a3)
+{
+    EventLog_Rec *rec;
+    Types_FreqHz freq;
+    UInt32 seq;
+    UInt key;
+
+    /* the host needs the timestamp rate to show times */
+    if (EventLog_buf.freq == 0) {
+        Timestamp_getFreq(&freq);
+        EventLog_buf.freq = freq.lo;
+    }
+
+    /* reserve a record; sequence numbers start at 1 */
+    key = Hwi_disable();
+    seq = ++EventLog_buf.head;
+    Hwi_restore(key);
+
+    rec = &EventLog_buf.rec[seq & (EventLog_NUMRECS - 1)];
+
+    /* mark the record invalid until it is complete */
+    rec->seq = 0;
+    rec->time = Timestamp_get32();
+    rec->event = event;
+    rec->arg[0] = (UInt32)a0;
+    rec->arg[1] = (UInt32)a1;
+    rec->arg[2] = (UInt32)a2;
+    rec->arg[3] = (UInt32)a3;
+    rec->seq = seq;
+}
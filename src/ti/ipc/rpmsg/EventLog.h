@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** ============================================================================
+ *  @file       EventLog.h
+ *
+ *  @brief      Binary event log for the rpmsg/RCM message paths.
+ *
+ *  Each event is a fixed-size record (sequence number, timestamp, event
+ *  id and up to four arguments) written to a ring buffer in this core's
+ *  memory. No text is formatted on the target; the ring is exported to
+ *  the host as a trace resource and turned back into text there by the
+ *  readevlog utility (src/utils/readevlog.c).
+ *
+ *  A writer only reserves a sequence number with interrupts disabled;
+ *  the record itself is filled in without holding any lock. The sequence
+ *  field of a record is written last, and is zero while the record is
+ *  being filled, so the host can discard torn records.
+ *
+ *  The ring layout and event ids below are shared with readevlog.c, and
+ *  must be kept in sync with it.
+ *
+ *  ============================================================================
+ */
+
+#ifndef ti_ipc_EventLog__include
+#define ti_ipc_EventLog__include
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ *  @brief  Number of records in the ring, must be a power of two.
+ */
+#define EventLog_NUMRECS        256
+
+/*!
+ *  @brief  Ring header magic number ("EVLG").
+ */
+#define EventLog_MAGIC          0x474C5645
+
+/* RcmServer events */
+#define EventLog_RCM_DISPATCH   0x0100  /* poolId, jobId, fxnIdx, dataSize */
+
+/* ServiceMgr events */
+#define EventLog_SRVMGR_START   0x0200  /* port */
+#define EventLog_SRVMGR_RECV    0x0201  /* msg type, src addr, len */
+#define EventLog_SRVMGR_CONNECT 0x0202  /* len */
+#define EventLog_SRVMGR_DISC    0x0203  /* len, service addr */
+#define EventLog_SRVMGR_REPLY   0x0204  /* msg type, dst addr, src addr */
+#define EventLog_SRVMGR_CREATE  0x0205  /* service addr, service type */
+#define EventLog_SRVMGR_DELETE  0x0206  /* service addr */
+
+/*!
+ *  @brief  One event record (32 bytes).
+ */
+typedef struct EventLog_Rec {
+    UInt32      seq;            /*!< sequence number, 0 = empty */
+    UInt32      time;           /*!< Timestamp_get32() value */
+    UInt32      event;          /*!< event id */
+    UInt32      arg[4];         /*!< event arguments */
+    UInt32      reserved;
+} EventLog_Rec;
+
+/*!
+ *  @brief  The ring buffer, as seen by the host.
+ */
+typedef struct EventLog_Buf {
+    UInt32      magic;          /*!< EventLog_MAGIC */
+    UInt32      numRecs;        /*!< EventLog_NUMRECS */
+    UInt32      head;           /*!< sequence number of newest record */
+    UInt32      freq;           /*!< timestamp frequency in Hz */
+    EventLog_Rec rec[EventLog_NUMRECS];
+} EventLog_Buf;
+
+/*!
+ *  @brief  The ring buffer of this core.
+ */
+extern EventLog_Buf EventLog_buf;
+
+/*!
+ *  @brief      Write an event record.
+ *
+ *  May be called in any context.
+ *
+ *  @param[in]  event   Event id.
+ *  @param[in]  a0      First event argument.
+ *  @param[in]  a1      Second event argument.
+ *  @param[in]  a2      Third event argument.
+ *  @param[in]  a3      Fourth event argument.
+ */
+Void EventLog_write4(UInt32 event, UArg a0, UArg a1, UArg a2, UArg a3);
+
+#define EventLog_write0(event) \
+    EventLog_write4((event), 0, 0, 0, 0)
+#define EventLog_write1(event, a0) \
+    EventLog_write4((event), (UArg)(a0), 0, 0, 0)
+#define EventLog_write2(event, a0, a1) \
+    EventLog_write4((event), (UArg)(a0), (UArg)(a1), 0, 0)
+#define EventLog_write3(event, a0, a1, a2) \
+    EventLog_write4((event), (UArg)(a0), (UArg)(a1), (UArg)(a2), 0)
+
+#if defined (__cplusplus)
+}
+#endif /* defined (__cplusplus) */
+#endif /* ti_ipc_EventLog__include */
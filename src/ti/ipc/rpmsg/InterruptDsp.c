@@ -66,8 +66,9 @@
 
 #define MAILBOX_BASEADDR    (0x4A0F4000)
 
-#define MAILBOX_MESSAGE(M)  (MAILBOX_BASEADDR + 0x040 + (0x4 * M))
-#define MAILBOX_STATUS(M)   (MAILBOX_BASEADDR + 0x0C0 + (0x4 * M))
+#define MAILBOX_MESSAGE(M)      (MAILBOX_BASEADDR + 0x040 + (0x4 * M))
+#define MAILBOX_FIFOSTATUS(M)   (MAILBOX_BASEADDR + 0x080 + (0x4 * M))
+#define MAILBOX_STATUS(M)       (MAILBOX_BASEADDR + 0x0C0 + (0x4 * M))
 #define MAILBOX_REG_VAL(M)  (0x1 << (2 * M))
 
 #define MAILBOX_IRQSTATUS_CLR_DSP   (MAILBOX_BASEADDR + 0x114)
@@ -76,6 +77,13 @@
 
 Hwi_FuncPtr userFxn = NULL;
 
+static UInt16 sysm3ProcId;
+static UInt16 appm3ProcId;
+static UInt16 hostProcId;
+
+/* Last payload written to the host mailbox, for send coalescing */
+static UArg lastHostPayload = INVALIDPAYLOAD;
+
 Void InterruptDsp_isr(UArg arg);
 
 /*
@@ -110,6 +118,10 @@ Void InterruptDsp_intRegister(Hwi_FuncPtr fxn)
     Hwi_Params  hwiAttrs;
     UInt        key;
 
+    hostProcId      = MultiProc_getId("HOST");
+    sysm3ProcId     = MultiProc_getId("CORE0");
+    appm3ProcId     = MultiProc_getId("CORE1");
+
     while (InterruptDsp_intClear() != (UInt)-1);
 
     userFxn = fxn;
@@ -141,15 +153,40 @@ Void InterruptDsp_intRegister(Hwi_FuncPtr fxn)
 /*!
  *  ======== InterruptDsp_intSend ========
  *  Send interrupt to the remote processor
+ *
+ *  Waits while the target mailbox FIFO is full.  A vring kick to the host
+ *  is dropped if the previous kick for the same vring is still unread in
+ *  the FIFO: the host drains the whole vring when it reads that one.  This
+ *  relies on the DSP being the only writer of HOST_MBX_1.
  */
 Void InterruptDsp_intSend(UInt16 remoteProcId, UArg arg)
 {
-    if (remoteProcId == MultiProc_getId("CORE0")) {
+    UInt        key;
+
+    if (remoteProcId == hostProcId) {
+        key = Hwi_disable();
+        if ((arg == lastHostPayload) && ((arg & 0xFFFF0000) == 0) &&
+            (REG32(MAILBOX_STATUS(HOST_MBX_1)) != 0)) {
+            Hwi_restore(key);
+            return;
+        }
+        while (REG32(MAILBOX_FIFOSTATUS(HOST_MBX_1)));
+        REG32(MAILBOX_MESSAGE(HOST_MBX_1)) = arg;
+        lastHostPayload = arg;
+        Hwi_restore(key);
+    }
+    else if (remoteProcId == sysm3ProcId) {
+        while (REG32(MAILBOX_FIFOSTATUS(SYSM3_MBX)));
         REG32(MAILBOX_MESSAGE(SYSM3_MBX)) = arg;
     }
-    else if (remoteProcId == MultiProc_getId("CORE1")) {
+    else if (remoteProcId == appm3ProcId) {
+        while (REG32(MAILBOX_FIFOSTATUS(APPM3_MBX)));
         REG32(MAILBOX_MESSAGE(APPM3_MBX)) = arg;
     }
+    else {
+        /* Should never get here */
+        Assert_isTrue(FALSE, NULL);
+    }
 }
 
 /*!
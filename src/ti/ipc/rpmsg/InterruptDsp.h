@@ -59,6 +59,9 @@ Void InterruptDsp_intRegister(Hwi_FuncPtr fxn);
 /*!
  *  ======== InterruptDsp_intSend ========
  *  Send interrupt to the remote processor
+ *
+ *  Blocks while the target mailbox is full; repeated vring kicks to the
+ *  host are coalesced while the previous one is still pending.
  */
 Void InterruptDsp_intSend(UInt16 remoteProcId,  UArg arg);
 
@@ -50,7 +50,9 @@
 #include <xdc/runtime/Registry.h>
 #include <xdc/runtime/Log.h>
 #include <xdc/runtime/Diags.h>
+#include <xdc/runtime/Timestamp.h>
 
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Swi.h>
 #include <ti/sysbios/knl/Semaphore.h>
 #include <ti/sysbios/heaps/HeapBuf.h>
@@ -59,6 +61,8 @@
 #include <ti/sdo/utils/List.h>
 #include <ti/ipc/MultiProc.h>
 
+#include <string.h>
+
 #include "MessageQCopy.h"
 #include "VirtQueue.h"
 
@@ -70,9 +74,13 @@
 /* Various arbitrary limits: */
 #define MAXMESSAGEQOBJECTS     256
 #define MAXMESSAGEBUFFERS      512
-#define MSGBUFFERSIZE          512   // Max payload + sizeof(ListElem)
-#define MAXHEAPSIZE            (MAXMESSAGEBUFFERS * MSGBUFFERSIZE)
 #define HEAPALIGNMENT          8
+#define MAXSETMEMBERS          32
+#define MAXPAYLOADSIZE         MessageQCopy_MAXPAYLOADSIZE
+/* Max payload + sizeof(Queue_elem), rounded up to the heap alignment: */
+#define MSGBUFFERSIZE          ((MAXPAYLOADSIZE + sizeof(Queue_elem) + \
+                                 HEAPALIGNMENT - 1) & ~(HEAPALIGNMENT - 1))
+#define MAXHEAPSIZE            (MAXMESSAGEBUFFERS * MSGBUFFERSIZE)
 
 /* The MessageQCopy Object */
 typedef struct MessageQCopy_Object {
@@ -80,8 +88,21 @@ typedef struct MessageQCopy_Object {
     Semaphore_Handle semHandle;    /* I/O Completion                        */
     List_Handle      queue;        /* Queue of pending messages             */
     Bool             unblocked;    /* Use with signal to unblock _receive() */
+    struct MessageQCopy_SetObject *set; /* Endpoint set we belong to, if any */
+    UInt32           latHist[MessageQCopy_NUMLATBUCKETS]; /* queued->recv'd */
+    MessageQCopy_RecvFxn recvFxn;  /* Receive hook, called in the Swi      */
+    UArg             recvArg;      /* Argument to recvFxn                   */
 } MessageQCopy_Object;
 
+/* The MessageQCopy endpoint set Object */
+typedef struct MessageQCopy_SetObject {
+    Semaphore_Handle semHandle;    /* Counts msgs queued on all members     */
+    UInt             numMembers;   /* Number of valid entries in members[]  */
+    UInt             next;         /* Round robin start index for waitAny() */
+    Bool             unblocked;    /* Use with signal to unblock waitAny()  */
+    MessageQCopy_Object *members[MAXSETMEMBERS];
+} MessageQCopy_SetObject;
+
 /* Module_State */
 typedef struct MessageQCopy_Module {
     /* Instance gate: */
@@ -90,6 +111,14 @@ typedef struct MessageQCopy_Module {
     struct MessageQCopy_Object  *msgqObjects[MAXMESSAGEQOBJECTS];
     /* Heap from which to allocate free messages for copying: */
     HeapBuf_Handle              heap;
+    /* Time of the last fromHost kick not yet seen by the Swi: */
+    Bool                        kickPending;
+    UInt32                      kickTime;
+    /* Latency from fromHost kick to Swi processing: */
+    UInt32                      swiLatHist[MessageQCopy_NUMLATBUCKETS];
+    /* Buffers published on a vring by sendNoKick, not yet kicked: */
+    Bool                        toHostPending;
+    Bool                        toPeerPending;
 } MessageQCopy_Module;
 
 /* Message Header: Must match mp_msg_hdr in virtio_rp_msg.h on Linux side. */
@@ -107,8 +136,10 @@ typedef MessageQCopy_MsgHeader *MessageQCopy_Msg;
 /* Element to hold payload copied onto receiver's queue.                  */
 typedef struct Queue_elem {
     List_Elem    elem;              /* Allow list linking.                */
-    UInt         len;               /* Length of data                     */
+    UInt16       len;               /* Length of data                     */
+    UInt16       srcProc;           /* Src processor of the msg           */
     UInt32       src;               /* Src address/endpt of the msg       */
+    UInt32       ts;                /* Timestamp when queued              */
     Char         data[];            /* payload begins here                */
 } Queue_elem;
 
@@ -117,6 +148,10 @@ typedef struct MessageQCopy_Transport  {
     Swi_Handle       swiHandle;
     VirtQueue_Handle virtQueue_toHost;
     VirtQueue_Handle virtQueue_fromHost;
+    UInt16           hostProcId;
+    UInt16           peerProcId;     /* Sibling M3 core, or INVALIDID       */
+    VirtQueue_Handle virtQueue_toPeer;
+    VirtQueue_Handle virtQueue_fromPeer;
 } MessageQCopy_Transport;
 
 
@@ -133,6 +168,50 @@ static UInt8 recv_buffers[MAXHEAPSIZE];
 /* Module ref count: */
 static Int curInit = 0;
 
+static Int MessageQCopy_queueCopy(UInt16 srcProc, UInt32 srcEndpt,
+                                  UInt32 dstEndpt, Ptr data, UInt16 len);
+
+/*
+ *  ======== MessageQCopy_latBucket ========
+ *
+ *  Latency histogram bucket b counts deltas in [4^b, 4^(b+1)) ticks.
+ */
+static inline UInt MessageQCopy_latBucket(UInt32 delta)
+{
+    UInt b = 0;
+
+    while ((delta >= 4) && (b < (MessageQCopy_NUMLATBUCKETS - 1))) {
+        delta >>= 2;
+        b++;
+    }
+    return (b);
+}
+
+/*
+ *  ======== MessageQCopy_deliver ========
+ *
+ *  Hand a message from a vring to its local endpoint: offer it to the
+ *  endpoint's receive hook, and queue a copy if the hook declines it.
+ */
+static Void MessageQCopy_deliver(MessageQCopy_Msg msg, UInt16 srcProc)
+{
+    MessageQCopy_Object   *obj = NULL;
+
+    /* No lock: MessageQCopy_delete cannot run while the Swi does */
+    if (msg->dstAddr < MAXMESSAGEQOBJECTS) {
+        obj = module.msgqObjects[msg->dstAddr];
+    }
+
+    if ((obj != NULL) && (obj->recvFxn != NULL) &&
+        (obj->recvFxn)(obj->recvArg, (Ptr)msg->payload, msg->dataLen,
+                       srcProc, msg->srcAddr)) {
+        return;
+    }
+
+    MessageQCopy_queueCopy(srcProc, msg->srcAddr, msg->dstAddr,
+                           (Ptr)msg->payload, msg->dataLen);
+}
+
 /*
  *  ======== MessageQCopy_swiFxn ========
  */
@@ -141,11 +220,20 @@ static Void MessageQCopy_swiFxn(UArg arg0, UArg arg1)
 {
     Int16             token;
     MessageQCopy_Msg  msg;
-    UInt16            dstProc = MultiProc_self();
     Bool              usedBufAdded = FALSE;
+    IArg              key;
 
     Log_print0(Diags_ENTRY, "--> "FXNN);
 
+    /* Account for the time this Swi waited after the host kicked us: */
+    key = GateSwi_enter(module.gateSwi);
+    if (module.kickPending) {
+        module.kickPending = FALSE;
+        module.swiLatHist[MessageQCopy_latBucket(Timestamp_get32() -
+                                                 module.kickTime)]++;
+    }
+    GateSwi_leave(module.gateSwi, key);
+
     /* Process all available buffers: */
     while ((token = VirtQueue_getAvailBuf(transport.virtQueue_fromHost,
                                          (Void **)&msg))
@@ -156,8 +244,7 @@ static Void MessageQCopy_swiFxn(UArg arg0, UArg arg1)
                   (IArg)msg->srcAddr, (IArg)msg->dstAddr, (IArg)msg->dataLen);
 
         /* Pass to desitination queue (which is on this proc): */
-        MessageQCopy_send(dstProc, msg->dstAddr, msg->srcAddr,
-                         (Ptr)msg->payload, msg->dataLen);
+        MessageQCopy_deliver(msg, transport.hostProcId);
 
         VirtQueue_addUsedBuf(transport.virtQueue_fromHost, token);
         usedBufAdded = TRUE;
@@ -167,6 +254,27 @@ static Void MessageQCopy_swiFxn(UArg arg0, UArg arg1)
        /* Tell host we've processed the buffers: */
        VirtQueue_kick(transport.virtQueue_fromHost);
     }
+
+    /* Process all buffers sent directly by the sibling core: */
+    if (transport.virtQueue_fromPeer) {
+        while ((token = VirtQueue_getAvailBuf(transport.virtQueue_fromPeer,
+                                              (Void **)&msg)) >= 0) {
+
+            Log_print3(Diags_INFO, FXNN": \n\tReceived peer msg: from: 0x%x, "
+                       "to: 0x%x, dataLen: %d",
+                       (IArg)msg->srcAddr, (IArg)msg->dstAddr,
+                       (IArg)msg->dataLen);
+
+            MessageQCopy_deliver(msg, transport.peerProcId);
+
+            /* No kick: the peer reclaims used buffers when it next sends */
+            VirtQueue_addUsedBuf(transport.virtQueue_fromPeer, token);
+        }
+    }
+
+    /* One kick for all replies sent by receive hooks: */
+    MessageQCopy_kickAll();
+
     Log_print0(Diags_EXIT, "<-- "FXNN);
 }
 #undef FXNN
@@ -176,9 +284,17 @@ static Void MessageQCopy_swiFxn(UArg arg0, UArg arg1)
 static Void callback_availBufReady(VirtQueue_Handle vq)
 {
 
-    if (vq == transport.virtQueue_fromHost)  {
+    if (vq == transport.virtQueue_fromPeer)  {
+        Log_print0(Diags_INFO, FXNN": virtQueue_fromPeer kicked");
+        Swi_post(transport.swiHandle);
+    }
+    else if (vq == transport.virtQueue_fromHost)  {
        /* Post a SWI to process all incoming messages */
         Log_print0(Diags_INFO, FXNN": virtQueue_fromHost kicked");
+        if (!module.kickPending) {
+            module.kickTime = Timestamp_get32();
+            module.kickPending = TRUE;
+        }
         Swi_post(transport.swiHandle);
     }
     else if (vq == transport.virtQueue_toHost) {
@@ -190,6 +306,84 @@ static Void callback_availBufReady(VirtQueue_Handle vq)
 }
 #undef FXNN
 
+/*
+ *  ======== MessageQCopy_enqueue ========
+ *
+ *  Put a payload on a local endpoint's queue, and signal both the endpoint
+ *  and the endpoint set it belongs to (if any).
+ */
+static Void MessageQCopy_enqueue(MessageQCopy_Object *obj, Queue_elem *payload)
+{
+    MessageQCopy_SetObject *set;
+    IArg                   key;
+
+    payload->ts = Timestamp_get32();
+    List_put(obj->queue, (List_Elem *)payload);
+    Semaphore_post(obj->semHandle);
+
+    key = GateSwi_enter(module.gateSwi);
+    set = obj->set;
+    if (set != NULL) {
+        Semaphore_post(set->semHandle);
+    }
+    GateSwi_leave(module.gateSwi, key);
+}
+
+/*
+ *  ======== MessageQCopy_queueCopy ========
+ *
+ *  Copy a message onto a local endpoint's queue, tagged with the processor
+ *  and endpoint it came from.
+ */
+#define FXNN "MessageQCopy_queueCopy"
+static Int MessageQCopy_queueCopy(UInt16 srcProc, UInt32 srcEndpt,
+                                  UInt32 dstEndpt, Ptr data, UInt16 len)
+{
+    Int                   status = MessageQCopy_S_SUCCESS;
+    MessageQCopy_Object   *obj = NULL;
+    Queue_elem            *payload;
+    UInt                  size;
+    IArg                  key;
+
+    /* Protect from MessageQCopy_delete */
+    key = GateSwi_enter(module.gateSwi);
+    if (dstEndpt < MAXMESSAGEQOBJECTS) {
+        obj = module.msgqObjects[dstEndpt];
+    }
+    GateSwi_leave(module.gateSwi, key);
+
+    if (obj == NULL) {
+        Log_print1(Diags_STATUS, FXNN": no object for endpoint: %d",
+                   (IArg)dstEndpt);
+        return (MessageQCopy_E_NOENDPT);
+    }
+
+    /* Allocate a buffer to copy the payload: */
+    size = len + sizeof(Queue_elem);
+
+    /* HeapBuf_alloc() is non-blocking, so needs protection: */
+    key = GateSwi_enter(module.gateSwi);
+    payload = (Queue_elem *)HeapBuf_alloc(module.heap, size, 0, NULL);
+    GateSwi_leave(module.gateSwi, key);
+
+    if (payload != NULL)  {
+        memcpy(payload->data, data, len);
+        payload->len = len;
+        payload->srcProc = srcProc;
+        payload->src = srcEndpt;
+
+        /* Put on the endpoint's queue and signal: */
+        MessageQCopy_enqueue(obj, payload);
+    }
+    else {
+        status = MessageQCopy_E_MEMORY;
+        Log_print0(Diags_STATUS, FXNN": HeapBuf_alloc failed!");
+    }
+
+    return (status);
+}
+#undef FXNN
+
 /* =============================================================================
  *  MessageQCopy Functions:
  * =============================================================================
@@ -207,6 +401,8 @@ Void MessageQCopy_init(UInt16 remoteProcId)
     HeapBuf_Params prms;
     int     i;
     Registry_Result result;
+    UInt16  sysm3ProcId;
+    UInt16  appm3ProcId;
 
     Log_print1(Diags_ENTRY, "--> "FXNN": (remoteProcId=%d)",
                 (IArg)remoteProcId);
@@ -227,6 +423,10 @@ Void MessageQCopy_init(UInt16 remoteProcId)
     for (i = 0; i < MAXMESSAGEQOBJECTS; i++) {
        module.msgqObjects[i] = NULL;
     }
+    module.kickPending = FALSE;
+    module.toHostPending = FALSE;
+    module.toPeerPending = FALSE;
+    memset(module.swiLatHist, 0, sizeof(module.swiLatHist));
 
     HeapBuf_Params_init(&prms);
     prms.blockSize    = MSGBUFFERSIZE;
@@ -249,6 +449,22 @@ Void MessageQCopy_init(UInt16 remoteProcId)
                                                     remoteProcId);
     transport.virtQueue_fromHost = VirtQueue_create(callback_availBufReady,
                                                     remoteProcId);
+    transport.hostProcId = remoteProcId;
+
+    /* The two Ducati cores also talk directly, bypassing the host: */
+    sysm3ProcId = MultiProc_getId("CORE0");
+    appm3ProcId = MultiProc_getId("CORE1");
+    transport.peerProcId = (MultiProc_self() == sysm3ProcId) ? appm3ProcId :
+                           (MultiProc_self() == appm3ProcId) ? sysm3ProcId :
+                           MultiProc_INVALIDID;
+    transport.virtQueue_toPeer = NULL;
+    transport.virtQueue_fromPeer = NULL;
+    if (transport.peerProcId != MultiProc_INVALIDID) {
+        transport.virtQueue_toPeer = VirtQueue_createPeer(
+                callback_availBufReady, transport.peerProcId, TRUE);
+        transport.virtQueue_fromPeer = VirtQueue_createPeer(
+                callback_availBufReady, transport.peerProcId, FALSE);
+    }
 
     /* construct the Swi to process incoming messages: */
     transport.swiHandle = Swi_create(MessageQCopy_swiFxn, NULL, NULL);
@@ -332,6 +548,16 @@ MessageQCopy_Handle MessageQCopy_create(UInt32 reserved, UInt32 * endpoint)
            /* See MessageQCopy_unblock() */
            obj->unblocked = FALSE;
 
+           /* See MessageQCopy_addToSet() */
+           obj->set = NULL;
+
+           /* See MessageQCopy_getLatency() */
+           memset(obj->latHist, 0, sizeof(obj->latHist));
+
+           /* See MessageQCopy_setRecvFxn() */
+           obj->recvFxn = NULL;
+           obj->recvArg = 0;
+
            *endpoint    = queueIndex;
            Log_print1(Diags_LIFECYCLE, FXNN": endPt created: %d",
                         (IArg)queueIndex);
@@ -362,6 +588,10 @@ Int MessageQCopy_delete(MessageQCopy_Handle *handlePtr)
 
     if (handlePtr && (obj = (MessageQCopy_Object *)(*handlePtr)))  {
 
+       if (obj->set != NULL) {
+           MessageQCopy_removeFromSet(obj->set, obj);
+       }
+
        Semaphore_delete(&(obj->semHandle));
 
        /* Free/discard all queued message buffers: */
@@ -393,9 +623,21 @@ Int MessageQCopy_delete(MessageQCopy_Handle *handlePtr)
 /*
  *  ======== MessageQCopy_recv ========
  */
-#define FXNN "MessageQCopy_recv"
 Int MessageQCopy_recv(MessageQCopy_Handle handle, Ptr data, UInt16 *len,
                       UInt32 *rplyEndpt, UInt timeout)
+{
+    UInt16              rplyProc;
+
+    return (MessageQCopy_recvFrom(handle, data, len, &rplyProc, rplyEndpt,
+                                  timeout));
+}
+
+/*
+ *  ======== MessageQCopy_recvFrom ========
+ */
+#define FXNN "MessageQCopy_recvFrom"
+Int MessageQCopy_recvFrom(MessageQCopy_Handle handle, Ptr data, UInt16 *len,
+                          UInt16 *rplyProc, UInt32 *rplyEndpt, UInt timeout)
 {
     Int                 status = MessageQCopy_S_SUCCESS;
     MessageQCopy_Object *obj = (MessageQCopy_Object *)handle;
@@ -425,14 +667,16 @@ Int MessageQCopy_recv(MessageQCopy_Handle handle, Ptr data, UInt16 *len,
        payload = (Queue_elem *)List_get(obj->queue);
 
        if (!payload) {
-           System_abort("MessageQCopy_recv: got a NULL payload\n");
+           System_abort("MessageQCopy_recvFrom: got a NULL payload\n");
        }
+       obj->latHist[MessageQCopy_latBucket(Timestamp_get32() - payload->ts)]++;
     }
 
     if (status == MessageQCopy_S_SUCCESS)  {
        /* Now, copy payload to client and free our internal msg */
        memcpy(data, payload->data, payload->len);
        *len = payload->len;
+       *rplyProc = payload->srcProc;
        *rplyEndpt = payload->src;
 
        HeapBuf_free(module.heap, (Ptr)payload,
@@ -445,21 +689,23 @@ Int MessageQCopy_recv(MessageQCopy_Handle handle, Ptr data, UInt16 *len,
 #undef FXNN
 
 /*
- *  ======== MessageQCopy_send ========
+ *  ======== MessageQCopy_put ========
+ *  Common body of MessageQCopy_send and MessageQCopy_sendNoKick. When kick
+ *  is FALSE, a buffer published on a vring is only marked pending; the
+ *  next MessageQCopy_kick (or kicking send) on that vring notifies the
+ *  other side of all of them at once.
  */
-#define FXNN "MessageQCopy_send"
-Int MessageQCopy_send(UInt16 dstProc,
-                      UInt32 dstEndpt,
-                      UInt32 srcEndpt,
-                      Ptr    data,
-                      UInt16 len)
+#define FXNN "MessageQCopy_put"
+static Int MessageQCopy_put(UInt16 dstProc,
+                            UInt32 dstEndpt,
+                            UInt32 srcEndpt,
+                            Ptr    data,
+                            UInt16 len,
+                            Bool   kick)
 {
     Int               status = MessageQCopy_S_SUCCESS;
-    MessageQCopy_Object   *obj;
     Int16             token = 0;
     MessageQCopy_Msg  msg;
-    Queue_elem        *payload;
-    UInt              size;
     IArg              key;
 
     Log_print5(Diags_ENTRY, "--> "FXNN": (dstProc=%d, dstEndpt=%d, "
@@ -468,7 +714,42 @@ Int MessageQCopy_send(UInt16 dstProc,
 
     Assert_isTrue((curInit > 0) , NULL);
 
-    if (dstProc != MultiProc_self()) {
+    if (len > MAXPAYLOADSIZE) {
+        Log_print1(Diags_STATUS, FXNN": message too large: %d", (IArg)len);
+        return MessageQCopy_E_FAIL;
+    }
+
+    if ((dstProc == transport.peerProcId) && transport.virtQueue_toPeer) {
+        /* Send directly to the sibling core: */
+        key = GateSwi_enter(module.gateSwi);  // Protect vring structs.
+        msg = VirtQueue_getPeerBuf(transport.virtQueue_toPeer);
+        GateSwi_leave(module.gateSwi, key);
+
+        if (msg != NULL) {
+            memcpy(msg->payload, data, len);
+            msg->dataLen = len;
+            msg->dstAddr = dstEndpt;
+            msg->srcAddr = srcEndpt;
+            msg->flags = 0;
+            msg->reserved = Timestamp_get32();
+
+            key = GateSwi_enter(module.gateSwi);  // Protect vring structs.
+            VirtQueue_addAvailBuf(transport.virtQueue_toPeer, msg);
+            if (kick) {
+                VirtQueue_kick(transport.virtQueue_toPeer);
+                module.toPeerPending = FALSE;
+            }
+            else {
+                module.toPeerPending = TRUE;
+            }
+            GateSwi_leave(module.gateSwi, key);
+        }
+        else {
+            status = MessageQCopy_E_FAIL;
+            Log_print0(Diags_STATUS, FXNN": peer vring full!");
+        }
+    }
+    else if (dstProc != MultiProc_self()) {
         /* Send to remote processor: */
         key = GateSwi_enter(module.gateSwi);  // Protect vring structs.
         token = VirtQueue_getAvailBuf(transport.virtQueue_toHost,
@@ -482,11 +763,18 @@ Int MessageQCopy_send(UInt16 dstProc,
             msg->dstAddr = dstEndpt;
             msg->srcAddr = srcEndpt;
             msg->flags = 0;
-            msg->reserved = 0;
+            /* Send time, for latency tracing; ignored by the host: */
+            msg->reserved = Timestamp_get32();
 
             key = GateSwi_enter(module.gateSwi);  // Protect vring structs.
             VirtQueue_addUsedBuf(transport.virtQueue_toHost, token);
-            VirtQueue_kick(transport.virtQueue_toHost);
+            if (kick) {
+                VirtQueue_kick(transport.virtQueue_toHost);
+                module.toHostPending = FALSE;
+            }
+            else {
+                module.toHostPending = TRUE;
+            }
             GateSwi_leave(module.gateSwi, key);
         }
         else {
@@ -496,40 +784,274 @@ Int MessageQCopy_send(UInt16 dstProc,
     }
     else {
         /* Put on a Message queue on this processor: */
+        status = MessageQCopy_queueCopy(MultiProc_self(), srcEndpt, dstEndpt,
+                                        data, len);
+    }
 
-        /* Protect from MessageQCopy_delete */
-        key = GateSwi_enter(module.gateSwi);
-        obj = module.msgqObjects[dstEndpt];
-        GateSwi_leave(module.gateSwi, key);
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return (status);
+}
+#undef FXNN
 
-        if (obj == NULL) {
-            Log_print1(Diags_STATUS, FXNN": no object for endpoint: %d",
-                   (IArg)dstEndpt);
-            status = MessageQCopy_E_NOENDPT;
-            return status;
+/*
+ *  ======== MessageQCopy_send ========
+ */
+#define FXNN "MessageQCopy_send"
+Int MessageQCopy_send(UInt16 dstProc,
+                      UInt32 dstEndpt,
+                      UInt32 srcEndpt,
+                      Ptr    data,
+                      UInt16 len)
+{
+    return (MessageQCopy_put(dstProc, dstEndpt, srcEndpt, data, len, TRUE));
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_sendNoKick ========
+ */
+#define FXNN "MessageQCopy_sendNoKick"
+Int MessageQCopy_sendNoKick(UInt16 dstProc,
+                            UInt32 dstEndpt,
+                            UInt32 srcEndpt,
+                            Ptr    data,
+                            UInt16 len)
+{
+    return (MessageQCopy_put(dstProc, dstEndpt, srcEndpt, data, len, FALSE));
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_kick ========
+ */
+#define FXNN "MessageQCopy_kick"
+Void MessageQCopy_kick(UInt16 dstProc)
+{
+    IArg              key;
+
+    Log_print1(Diags_ENTRY, "--> "FXNN": (dstProc=%d)", (IArg)dstProc);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    key = GateSwi_enter(module.gateSwi);  // Protect vring structs.
+
+    if ((dstProc == transport.peerProcId) && transport.virtQueue_toPeer) {
+        if (module.toPeerPending) {
+            VirtQueue_kick(transport.virtQueue_toPeer);
+            module.toPeerPending = FALSE;
         }
+    }
+    else if (dstProc != MultiProc_self()) {
+        if (module.toHostPending) {
+            VirtQueue_kick(transport.virtQueue_toHost);
+            module.toHostPending = FALSE;
+        }
+    }
+
+    GateSwi_leave(module.gateSwi, key);
+
+    Log_print0(Diags_EXIT, "<-- "FXNN);
+}
+#undef FXNN
 
-        /* Allocate a buffer to copy the payload: */
-        size = len + sizeof(Queue_elem);
+/*
+ *  ======== MessageQCopy_kickAll ========
+ */
+#define FXNN "MessageQCopy_kickAll"
+Void MessageQCopy_kickAll()
+{
+    IArg              key;
+
+    Log_print0(Diags_ENTRY, "--> "FXNN);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    key = GateSwi_enter(module.gateSwi);  // Protect vring structs.
+
+    if (module.toHostPending) {
+        VirtQueue_kick(transport.virtQueue_toHost);
+        module.toHostPending = FALSE;
+    }
+    if (module.toPeerPending) {
+        VirtQueue_kick(transport.virtQueue_toPeer);
+        module.toPeerPending = FALSE;
+    }
+
+    GateSwi_leave(module.gateSwi, key);
 
+    Log_print0(Diags_EXIT, "<-- "FXNN);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_alloc ========
+ */
+#define FXNN "MessageQCopy_alloc"
+Ptr MessageQCopy_alloc(UInt16 len)
+{
+    Queue_elem        *payload = NULL;
+    IArg              key;
+
+    Log_print1(Diags_ENTRY, "--> "FXNN": (len=%d)", (IArg)len);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    if (len <= MAXPAYLOADSIZE) {
         /* HeapBuf_alloc() is non-blocking, so needs protection: */
         key = GateSwi_enter(module.gateSwi);
-        payload = (Queue_elem *)HeapBuf_alloc(module.heap, size, 0, NULL);
+        payload = (Queue_elem *)HeapBuf_alloc(module.heap, MSGBUFFERSIZE, 0,
+                                              NULL);
         GateSwi_leave(module.gateSwi, key);
+    }
 
-        if (payload != NULL)  {
-            memcpy(payload->data, data, len);
-            payload->len = len;
-            payload->src = srcEndpt;
+    if (payload == NULL) {
+        Log_print1(Diags_STATUS, FXNN": no buffer for len: %d", (IArg)len);
+        Log_print0(Diags_EXIT, "<-- "FXNN": 0x0");
+        return (NULL);
+    }
 
-            /* Put on the endpoint's queue and signal: */
-            List_put(obj->queue, (List_Elem *)payload);
-            Semaphore_post(obj->semHandle);
-        }
-        else {
-            status = MessageQCopy_E_MEMORY;
-            Log_print0(Diags_STATUS, FXNN": HeapBuf_alloc failed!");
+    payload->len = len;
+
+    Log_print1(Diags_EXIT, "<-- "FXNN": 0x%x", (IArg)payload->data);
+    return ((Ptr)payload->data);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_free ========
+ */
+#define FXNN "MessageQCopy_free"
+Void MessageQCopy_free(Ptr data)
+{
+    Queue_elem        *payload;
+    IArg              key;
+
+    Log_print1(Diags_ENTRY, "--> "FXNN": (data=0x%x)", (IArg)data);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    if (data != NULL) {
+        payload = (Queue_elem *)((Char *)data - sizeof(Queue_elem));
+
+        key = GateSwi_enter(module.gateSwi);
+        HeapBuf_free(module.heap, (Ptr)payload, MSGBUFFERSIZE);
+        GateSwi_leave(module.gateSwi, key);
+    }
+
+    Log_print0(Diags_EXIT, "<-- "FXNN);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_sendNoCopy ========
+ */
+#define FXNN "MessageQCopy_sendNoCopy"
+Int MessageQCopy_sendNoCopy(UInt16 dstProc,
+                            UInt32 dstEndpt,
+                            UInt32 srcEndpt,
+                            Ptr    data,
+                            UInt16 len)
+{
+    Int               status = MessageQCopy_S_SUCCESS;
+    MessageQCopy_Object   *obj = NULL;
+    Queue_elem        *payload;
+    IArg              key;
+
+    Log_print5(Diags_ENTRY, "--> "FXNN": (dstProc=%d, dstEndpt=%d, "
+               "srcEndpt=%d, data=0x%x, len=%d", (IArg)dstProc, (IArg)dstEndpt,
+               (IArg)srcEndpt, (IArg)data, (IArg)len);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    if (len > MAXPAYLOADSIZE) {
+        status = MessageQCopy_E_FAIL;
+        Log_print1(Diags_STATUS, FXNN": len too large: %d", (IArg)len);
+        goto leave;
+    }
+
+    if (dstProc != MultiProc_self()) {
+        /* The vring buffers are owned by the host, so copy into one of
+         * them and release the donated buffer on success.
+         */
+        status = MessageQCopy_send(dstProc, dstEndpt, srcEndpt, data, len);
+
+        if (status == MessageQCopy_S_SUCCESS) {
+            MessageQCopy_free(data);
         }
+        goto leave;
+    }
+
+    /* Protect from MessageQCopy_delete */
+    key = GateSwi_enter(module.gateSwi);
+    if (dstEndpt < MAXMESSAGEQOBJECTS) {
+        obj = module.msgqObjects[dstEndpt];
+    }
+    GateSwi_leave(module.gateSwi, key);
+
+    if (obj == NULL) {
+        Log_print1(Diags_STATUS, FXNN": no object for endpoint: %d",
+                   (IArg)dstEndpt);
+        status = MessageQCopy_E_NOENDPT;
+        goto leave;
+    }
+
+    /* Hand the buffer itself over to the endpoint's queue and signal: */
+    payload = (Queue_elem *)((Char *)data - sizeof(Queue_elem));
+    payload->len = len;
+    payload->srcProc = MultiProc_self();
+    payload->src = srcEndpt;
+
+    MessageQCopy_enqueue(obj, payload);
+
+leave:
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return (status);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_recvNoCopy ========
+ */
+#define FXNN "MessageQCopy_recvNoCopy"
+Int MessageQCopy_recvNoCopy(MessageQCopy_Handle handle, Ptr *data,
+                            UInt16 *len, UInt32 *rplyEndpt, UInt timeout)
+{
+    Int                 status = MessageQCopy_S_SUCCESS;
+    MessageQCopy_Object *obj = (MessageQCopy_Object *)handle;
+    Bool                semStatus;
+    Queue_elem          *payload;
+
+    Log_print5(Diags_ENTRY, "--> "FXNN": (handle=0x%x, data=0x%x, len=0x%x,"
+               "rplyEndpt=0x%x, timeout=%d)", (IArg)handle, (IArg)data,
+               (IArg)len, (IArg)rplyEndpt, (IArg)timeout);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    /* Check vring for pending messages before we block: */
+    Swi_post(transport.swiHandle);
+
+    /*  Block until notified. */
+    semStatus = Semaphore_pend(obj->semHandle, timeout);
+
+    if (semStatus == FALSE)  {
+       status = MessageQCopy_E_TIMEOUT;
+       Log_print0(Diags_STATUS, FXNN": Sem pend timeout!");
+    }
+    else if (obj->unblocked) {
+       status = MessageQCopy_E_UNBLOCKED;
+    }
+    else  {
+       payload = (Queue_elem *)List_get(obj->queue);
+
+       if (!payload) {
+           System_abort("MessageQCopy_recvNoCopy: got a NULL payload\n");
+       }
+       obj->latHist[MessageQCopy_latBucket(Timestamp_get32() - payload->ts)]++;
+
+       /* Caller now owns the buffer; released by MessageQCopy_free(): */
+       *data = (Ptr)payload->data;
+       *len = payload->len;
+       *rplyEndpt = payload->src;
     }
 
     Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
@@ -553,3 +1075,298 @@ Void MessageQCopy_unblock(MessageQCopy_Handle handle)
     Log_print0(Diags_EXIT, "<-- "FXNN);
 }
 #undef FXNN
+
+/*
+ *  ======== MessageQCopy_createSet ========
+ */
+#define FXNN "MessageQCopy_createSet"
+MessageQCopy_SetHandle MessageQCopy_createSet()
+{
+    MessageQCopy_SetObject *set;
+
+    Log_print0(Diags_ENTRY, "--> "FXNN);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    set = Memory_alloc(NULL, sizeof(MessageQCopy_SetObject), 0, NULL);
+    if (set != NULL) {
+        set->semHandle = Semaphore_create(0, NULL, NULL);
+        set->numMembers = 0;
+        set->next = 0;
+        set->unblocked = FALSE;
+        Log_print1(Diags_LIFECYCLE, FXNN": set created: 0x%x", (IArg)set);
+    }
+
+    Log_print1(Diags_EXIT, "<-- "FXNN": 0x%x", (IArg)set);
+    return (set);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_deleteSet ========
+ */
+#define FXNN "MessageQCopy_deleteSet"
+Int MessageQCopy_deleteSet(MessageQCopy_SetHandle *setPtr)
+{
+    Int                    status = MessageQCopy_S_SUCCESS;
+    MessageQCopy_SetObject *set;
+
+    Log_print1(Diags_ENTRY, "--> "FXNN": (setPtr=0x%x)", (IArg)setPtr);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    if (setPtr && (set = (MessageQCopy_SetObject *)(*setPtr)))  {
+
+        /* Detach any remaining members: */
+        while (set->numMembers > 0) {
+            MessageQCopy_removeFromSet(set, set->members[0]);
+        }
+
+        Semaphore_delete(&(set->semHandle));
+
+        Log_print1(Diags_LIFECYCLE, FXNN": set deleted: 0x%x", (IArg)set);
+
+        Memory_free(NULL, set, sizeof(MessageQCopy_SetObject));
+        *setPtr = NULL;
+    }
+
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return (status);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_addToSet ========
+ */
+#define FXNN "MessageQCopy_addToSet"
+Int MessageQCopy_addToSet(MessageQCopy_SetHandle setHandle,
+                          MessageQCopy_Handle handle)
+{
+    Int                    status = MessageQCopy_S_SUCCESS;
+    MessageQCopy_SetObject *set = (MessageQCopy_SetObject *)setHandle;
+    MessageQCopy_Object    *obj = (MessageQCopy_Object *)handle;
+    List_Elem              *elem;
+    IArg                   key;
+
+    Log_print2(Diags_ENTRY, "--> "FXNN": (set=0x%x, handle=0x%x)",
+               (IArg)setHandle, (IArg)handle);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    key = GateSwi_enter(module.gateSwi);
+
+    if (obj->set != NULL) {
+        status = MessageQCopy_E_FAIL;
+        Log_print1(Diags_STATUS, FXNN": endPt %d already in a set",
+                   (IArg)obj->queueId);
+    }
+    else if (set->numMembers == MAXSETMEMBERS) {
+        status = MessageQCopy_E_MEMORY;
+        Log_print0(Diags_STATUS, FXNN": set is full");
+    }
+    else {
+        set->members[set->numMembers++] = obj;
+        obj->set = set;
+
+        /* Account for messages already waiting on the endpoint: */
+        elem = NULL;
+        while ((elem = List_next(obj->queue, elem)) != NULL) {
+            Semaphore_post(set->semHandle);
+        }
+    }
+
+    GateSwi_leave(module.gateSwi, key);
+
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return (status);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_removeFromSet ========
+ */
+#define FXNN "MessageQCopy_removeFromSet"
+Int MessageQCopy_removeFromSet(MessageQCopy_SetHandle setHandle,
+                               MessageQCopy_Handle handle)
+{
+    Int                    status = MessageQCopy_E_FAIL;
+    MessageQCopy_SetObject *set = (MessageQCopy_SetObject *)setHandle;
+    MessageQCopy_Object    *obj = (MessageQCopy_Object *)handle;
+    List_Elem              *elem;
+    UInt                   i;
+    IArg                   key;
+
+    Log_print2(Diags_ENTRY, "--> "FXNN": (set=0x%x, handle=0x%x)",
+               (IArg)setHandle, (IArg)handle);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    key = GateSwi_enter(module.gateSwi);
+
+    for (i = 0; i < set->numMembers; i++) {
+        if (set->members[i] == obj) {
+            /* Keep the member array packed: */
+            set->members[i] = set->members[--set->numMembers];
+            obj->set = NULL;
+
+            /* Drop the counts the endpoint's pending messages hold: */
+            elem = NULL;
+            while ((elem = List_next(obj->queue, elem)) != NULL) {
+                Semaphore_pend(set->semHandle, 0);
+            }
+
+            status = MessageQCopy_S_SUCCESS;
+            break;
+        }
+    }
+
+    GateSwi_leave(module.gateSwi, key);
+
+    Log_print1(Diags_EXIT, "<-- "FXNN": %d", (IArg)status);
+    return (status);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_waitAny ========
+ */
+#define FXNN "MessageQCopy_waitAny"
+Int MessageQCopy_waitAny(MessageQCopy_SetHandle setHandle,
+                         MessageQCopy_Handle *handle, UInt timeout)
+{
+    Int                    status = MessageQCopy_S_SUCCESS;
+    MessageQCopy_SetObject *set = (MessageQCopy_SetObject *)setHandle;
+    MessageQCopy_Object    *obj = NULL;
+    Bool                   semStatus;
+    UInt                   i;
+    UInt                   idx;
+    UInt                   start;
+    UInt                   elapsed;
+    UInt                   remaining = timeout;
+    IArg                   key;
+
+    Log_print3(Diags_ENTRY, "--> "FXNN": (set=0x%x, handle=0x%x, timeout=%d)",
+               (IArg)setHandle, (IArg)handle, (IArg)timeout);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    /* Check vring for pending messages before we block: */
+    Swi_post(transport.swiHandle);
+
+    start = Clock_getTicks();
+
+    /*  Block until any member is notified. */
+    while (obj == NULL) {
+        semStatus = Semaphore_pend(set->semHandle, remaining);
+
+        if (semStatus == FALSE)  {
+            status = MessageQCopy_E_TIMEOUT;
+            Log_print0(Diags_STATUS, FXNN": Sem pend timeout!");
+            break;
+        }
+        else if (set->unblocked) {
+            status = MessageQCopy_E_UNBLOCKED;
+            break;
+        }
+
+        /* Pick the next non-empty member, round robin for fairness: */
+        key = GateSwi_enter(module.gateSwi);
+        for (i = 0; i < set->numMembers; i++) {
+            idx = (set->next + i) % set->numMembers;
+            if (!List_empty(set->members[idx]->queue)) {
+                obj = set->members[idx];
+                set->next = idx + 1;
+                break;
+            }
+        }
+        GateSwi_leave(module.gateSwi, key);
+
+        /*
+         * A count left by a message that was received from the member
+         * directly: wait again, for whatever is left of the timeout.
+         */
+        if ((obj == NULL) && (timeout != MessageQCopy_FOREVER)) {
+            elapsed = Clock_getTicks() - start;
+            remaining = (elapsed >= timeout) ? 0 : (timeout - elapsed);
+        }
+    }
+
+    *handle = (MessageQCopy_Handle)obj;
+
+    Log_print2(Diags_EXIT, "<-- "FXNN": %d, handle: 0x%x", (IArg)status,
+               (IArg)obj);
+    return (status);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_unblockSet ========
+ */
+#define FXNN "MessageQCopy_unblockSet"
+Void MessageQCopy_unblockSet(MessageQCopy_SetHandle setHandle)
+{
+    MessageQCopy_SetObject *set = (MessageQCopy_SetObject *)setHandle;
+
+    Log_print1(Diags_ENTRY, "--> "FXNN": (set=0x%x)", (IArg)setHandle);
+
+    /* Set instance to 'unblocked' state, and post */
+    set->unblocked = TRUE;
+    Semaphore_post(set->semHandle);
+    Log_print0(Diags_EXIT, "<-- "FXNN);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_getLatency ========
+ */
+#define FXNN "MessageQCopy_getLatency"
+Void MessageQCopy_getLatency(MessageQCopy_Handle handle, UInt32 *hist,
+                             Bool reset)
+{
+    MessageQCopy_Object *obj = (MessageQCopy_Object *)handle;
+    UInt32              *src;
+    IArg                key;
+
+    Log_print2(Diags_ENTRY, "--> "FXNN": (handle=0x%x, hist=0x%x)",
+               (IArg)handle, (IArg)hist);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    /* NULL handle selects the transport (kick to Swi) histogram: */
+    src = (obj != NULL) ? obj->latHist : module.swiLatHist;
+
+    key = GateSwi_enter(module.gateSwi);
+    memcpy(hist, src, MessageQCopy_NUMLATBUCKETS * sizeof(UInt32));
+    if (reset) {
+        memset(src, 0, MessageQCopy_NUMLATBUCKETS * sizeof(UInt32));
+    }
+    GateSwi_leave(module.gateSwi, key);
+
+    Log_print0(Diags_EXIT, "<-- "FXNN);
+}
+#undef FXNN
+
+/*
+ *  ======== MessageQCopy_setRecvFxn ========
+ */
+#define FXNN "MessageQCopy_setRecvFxn"
+Void MessageQCopy_setRecvFxn(MessageQCopy_Handle handle,
+                             MessageQCopy_RecvFxn fxn, UArg arg)
+{
+    MessageQCopy_Object *obj = (MessageQCopy_Object *)handle;
+    IArg                 key;
+
+    Log_print3(Diags_ENTRY, "--> "FXNN": (handle=0x%x, fxn=0x%x, arg=0x%x)",
+               (IArg)handle, (IArg)fxn, (IArg)arg);
+
+    Assert_isTrue((curInit > 0) , NULL);
+
+    /* Keep the receive Swi from seeing a half updated hook: */
+    key = GateSwi_enter(module.gateSwi);
+    obj->recvFxn = fxn;
+    obj->recvArg = arg;
+    GateSwi_leave(module.gateSwi, key);
+
+    Log_print0(Diags_EXIT, "<-- "FXNN);
+}
+#undef FXNN
@@ -39,9 +39,16 @@
  *  - Timeouts are allowed when receiving messages.
  *  - Supports processor copy transfers only.
  *  - Sending/receiving also works between enpoints on the same processor.
+ *  - Messages between the two Ducati cores (CORE0 and CORE1) travel over
+ *    a dedicated vring pair in shared memory, not via the host.
+ *  - A single reader may wait on several endpoints at once, by grouping
+ *    them in an endpoint set and calling MessageQCopy_waitAny().
+ *  - Ownership transfer (no copy) of MessageQCopy_alloc()'d buffers between
+ *    endpoints on the same processor, via MessageQCopy_sendNoCopy() and
+ *    MessageQCopy_recvNoCopy().
  *
  *  Non-Features (as compared to MessageQ):
- *  - zero copy messaging, using registered heaps.
+ *  - zero copy messaging to remote processors, using registered heaps.
  *  - Dependence on a NameServer (Client furnishes the endpoint IDs)
  *  - Arbitrary reply endpoints can be embedded in message header.
  *  - Priority Queues.
@@ -136,11 +143,42 @@ extern "C" {
  *  @brief  Maximum Value for System Reserved Endpoints.
  */
 #define MessageQCopy_ASSIGN_ANY             0xFFFFFFFF
+/*!
+ *  @def    MessageQCopy_NUMLATBUCKETS
+ *  @brief  Number of buckets in a latency histogram.
+ *
+ *  Bucket b counts latencies in [4^b, 4^(b+1)) Timestamp ticks; bucket 0
+ *  also counts latencies of 0 ticks.  See Timestamp_getFreq().
+ */
+#define MessageQCopy_NUMLATBUCKETS          16
+
+/*!
+ *  @def    MessageQCopy_MAXPAYLOADSIZE
+ *  @brief  Largest message, in bytes, that can be sent or received.
+ *
+ *  This is the 512 byte rpmsg vring buffer less its 16 byte header.
+ */
+#define MessageQCopy_MAXPAYLOADSIZE         496
+
 /*!
  *  @brief  MessageQCopy_Handle type
  */
 typedef struct MessageQCopy_Object *MessageQCopy_Handle;
 
+/*!
+ *  @brief  MessageQCopy endpoint set handle type
+ */
+typedef struct MessageQCopy_SetObject *MessageQCopy_SetHandle;
+
+/*!
+ *  @brief  Receive hook, see MessageQCopy_setRecvFxn
+ *
+ *  Returns TRUE if it consumed the message, FALSE to have it queued on the
+ *  endpoint as usual.
+ */
+typedef Bool (*MessageQCopy_RecvFxn)(UArg arg, Ptr data, UInt16 len,
+                                     UInt16 srcProc, UInt32 srcEndpt);
+
 /* =============================================================================
  *  MessageQCopy Functions:
  * =============================================================================
@@ -218,6 +256,27 @@ MessageQCopy_Handle MessageQCopy_create(UInt32 reserved, UInt32 * endpoint);
 Int MessageQCopy_recv(MessageQCopy_Handle handle, Ptr data, UInt16 *len,
                       UInt32 *rplyEndpt, UInt timeout);
 
+/*!
+ *  @brief      Receives a message, and the processor it came from.
+ *
+ *  Same as MessageQCopy_recv, and also returns the ProcId of the sender,
+ *  so that a service used by more than one processor can reply to each.
+ *
+ *  @param[in]  handle      MessageQ handle
+ *  @param[out] data        Pointer to the client's data buffer.
+ *  @param[out] len         Amount of data received.
+ *  @param[out] rplyProc    ProcId of source (for replies).
+ *  @param[out] rplyEndpt   Endpoint of source (for replies).
+ *  @param[in]  timeout     Maximum duration to wait for a message in
+ *                          microseconds.
+ *
+ *  @return     MessageQ status, as for MessageQCopy_recv.
+ *
+ *  @sa         MessageQCopy_recv
+ */
+Int MessageQCopy_recvFrom(MessageQCopy_Handle handle, Ptr data, UInt16 *len,
+                          UInt16 *rplyProc, UInt32 *rplyEndpt, UInt timeout);
+
 /*!
  *  @brief      Sends data to a remote processor, or copies onto a local
  *              messageQ.
@@ -242,6 +301,130 @@ Int MessageQCopy_send(UInt16 dstProc,
                       Ptr    data,
                       UInt16 len);
 
+/*!
+ *  @brief      Like MessageQCopy_send, but does not interrupt the remote
+ *              processor.
+ *
+ *  A message sent to another processor is placed on its vring, but the
+ *  mailbox kick is deferred until the next MessageQCopy_kick, or the next
+ *  MessageQCopy_send on the same vring. This lets a sender publish several
+ *  messages and raise a single interrupt for all of them. Local sends are
+ *  delivered immediately, exactly as with MessageQCopy_send.
+ *
+ *  @param[in]  dstProc     Destination ProcId.
+ *  @param[in]  dstEndpt    Destination Endpoint.
+ *  @param[in]  srcEndpt    Source Endpoint.
+ *  @param[in]  data        Data payload to be copied and sent.
+ *  @param[in]  len         Amount of data to be copied, including Msg header.
+ *
+ *  @return     Status of the call.
+ *              - #MessageQCopy_S_SUCCESS denotes success.
+ *              - #MessageQCopy_E_FAIL denotes failure.
+ *                The send was not successful.
+ *
+ *  @sa         MessageQCopy_kick
+ */
+Int MessageQCopy_sendNoKick(UInt16 dstProc,
+                            UInt32 dstEndpt,
+                            UInt32 srcEndpt,
+                            Ptr    data,
+                            UInt16 len);
+
+/*!
+ *  @brief      Notify a remote processor of messages left pending by
+ *              MessageQCopy_sendNoKick.
+ *
+ *  Does nothing if no message is pending on the vring to dstProc, or if
+ *  dstProc is the local processor.
+ *
+ *  @param[in]  dstProc     Destination ProcId.
+ *
+ *  @sa         MessageQCopy_sendNoKick
+ */
+Void MessageQCopy_kick(UInt16 dstProc);
+
+/*!
+ *  @brief      Notify every remote processor with messages left pending by
+ *              MessageQCopy_sendNoKick.
+ *
+ *  @sa         MessageQCopy_kick
+ */
+Void MessageQCopy_kickAll();
+
+/*!
+ *  @brief      Allocate a message buffer for use with MessageQCopy_sendNoCopy.
+ *
+ *  The buffer comes from the module's internal message heap, so it can be
+ *  queued on a local endpoint without copying.
+ *
+ *  @param[in]  len         Size of the payload, in bytes.
+ *
+ *  @return     Pointer to the payload area, or NULL if len is too large or
+ *              no buffer is available.
+ *
+ *  @sa         MessageQCopy_free MessageQCopy_sendNoCopy
+ */
+Ptr MessageQCopy_alloc(UInt16 len);
+
+/*!
+ *  @brief      Release a buffer from MessageQCopy_alloc or
+ *              MessageQCopy_recvNoCopy.
+ *
+ *  @param[in]  data        Payload pointer to release.
+ */
+Void MessageQCopy_free(Ptr data);
+
+/*!
+ *  @brief      Sends a MessageQCopy_alloc()'d buffer, transferring ownership.
+ *
+ *  If dstProc is the local processor, the buffer itself is placed on the
+ *  destination queue; no copy is made.  Otherwise, the payload is copied
+ *  into a vring buffer as with MessageQCopy_send, and the buffer is freed.
+ *
+ *  On success the caller must no longer touch data.  On failure the caller
+ *  still owns data, and may retry or release it with MessageQCopy_free.
+ *
+ *  @param[in]  dstProc     Destination ProcId.
+ *  @param[in]  dstEndpt    Destination Endpoint.
+ *  @param[in]  srcEndpt    Source Endpoint.
+ *  @param[in]  data        Buffer returned from MessageQCopy_alloc.
+ *  @param[in]  len         Amount of valid data in the buffer.
+ *
+ *  @return     Status of the call.
+ *              - #MessageQCopy_S_SUCCESS denotes success.
+ *              - #MessageQCopy_E_NOENDPT no local endpoint dstEndpt.
+ *              - #MessageQCopy_E_FAIL denotes failure.
+ *
+ *  @sa         MessageQCopy_alloc MessageQCopy_recvNoCopy
+ */
+Int MessageQCopy_sendNoCopy(UInt16 dstProc,
+                            UInt32 dstEndpt,
+                            UInt32 srcEndpt,
+                            Ptr    data,
+                            UInt16 len);
+
+/*!
+ *  @brief      Receives a message without copying it out of the queue.
+ *
+ *  Same as MessageQCopy_recv, except that on success *data points at the
+ *  queued message buffer itself.  The caller owns that buffer and must
+ *  release it with MessageQCopy_free, or pass it on with
+ *  MessageQCopy_sendNoCopy.
+ *
+ *  @param[in]  handle      MessageQ handle
+ *  @param[out] data        Set to the received payload.
+ *  @param[out] len         Amount of data received.
+ *  @param[out] rplyEndpt   Endpoint of source (for replies).
+ *  @param[in]  timeout     Maximum duration to wait for a message in
+ *                          microseconds.
+ *
+ *  @return     MessageQ status, as for MessageQCopy_recv.
+ *
+ *  @sa         MessageQCopy_free MessageQCopy_recv
+ */
+Int MessageQCopy_recvNoCopy(MessageQCopy_Handle handle, Ptr *data,
+                            UInt16 *len, UInt32 *rplyEndpt, UInt timeout);
+
 /*!
  *  @brief      Delete a created MessageQ instance.
  *
@@ -275,6 +458,133 @@ Int MessageQCopy_delete(MessageQCopy_Handle *handlePtr);
  */
 Void MessageQCopy_unblock(MessageQCopy_Handle handle);
 
+/*!
+ *  @brief      Create an endpoint set.
+ *
+ *  An endpoint set lets one reader thread block on several local endpoints
+ *  at once (see MessageQCopy_waitAny), instead of dedicating a thread to
+ *  each endpoint.
+ *
+ *  @return     Set handle, or NULL if the object could not be allocated.
+ */
+MessageQCopy_SetHandle MessageQCopy_createSet();
+
+/*!
+ *  @brief      Delete an endpoint set.
+ *
+ *  Any endpoints still in the set are removed from it first; the endpoints
+ *  themselves are not deleted.
+ *
+ *  @param[in,out]  setPtr  Pointer to set handle to delete.
+ *
+ *  @return     #MessageQCopy_S_SUCCESS, *setPtr = NULL.
+ */
+Int MessageQCopy_deleteSet(MessageQCopy_SetHandle *setPtr);
+
+/*!
+ *  @brief      Add an endpoint to an endpoint set.
+ *
+ *  An endpoint may belong to at most one set.  Messages already queued on
+ *  the endpoint become visible to MessageQCopy_waitAny.
+ *
+ *  @param[in]  set         Set handle.
+ *  @param[in]  handle      MessageQCopy handle to add.
+ *
+ *  @return     Status of the call.
+ *              - #MessageQCopy_S_SUCCESS denotes success.
+ *              - #MessageQCopy_E_MEMORY the set is full.
+ *              - #MessageQCopy_E_FAIL endpoint already belongs to a set.
+ */
+Int MessageQCopy_addToSet(MessageQCopy_SetHandle set,
+                          MessageQCopy_Handle handle);
+
+/*!
+ *  @brief      Remove an endpoint from an endpoint set.
+ *
+ *  MessageQCopy_delete does this implicitly.
+ *
+ *  @param[in]  set         Set handle.
+ *  @param[in]  handle      MessageQCopy handle to remove.
+ *
+ *  @return     Status of the call.
+ *              - #MessageQCopy_S_SUCCESS denotes success.
+ *              - #MessageQCopy_E_FAIL endpoint is not in the set.
+ */
+Int MessageQCopy_removeFromSet(MessageQCopy_SetHandle set,
+                               MessageQCopy_Handle handle);
+
+/*!
+ *  @brief      Wait until any endpoint in a set has a message.
+ *
+ *  On success, *handle is set to an endpoint with a pending message.  The
+ *  caller must then consume exactly one message from it, with
+ *  MessageQCopy_recv or MessageQCopy_recvNoCopy (a timeout of 0 suffices).
+ *  Endpoints with pending messages are selected round robin.
+ *
+ *  Only drain a member after MessageQCopy_waitAny has returned it. A
+ *  message received from a member directly still counts toward the set,
+ *  so a later call wakes up for it, finds nothing, and has to wait again.
+ *
+ *  @param[in]  set         Set handle.
+ *  @param[out] handle      Endpoint that has a message; NULL on error.
+ *  @param[in]  timeout     Maximum duration to wait for a message in
+ *                          microseconds.
+ *
+ *  @return     MessageQ status:
+ *              - #MessageQCopy_S_SUCCESS: *handle has a message
+ *              - #MessageQCopy_E_TIMEOUT: MessageQCopy_waitAny timed out
+ *              - #MessageQCopy_E_UNBLOCKED: MessageQCopy_unblockSet called
+ *
+ *  @sa         MessageQCopy_recv MessageQCopy_unblockSet
+ */
+Int MessageQCopy_waitAny(MessageQCopy_SetHandle set,
+                         MessageQCopy_Handle *handle, UInt timeout);
+
+/*!
+ *  @brief      Unblocks a reader blocked in MessageQCopy_waitAny.
+ *
+ *  As with MessageQCopy_unblock, the set may not be waited on afterwards.
+ *
+ *  @param[in]  set         Set handle.
+ */
+Void MessageQCopy_unblockSet(MessageQCopy_SetHandle set);
+
+/*!
+ *  @brief      Read (and optionally clear) a latency histogram.
+ *
+ *  For an endpoint, the histogram records how long each message sat on the
+ *  endpoint's queue before being received.  With a NULL handle, the
+ *  histogram records how long the receive Swi ran after the host kicked the
+ *  fromHost vring.
+ *
+ *  Messages sent to a remote processor carry their send time (in
+ *  Timestamp ticks) in the otherwise unused reserved header word.
+ *
+ *  @param[in]  handle      MessageQCopy handle, or NULL for the transport.
+ *  @param[out] hist        Array of #MessageQCopy_NUMLATBUCKETS counts.
+ *  @param[in]  reset       Clear the histogram after reading it.
+ */
+Void MessageQCopy_getLatency(MessageQCopy_Handle handle, UInt32 *hist,
+                             Bool reset);
+
+/*!
+ *  @brief      Install a hook which sees messages before they are queued.
+ *
+ *  Messages arriving from the host or the sibling core for this endpoint
+ *  are first offered to fxn, which runs in the receive Swi with data
+ *  pointing into the vring buffer. If fxn returns TRUE the message is
+ *  dropped, otherwise it is copied onto the endpoint's queue as usual.
+ *  fxn may modify the buffer in place and reply with
+ *  MessageQCopy_sendNoKick; pending kicks are flushed when the Swi
+ *  finishes. fxn must not block. Local sends bypass the hook.
+ *
+ *  @param[in]  handle      MessageQCopy handle.
+ *  @param[in]  fxn         Hook function, or NULL to remove it.
+ *  @param[in]  arg         Passed to fxn.
+ */
+Void MessageQCopy_setRecvFxn(MessageQCopy_Handle handle,
+                             MessageQCopy_RecvFxn fxn, UArg arg);
+
 #if defined (__cplusplus)
 }
 #endif /* defined (__cplusplus) */
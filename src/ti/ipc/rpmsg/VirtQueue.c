@@ -66,9 +66,19 @@
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/hal/Cache.h>
 
-#include <ti/ipc/rpmsg/InterruptM3.h>
 #include <ti/ipc/rpmsg/VirtQueue.h>
+
+/* The DSP (Tesla) and Ducati cores use different mailbox drivers: */
+#if defined(xdc_target__isaCompatible_64P)
+#include <ti/ipc/rpmsg/InterruptDsp.h>
+#define Interrupt_intRegister   InterruptDsp_intRegister
+#define Interrupt_intSend       InterruptDsp_intSend
+#else
+#include <ti/ipc/rpmsg/InterruptM3.h>
 #include <ti/pm/IpcPower.h>
+#define Interrupt_intRegister   InterruptM3_intRegister
+#define Interrupt_intSend       InterruptM3_intSend
+#endif
 
 #include <ti/ipc/MultiProc.h>
 
@@ -77,7 +87,7 @@
 #include "virtio_ring.h"
 
 /* Used for defining the size of the virtqueue registry */
-#define NUM_QUEUES                      5
+#define NUM_QUEUES                      6
 
 /* Predefined device addresses */
 #define IPU_MEM_VRING0          0xA0000000
@@ -85,6 +95,32 @@
 #define IPU_MEM_VRING2          0xA0008000
 #define IPU_MEM_VRING3          0xA000c000
 
+/*
+ * Physical base of the IPC carveout, as programmed by the host from the
+ * core's resource table: IPC_PA in ti/resources/rsc_table.h for the IPU,
+ * and in ti/resources/rsc_table_dsp.h for the DSP.  The DSP uses VRING0/1
+ * of its own IPC carveout, at the same device addresses as the IPU.
+ */
+#if defined(xdc_target__isaCompatible_64P)
+#define IPC_MEM_PA              0xA9100000
+#else
+#define IPC_MEM_PA              0xA9000000
+#endif
+
+/*
+ * Direct SysM3 <-> AppM3 vrings and their buffers, placed in the unused
+ * tail of the IPU_MEM_IPC carveout (past the host buffers at BUFS1_DA).
+ * The sending core plays the virtio "host" role on its outbound vring.
+ */
+#define IPU_MEM_VRING4          0xA00C0000  /* SysM3 -> AppM3 */
+#define IPU_MEM_VRING5          0xA00C4000  /* AppM3 -> SysM3 */
+#define IPU_MEM_PEERBUFS4       0xA00C8000
+#define IPU_MEM_PEERBUFS5       0xA00D8000
+#define IPU_MEM_PEERREADY       0xA00E8000  /* one ready word per vring */
+
+#define PEER_NUM_BUFS           128
+#define PEER_READY              0x52454459  /* "REDY" */
+
 /*
  * Sizes of the virtqueues (expressed in number of buffers supported,
  * and must be power of two)
@@ -153,6 +189,8 @@ enum {
 #define ID_A9_TO_SYSM3      1
 #define ID_APPM3_TO_A9      2
 #define ID_A9_TO_APPM3      3
+#define ID_SYSM3_TO_APPM3   4
+#define ID_APPM3_TO_SYSM3   5
 
 typedef struct VirtQueue_Object {
     /* Id for this VirtQueue_Object */
@@ -175,6 +213,16 @@ typedef struct VirtQueue_Object {
 
     /* Will eventually be used to kick remote processor */
     UInt16                  procId;
+
+    /* Peer vrings only: producer's "ring initialized" word, else NULL */
+    volatile UInt32 *       ready;
+
+    /* Peer vrings only: TRUE if we are the sending ("host") side */
+    Bool                    producer;
+
+    /* Peer producer only: buffers not yet handed out from bufBase */
+    UInt16                  num_fresh;
+    Char *                  bufBase;
 } VirtQueue_Object;
 
 static UInt numQueues = 0;
@@ -192,7 +240,7 @@ static inline Void * mapPAtoVA(UInt pa)
 
 static inline UInt mapVAtoPA(Void * va)
 {
-    return ((UInt)va & 0x000fffffU) | 0xa9000000U;
+    return ((UInt)va & 0x000fffffU) | IPC_MEM_PA;
 }
 
 /*!
@@ -200,8 +248,16 @@ static inline UInt mapVAtoPA(Void * va)
  */
 Void VirtQueue_kick(VirtQueue_Handle vq)
 {
+    /* The consumer of a peer vring asks not to be notified while draining */
+    if (vq->producer) {
+        if (vq->vring.used->flags & VRING_USED_F_NO_NOTIFY) {
+            Log_print0(Diags_USER1,
+                "VirtQueue_kick: no kick because of VRING_USED_F_NO_NOTIFY\n");
+            return;
+        }
+    }
     /* For now, simply interrupt remote processor */
-    if (vq->vring.avail->flags & VRING_AVAIL_F_NO_INTERRUPT) {
+    else if (vq->vring.avail->flags & VRING_AVAIL_F_NO_INTERRUPT) {
         Log_print0(Diags_USER1,
                 "VirtQueue_kick: no kick because of VRING_AVAIL_F_NO_INTERRUPT\n");
         return;
@@ -210,7 +266,7 @@ Void VirtQueue_kick(VirtQueue_Handle vq)
     Log_print2(Diags_USER1,
             "VirtQueue_kick: Sending interrupt to proc %d with payload 0x%x\n",
             (IArg)vq->procId, (IArg)vq->id);
-    InterruptM3_intSend(vq->procId, vq->id);
+    Interrupt_intSend(vq->procId, vq->id);
 }
 
 /*!
@@ -251,10 +307,14 @@ Int VirtQueue_addAvailBuf(VirtQueue_Object *vq, Void *buf)
 
     vq->num_free--;
 
-    avail =  vq->vring.avail->idx++ % vq->vring.num;
+    avail = vq->vring.avail->idx % vq->vring.num;
 
     vq->vring.desc[avail].addr = mapVAtoPA(buf);
     vq->vring.desc[avail].len = RP_MSG_BUF_SIZE;
+    vq->vring.avail->ring[avail] = avail;
+
+    /* Publish the descriptor only once it is filled in */
+    vq->vring.avail->idx++;
 
     return (vq->num_free);
 }
@@ -274,6 +334,7 @@ Void *VirtQueue_getUsedBuf(VirtQueue_Object *vq)
 
     head = vq->vring.used->ring[vq->last_used_idx % vq->vring.num].id;
     vq->last_used_idx++;
+    vq->num_free++;
 
     buf = mapPAtoVA(vq->vring.desc[head].addr);
 
@@ -292,6 +353,11 @@ Int16 VirtQueue_getAvailBuf(VirtQueue_Handle vq, Void **buf)
         vq->last_avail_idx, vq->vring.avail->idx, vq->vring.num,
         (IArg)&vq->vring.avail, (IArg)vq->vring.avail);
 
+    /* Peer vring not yet initialized by the sending core? */
+    if (vq->ready && (*vq->ready != PEER_READY)) {
+        return -1;
+    }
+
     /* There's nothing available? */
     if (vq->last_avail_idx == vq->vring.avail->idx) {
         /* We need to know about added buffers */
@@ -345,13 +411,14 @@ Void VirtQueue_isr(UArg msg)
 
     Log_print1(Diags_USER1, "VirtQueue_isr received msg = 0x%x\n", msg);
 
-    if (MultiProc_self() == sysm3ProcId) {
+    /* SysM3 and the DSP each receive host control messages directly */
+    if (MultiProc_self() == sysm3ProcId || MultiProc_self() == dspProcId) {
         switch(msg) {
             case (UInt)RP_MSG_MBOX_READY:
                 return;
 
             case (UInt)RP_MBOX_ECHO_REQUEST:
-                InterruptM3_intSend(hostProcId, (UInt)(RP_MBOX_ECHO_REPLY));
+                Interrupt_intSend(hostProcId, (UInt)(RP_MBOX_ECHO_REPLY));
                 return;
 
             case (UInt)RP_MBOX_ABORT_REQUEST:
@@ -366,11 +433,13 @@ Void VirtQueue_isr(UArg msg)
                 Cache_wbAll();
                 return;
 
+#if !defined(xdc_target__isaCompatible_64P)
             case (UInt)RP_MSG_HIBERNATION:
                 /* Notify Core1 */
                 InterruptM3_intSend(appm3ProcId, (UInt)(RP_MSG_HIBERNATION));
                 IpcPower_suspend();
                 return;
+#endif
 
             default:
                 /*
@@ -380,15 +449,22 @@ Void VirtQueue_isr(UArg msg)
                 break;
         }
     }
+#if !defined(xdc_target__isaCompatible_64P)
     else if (msg & 0xFFFF0000) {
         if (msg == (UInt)RP_MSG_HIBERNATION) {
             IpcPower_suspend();
         }
         return;
     }
+#endif
+
+    /* Ignore any other control message, or an id we have no queue for */
+    if (msg >= NUM_QUEUES) {
+        return;
+    }
 
     if (MultiProc_self() == sysm3ProcId && (msg == ID_A9_TO_APPM3 || msg == ID_APPM3_TO_A9)) {
-        InterruptM3_intSend(appm3ProcId, (UInt)msg);
+        Interrupt_intSend(appm3ProcId, (UInt)msg);
     }
     else {
         vq = queueRegistry[msg];
@@ -420,6 +496,12 @@ VirtQueue_Object *VirtQueue_create(VirtQueue_callback callback,
     vq->id = numQueues++;
     vq->procId = remoteProcId;
     vq->last_avail_idx = 0;
+    vq->last_used_idx = 0;
+    vq->num_free = RP_MSG_NUM_BUFS;
+    vq->ready = NULL;
+    vq->producer = FALSE;
+    vq->num_fresh = 0;
+    vq->bufBase = NULL;
 
     if (MultiProc_self() == appm3ProcId) {
         vq->id += 2;
@@ -459,6 +541,80 @@ VirtQueue_Object *VirtQueue_create(VirtQueue_callback callback,
     return (vq);
 }
 
+/*!
+ * ======== VirtQueue_createPeer ========
+ */
+VirtQueue_Object *VirtQueue_createPeer(VirtQueue_callback callback,
+        UInt16 peerProcId, Bool toPeer)
+{
+    VirtQueue_Object *vq;
+    Bool sysm3ToAppm3;
+    Error_Block eb;
+
+    /* Only the two Ducati cores share the IPU_MEM_IPC carveout */
+    if (!((MultiProc_self() == sysm3ProcId && peerProcId == appm3ProcId) ||
+          (MultiProc_self() == appm3ProcId && peerProcId == sysm3ProcId))) {
+        return (NULL);
+    }
+
+    Error_init(&eb);
+
+    vq = Memory_alloc(NULL, sizeof(VirtQueue_Object), 0, &eb);
+    if (!vq) {
+        return (NULL);
+    }
+
+    sysm3ToAppm3 = (MultiProc_self() == sysm3ProcId) ? toPeer : !toPeer;
+
+    vq->callback = callback;
+    vq->id = sysm3ToAppm3 ? ID_SYSM3_TO_APPM3 : ID_APPM3_TO_SYSM3;
+    vq->procId = peerProcId;
+    vq->last_avail_idx = 0;
+    vq->last_used_idx = 0;
+    vq->num_free = PEER_NUM_BUFS;
+    vq->producer = toPeer;
+    vq->num_fresh = 0;
+    vq->bufBase = (Char *)(sysm3ToAppm3 ? IPU_MEM_PEERBUFS4 :
+                                          IPU_MEM_PEERBUFS5);
+    vq->ready = (volatile UInt32 *)IPU_MEM_PEERREADY +
+                (vq->id - ID_SYSM3_TO_APPM3);
+
+    vring_init(&(vq->vring), PEER_NUM_BUFS,
+               (Void *)(sysm3ToAppm3 ? IPU_MEM_VRING4 : IPU_MEM_VRING5),
+               RP_MSG_VRING_ALIGN);
+
+    Log_print2(Diags_USER1, "peer vring: %d 0x%x\n", vq->id,
+               (IArg)vq->vring.desc);
+
+    /* The sending side owns its vring: reset it, then mark it usable */
+    if (toPeer) {
+        *vq->ready = 0;
+        memset(vq->vring.desc, 0, vring_size(PEER_NUM_BUFS,
+                                             RP_MSG_VRING_ALIGN));
+        *vq->ready = PEER_READY;
+    }
+
+    queueRegistry[vq->id] = vq;
+
+    return (vq);
+}
+
+/*!
+ * ======== VirtQueue_getPeerBuf ========
+ */
+Void *VirtQueue_getPeerBuf(VirtQueue_Handle vq)
+{
+    Void *buf;
+
+    /* Reclaim a buffer the peer has consumed, else use a fresh one */
+    buf = VirtQueue_getUsedBuf(vq);
+    if ((buf == NULL) && (vq->num_fresh < vq->vring.num)) {
+        buf = vq->bufBase + (vq->num_fresh++ * RP_MSG_BUF_SIZE);
+    }
+
+    return (buf);
+}
+
 /*!
  * ======== VirtQueue_startup ========
  */
@@ -469,19 +625,20 @@ Void VirtQueue_startup()
     sysm3ProcId     = MultiProc_getId("CORE0");
     appm3ProcId     = MultiProc_getId("CORE1");
 
+#if !defined(xdc_target__isaCompatible_64P)
     /* Initilize the IpcPower module */
     IpcPower_init();
+#endif
 
     /*
-     *  DSP can be used to prototype communications with CORE0 instead of
-     *  HOST
+     *  The DSP owns its own vring pair with the HOST, so every core simply
+     *  hooks VirtQueue_isr to its mailbox.
      */
-    if (MultiProc_self() == dspProcId) {
+    if (MultiProc_self() == dspProcId ||
+        MultiProc_self() == sysm3ProcId ||
+        MultiProc_self() == appm3ProcId) {
+        Interrupt_intRegister(VirtQueue_isr);
     }
-    else if (MultiProc_self() == sysm3ProcId)
-        InterruptM3_intRegister(VirtQueue_isr);
-    else if (MultiProc_self() == appm3ProcId)
-        InterruptM3_intRegister(VirtQueue_isr);
 }
 
 /*!
@@ -490,7 +647,7 @@ Void VirtQueue_startup()
 Void postCrashToMailbox(Error_Block * eb)
 {
     Error_print(eb);
-    InterruptM3_intSend(0, (UInt)RP_MSG_MBOX_CRASH);
+    Interrupt_intSend(hostProcId, (UInt)RP_MSG_MBOX_CRASH);
 }
 
 
@@ -117,6 +117,36 @@ typedef Void (*VirtQueue_callback)(VirtQueue_Handle);
 VirtQueue_Handle VirtQueue_create(VirtQueue_callback callback, UInt16 procId);
 
 
+/*!
+ *  @brief      Create one direction of a direct vring to the sibling M3 core.
+ *
+ *  The vrings live in shared IPU memory, and are signalled with
+ *  InterruptM3 doorbells, so traffic between SysM3 and AppM3 does not
+ *  involve the host.  The sending side (toPeer == TRUE) plays the "host"
+ *  role: it fills buffers from VirtQueue_getPeerBuf(), publishes them with
+ *  VirtQueue_addAvailBuf() and kicks.  The receiving side uses the usual
+ *  slave calls, VirtQueue_getAvailBuf() and VirtQueue_addUsedBuf(), and need
+ *  not kick back: consumed buffers are reclaimed lazily by the sender.
+ *
+ *  @param[in]  callback    the clients callback function.
+ *  @param[in]  peerProcId  Processor ID of the sibling M3 core.
+ *  @param[in]  toPeer      TRUE for the outbound vring, FALSE for inbound.
+ *
+ *  @Returns    Handle to the VirtQueue, or NULL if this core has no peer.
+ */
+VirtQueue_Handle VirtQueue_createPeer(VirtQueue_callback callback,
+                                      UInt16 peerProcId, Bool toPeer);
+
+/*!
+ *  @brief      Get an empty buffer to send on an outbound peer vring.
+ *
+ *  @param[in]  vq        the VirtQueue, from VirtQueue_createPeer(toPeer).
+ *
+ *  @return     Returns a buffer of RP_MSG_BUF_SIZE bytes, or NULL if all
+ *              buffers are still in flight.
+ */
+Void *VirtQueue_getPeerBuf(VirtQueue_Handle vq);
+
 /*!
  *  @brief      Notify other processor of new buffers in the queue.
  *
@@ -152,6 +152,10 @@ struct resource {
 extern char * xdc_runtime_SysMin_Module_State_0_outbuf__A;
 #define TRACEBUFADDR (u32)&xdc_runtime_SysMin_Module_State_0_outbuf__A
 
+/* binary event log ring, decoded on the host by readevlog */
+#include <ti/ipc/rpmsg/EventLog.h>
+#define EVENTLOGADDR (u32)&EventLog_buf
+
 #pragma DATA_SECTION(resources, ".resource_table")
 #pragma DATA_ALIGN(resources, 4096)
 struct resource resources[] = {
@@ -171,6 +175,8 @@ struct resource resources[] = {
      * Misc entries
      */
     { TYPE_TRACE, 0, TRACEBUFADDR,0,0,0, 0x8000, 0,0,0,0,0,"trace:sysm3"},
+    { TYPE_TRACE, 1, EVENTLOGADDR,0,0,0, sizeof(EventLog_Buf),
+       0,0,0,0,0,"evlog:sysm3"},
     /*
      * IOMMU configuration entries
      */
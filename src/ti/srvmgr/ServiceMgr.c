@@ -54,6 +54,7 @@
 
 
 #include <ti/ipc/rpmsg/MessageQCopy.h>
+#include <ti/ipc/rpmsg/EventLog.h>
 #include "rpmsg_omx.h"
 #include "NameMap.h"
 #include "ServiceMgr.h"
@@ -71,6 +72,9 @@ struct ServiceDef {
     Char                   name[MAX_NAMELEN];
     RcmServer_Params       rcmServerParams;
     Bool                   taken;
+    UInt                   poolSize;   /* idle instances to keep ready */
+    UInt                   numIdle;    /* idle instances in pool */
+    RcmServer_Handle       idle[ServiceMgr_MAXPOOLSIZE];
 };
 
 struct ServiceDef serviceDefs[ServiceMgr_NUMSERVICETYPES];
@@ -78,12 +82,26 @@ struct ServiceDef serviceDefs[ServiceMgr_NUMSERVICETYPES];
 struct Tuple {
     UInt32   key;
     UInt32   value;
+    UInt32   service;   /* index into serviceDefs */
 };
 struct Tuple Tuples[MAX_TUPLES];
 
 
 void serviceMgrTaskFxn(UArg arg0, UArg arg1);
 
+static struct ServiceDef * findService(Char * name)
+{
+    UInt i;
+
+    for (i = 0; i < ServiceMgr_NUMSERVICETYPES; i++) {
+       if (serviceDefs[i].taken && !strcmp(name, serviceDefs[i].name)) {
+           return &serviceDefs[i];
+       }
+    }
+
+    return NULL;
+}
+
 Void ServiceMgr_init()
 {
     Task_Params params;
@@ -123,6 +141,8 @@ Bool ServiceMgr_register(String name, RcmServer_Params  *rcmServerParams)
                 sd = &serviceDefs[i];
                 strcpy(sd->name, name);
                 sd->rcmServerParams = *rcmServerParams;
+                sd->poolSize = ServiceMgr_DEFPOOLSIZE;
+                sd->numIdle = 0;
                 sd->taken = TRUE;
                 found = TRUE;
                 break;
@@ -133,6 +153,24 @@ Bool ServiceMgr_register(String name, RcmServer_Params  *rcmServerParams)
     return(found);
 }
 
+Bool ServiceMgr_setPoolSize(String name, UInt poolSize)
+{
+    struct ServiceDef *sd;
+
+    sd = findService(name);
+
+    if ((sd == NULL) || (poolSize > ServiceMgr_MAXPOOLSIZE)) {
+        System_printf("ServiceMgr_setPoolSize: bad service %s or size %d\n",
+                       name, poolSize);
+        return FALSE;
+    }
+
+    /* Shrinking takes effect as instances are released: */
+    sd->poolSize = poolSize;
+
+    return TRUE;
+}
+
 Void ServiceMgr_send(Service_Handle srvc, Ptr data, UInt16 len)
 {
     UInt32 local;
@@ -145,6 +183,11 @@ Void ServiceMgr_send(Service_Handle srvc, Ptr data, UInt16 len)
     dstProc = RcmServer_getRemoteProc(srvc);
     local   = RcmServer_getLocalAddress(srvc);
 
+    /* No client yet, or it went away and the service was reset: */
+    if (remote == RcmClient_INVALIDADDR) {
+        return;
+    }
+
     /* Set special rpmsg_omx header so Linux side can strip it off: */
     hdr->type    = OMX_RAW_MSG;
     hdr->len     = len;
@@ -157,7 +200,7 @@ Void ServiceMgr_send(Service_Handle srvc, Ptr data, UInt16 len)
 
 /* Tuple store/retrieve fxns:  */
 
-static Bool storeTuple(UInt32 key, UInt32 value)
+static Bool storeTuple(UInt32 key, UInt32 value, UInt32 service)
 {
     UInt              i;
     Bool              stored = FALSE;
@@ -171,6 +214,7 @@ static Bool storeTuple(UInt32 key, UInt32 value)
            if (Tuples[i].key == FREE_TUPLE_KEY) {
                Tuples[i].key = key;
                Tuples[i].value = value;
+               Tuples[i].service = service;
                stored = TRUE;
                break;
            }
@@ -180,7 +224,7 @@ static Bool storeTuple(UInt32 key, UInt32 value)
     return(stored);
 }
 
-static Bool removeTuple(UInt32 key, UInt32 * value)
+static Bool removeTuple(UInt32 key, UInt32 * value, UInt32 * service)
 {
     UInt              i;
     Bool              found = FALSE;
@@ -190,6 +234,7 @@ static Bool removeTuple(UInt32 key, UInt32 * value)
        if (Tuples[i].key == key) {
            found = TRUE;
            *value = Tuples[i].value;
+           *service = Tuples[i].service;
            /* and free it... */
            Tuples[i].value = 0;
            Tuples[i].key = FREE_TUPLE_KEY;
@@ -200,24 +245,11 @@ static Bool removeTuple(UInt32 key, UInt32 * value)
     return(found);
 }
 
-static UInt32 createService(Char * name, UInt32 * endpt)
-{
-    Int i;
-    Int status = 0;
-    struct ServiceDef *sd;
-    RcmServer_Handle  rcmSrvHandle;
-
-    for (i = 0; i < ServiceMgr_NUMSERVICETYPES; i++) {
-       if (!strcmp(name, serviceDefs[i].name)) {
-           sd = &serviceDefs[i];
-           break;
-       }
-    }
+/* Idle instance pool, only touched from the ServiceMgr task: */
 
-    if (i >= ServiceMgr_NUMSERVICETYPES) {
-       System_printf("createService: unrecognized service name: %s\n", name);
-       return OMX_NOTSUPP;
-    }
+static Int newInstance(struct ServiceDef * sd, RcmServer_Handle * handle)
+{
+    Int status;
 
     /* Create the RcmServer instance. */
 #if 0
@@ -229,11 +261,57 @@ static UInt32 createService(Char * name, UInt32 * endpt)
                   sd->rcmServerParams.osPriority,
                   sd->rcmServerParams.fxns.length);
 #endif
-    status = RcmServer_create(sd->name, &sd->rcmServerParams, &rcmSrvHandle);
+    status = RcmServer_create(sd->name, &sd->rcmServerParams, handle);
 
     if (status < 0) {
         System_printf("createService: RcmServer_create() returned error %d\n",
                        status);
+        return status;
+    }
+
+    /* start the server, it idles on its endpoint until a client binds */
+    RcmServer_start(*handle);
+
+    return status;
+}
+
+static Void fillPools()
+{
+    UInt i;
+    struct ServiceDef *sd;
+
+    for (i = 0; i < ServiceMgr_NUMSERVICETYPES; i++) {
+        sd = &serviceDefs[i];
+
+        while (sd->taken && (sd->numIdle < sd->poolSize)) {
+            if (newInstance(sd, &sd->idle[sd->numIdle]) < 0) {
+                break;
+            }
+            sd->numIdle++;
+        }
+    }
+}
+
+static UInt32 createService(Char * name, UInt32 * endpt)
+{
+    Int i;
+    struct ServiceDef *sd;
+    RcmServer_Handle  rcmSrvHandle;
+
+    sd = findService(name);
+
+    if (sd == NULL) {
+       System_printf("createService: unrecognized service name: %s\n", name);
+       return OMX_NOTSUPP;
+    }
+
+    i = sd - serviceDefs;
+
+    /* Bind a pre-created instance if there is one, else create it now: */
+    if (sd->numIdle > 0) {
+        rcmSrvHandle = sd->idle[--sd->numIdle];
+    }
+    else if (newInstance(sd, &rcmSrvHandle) < 0) {
         return OMX_FAIL;
     }
 
@@ -241,16 +319,13 @@ static UInt32 createService(Char * name, UInt32 * endpt)
     *endpt = RcmServer_getLocalAddress(rcmSrvHandle);
 
     /* Store Server's endpoint with handle so we can cleanup on disconnect: */
-    if (!storeTuple(*endpt, (UInt32)rcmSrvHandle))  {
+    if (!storeTuple(*endpt, (UInt32)rcmSrvHandle, i))  {
         System_printf("createService: Limit reached on max instances!\n");
         RcmServer_delete(&rcmSrvHandle);
         return OMX_FAIL;
     }
 
-    /* start the server */
-    RcmServer_start(rcmSrvHandle);
-
-    System_printf("createService: new OMX Service at endpoint: %d\n", *endpt);
+    EventLog_write2(EventLog_SRVMGR_CREATE, *endpt, i);
 
     return OMX_SUCCESS;
 }
@@ -259,14 +334,27 @@ static UInt32 createService(Char * name, UInt32 * endpt)
 static UInt32 deleteService(UInt32 addr)
 {
     Int status = 0;
+    UInt32 service;
+    struct ServiceDef *sd;
     RcmServer_Handle  rcmSrvHandle;
 
-    if (!removeTuple(addr, (UInt32 *)&rcmSrvHandle))  {
+    if (!removeTuple(addr, (UInt32 *)&rcmSrvHandle, &service))  {
        System_printf("deleteService: could not find service instance at"
                      " address: 0x%x\n", addr);
        return OMX_FAIL;
     }
 
+    /* Return the instance to its pool if there is room, keeping the
+     * server thread and endpoint for the next client. One which cannot be
+     * reset to its created state (still busy) is destroyed instead:
+     */
+    sd = &serviceDefs[service];
+    if ((sd->numIdle < sd->poolSize) && (RcmServer_reset(rcmSrvHandle) >= 0)) {
+        sd->idle[sd->numIdle++] = rcmSrvHandle;
+        EventLog_write1(EventLog_SRVMGR_DELETE, addr);
+        return OMX_SUCCESS;
+    }
+
     /* Destroy the RcmServer instance. */
     status = RcmServer_delete(&rcmSrvHandle);
     if (status < 0) {
@@ -275,7 +363,7 @@ static UInt32 deleteService(UInt32 addr)
         return OMX_FAIL;
     }
 
-    System_printf("deleteService: removed RcmServer at endpoint: %d\n", addr);
+    EventLog_write1(EventLog_SRVMGR_DELETE, addr);
 
     return OMX_SUCCESS;
 }
@@ -296,29 +384,27 @@ void serviceMgrTaskFxn(UArg arg0, UArg arg1)
     UInt32 newAddr = 0;
 
 
-#ifdef BIOS_ONLY_TEST
-    dstProc = MultiProc_self();
-#else
-    dstProc = MultiProc_getId("HOST");
-#endif
-
     msgq = MessageQCopy_create(SERVICE_MGR_PORT, &local);
 
     System_printf("serviceMgr: started on port: %d\n", SERVICE_MGR_PORT);
+    EventLog_write1(EventLog_SRVMGR_START, SERVICE_MGR_PORT);
+
+    /* Get idle service instances ready before announcing ourselves: */
+    fillPools();
 
     NameMap_register("rpmsg-omx", SERVICE_MGR_PORT);
 
     while (1) {
-       MessageQCopy_recv(msgq, (Ptr)msg, &len, &remote, MessageQCopy_FOREVER);
-       System_printf("serviceMgr: received msg type: %d from addr: %d\n",
-                      hdr->type, remote);
+       /* Note the requester's processor, replies go back to it: */
+       MessageQCopy_recvFrom(msgq, (Ptr)msg, &len, &dstProc, &remote,
+                             MessageQCopy_FOREVER);
+       EventLog_write3(EventLog_SRVMGR_RECV, hdr->type, remote, len);
        switch (hdr->type) {
            case OMX_CONN_REQ:
             /* This is a request to create a new service, and return
              * it's connection endpoint.
              */
-            System_printf("serviceMgr: CONN_REQ: len: %d, name: %s\n",
-                 hdr->len, req->name);
+            EventLog_write1(EventLog_SRVMGR_CONNECT, hdr->len);
 
             rsp->status = createService(req->name, &newAddr);
 
@@ -330,8 +416,7 @@ void serviceMgrTaskFxn(UArg arg0, UArg arg1)
 
            case OMX_DISC_REQ:
             /* Destroy the service instance at given service addr: */
-            System_printf("serviceMgr: OMX_DISCONNECT: len %d, addr: %d\n",
-                 hdr->len, disc_req->addr);
+            EventLog_write2(EventLog_SRVMGR_DISC, hdr->len, disc_req->addr);
 
             disc_rsp->status = deleteService(disc_req->addr);
 
@@ -350,9 +435,10 @@ void serviceMgrTaskFxn(UArg arg0, UArg arg1)
             break;
        }
 
-       System_printf("serviceMgr: Replying with msg type: %d to addr: %d "
-                      " from: %d\n",
-                      hdr->type, remote, local);
+       EventLog_write3(EventLog_SRVMGR_REPLY, hdr->type, remote, local);
        MessageQCopy_send(dstProc, remote, local, msg, len);
+
+       /* Replace any pooled instance handed out, off the connect path: */
+       fillPools();
     }
 }
@@ -43,6 +43,10 @@
 /* Max number of known service types: */
 #define ServiceMgr_NUMSERVICETYPES         16
 
+/* Idle service instances kept ready per service type: */
+#define ServiceMgr_DEFPOOLSIZE             1
+#define ServiceMgr_MAXPOOLSIZE             4
+
 /*!
  *  @brief Service instance object handle
  */
@@ -79,6 +83,27 @@ Void ServiceMgr_init();
  */
 Bool ServiceMgr_register(String name, RcmServer_Params  *rcmServerParams);
 
+/*
+ *  ======== ServiceMgr_setPoolSize ========
+ */
+/*!
+ *  @brief Set the number of idle instances kept ready for a service.
+ *
+ *  The ServiceMgr creates and starts this many RcmServer instances of the
+ *  service ahead of time, so a connect request only binds one to the
+ *  client. On disconnect, the instance goes back to the pool while there
+ *  is room; otherwise it is deleted. A size of 0 creates every instance
+ *  on connect. The default is ServiceMgr_DEFPOOLSIZE.
+ *
+ *  Call after ServiceMgr_register and before BIOS_start.
+ *
+ *  @param[in] name      The name the service was registered with.
+ *  @param[in] poolSize  Idle instance count, at most ServiceMgr_MAXPOOLSIZE.
+ *
+ *  @sa ServiceMgr_register
+ */
+Bool ServiceMgr_setPoolSize(String name, UInt poolSize);
+
 
 /*
  *  ======== ServiceMgr_send ========
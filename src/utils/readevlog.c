@@ -0,0 +1,204 @@
+/*
+ *  Copyright (c) 2011, Texas Instruments Incorporated
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *  *  Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  *  Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  *  Neither the name of Texas Instruments Incorporated nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ *  ======== readevlog.c ========
+ *
+ *  Decode the binary event log of a BIOS core into text. The input is
+ *  a copy of the "evlog" trace resource, e.g. read from the remoteproc
+ *  debugfs trace file of that core.
+ *
+ *  The ring layout and event ids must match ti/ipc/rpmsg/EventLog.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned int u32;
+
+#define EVLOG_MAGIC     0x474C5645
+
+struct evlog_rec {
+    u32 seq;
+    u32 time;
+    u32 event;
+    u32 arg[4];
+    u32 reserved;
+};
+
+struct evlog_buf {
+    u32 magic;
+    u32 num_recs;
+    u32 head;
+    u32 freq;
+    struct evlog_rec rec[1];
+};
+
+struct evlog_fmt {
+    u32 event;
+    char * fmt;
+};
+
+static struct evlog_fmt formats[] = {
+    { 0x0100, "rcm dispatch: pool:%d job:%d fxn:0x%x len:%d" },
+    { 0x0200, "serviceMgr: started on port: %d" },
+    { 0x0201, "serviceMgr: received msg type: %d from addr: %d len: %d" },
+    { 0x0202, "serviceMgr: CONN_REQ: len: %d" },
+    { 0x0203, "serviceMgr: OMX_DISCONNECT: len: %d addr: %d" },
+    { 0x0204, "serviceMgr: replying with msg type: %d to addr: %d from: %d" },
+    { 0x0205, "createService: new OMX service at endpoint: %d type: %d" },
+    { 0x0206, "deleteService: removed RcmServer at endpoint: %d" },
+};
+
+#define NUM_FORMATS (sizeof(formats) / sizeof(formats[0]))
+
+static int dump_log(void * data, int size);
+
+/*
+ *  ======== main ========
+ */
+int main(int argc, char * argv[])
+{
+    FILE * fp;
+    char * filename;
+    char * data = NULL;
+    char * tmp;
+    int size = 0;
+    int n;
+    int status;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s filename\n", argv[0]);
+        exit(1);
+    }
+
+    filename = argv[1];
+    if ((fp = fopen(filename, "rb")) == NULL) {
+        fprintf(stderr, "%s: could not open: %s\n", argv[0], filename);
+        exit(2);
+    }
+
+    /* debugfs files report no size, so read until end of file */
+    do {
+        if ((tmp = realloc(data, size + 4096)) == NULL) {
+            fprintf(stderr, "%s: out of memory reading: %s\n", argv[0],
+                    filename);
+            free(data);
+            fclose(fp);
+            exit(3);
+        }
+        data = tmp;
+        n = fread(data + size, 1, 4096, fp);
+        size += n;
+    } while (n > 0);
+    fclose(fp);
+
+    status = dump_log(data, size);
+
+    free(data);
+
+    return status;
+}
+
+/*
+ *  ======== find_format ========
+ */
+static char * find_format(u32 event)
+{
+    int i;
+
+    for (i = 0; i < NUM_FORMATS; i++) {
+        if (formats[i].event == event) {
+            return formats[i].fmt;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ *  ======== dump_log ========
+ *
+ *  Print the records still in the ring, oldest first. A record is kept
+ *  only if its sequence number is the one expected for its slot; this
+ *  drops records that were being written, or overwritten, at the time
+ *  the ring was copied.
+ */
+static int dump_log(void * data, int size)
+{
+    struct evlog_buf * buf = data;
+    struct evlog_rec * rec;
+    u32 first;
+    u32 seq;
+    double usec;
+    char * fmt;
+
+    if (size < sizeof(*buf) - sizeof(buf->rec) ||
+        buf->magic != EVLOG_MAGIC) {
+        fprintf(stderr, "not an event log\n");
+        return 1;
+    }
+
+    /* divide rather than multiply, a corrupt num_recs must not wrap */
+    if (buf->num_recs == 0 || (buf->num_recs & (buf->num_recs - 1)) ||
+        buf->num_recs > (size - (sizeof(*buf) - sizeof(buf->rec))) /
+        sizeof(*rec)) {
+        fprintf(stderr, "bad event log size: %u records\n", buf->num_recs);
+        return 1;
+    }
+
+    printf("%u events logged, timestamp freq %u Hz\n", buf->head, buf->freq);
+
+    first = (buf->head > buf->num_recs) ? buf->head - buf->num_recs + 1 : 1;
+
+    for (seq = first; seq != buf->head + 1; seq++) {
+        rec = &buf->rec[seq & (buf->num_recs - 1)];
+
+        if (rec->seq != seq) {
+            continue;
+        }
+
+        usec = buf->freq ? (double)rec->time * 1000000.0 / buf->freq : 0;
+        printf("[%10u] %12.3f us: ", rec->seq, usec);
+
+        if ((fmt = find_format(rec->event)) != NULL) {
+            printf(fmt, rec->arg[0], rec->arg[1], rec->arg[2], rec->arg[3]);
+        }
+        else {
+            printf("event 0x%x: 0x%x 0x%x 0x%x 0x%x", rec->event,
+                   rec->arg[0], rec->arg[1], rec->arg[2], rec->arg[3]);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}